@@ -24,53 +24,49 @@
  */
 
 #include "ast.hpp"
+#include "traversal.hpp"
 
 using namespace AST;
-using std::list;
 using std::string;
 
-Node::Node(int line, int column) : _line(line), _column(column) {}
+Node::Node(Type type, unsigned int offset) : _offset(offset), _type(type) {}
 
 Node::~Node(void) {}
 
-int Node::getLine(void) const {
-    return _line;
+void* Node::operator new(size_t size, NodeArena* arena) {
+    return arena->allocate(size);
 }
 
-int Node::getColumn(void) const {
-    return _column;
+void Node::operator delete(void* node, NodeArena* arena) {}
+
+void Node::operator delete(void* node) {}
+
+unsigned int Node::getOffset(void) const {
+    return _offset;
+}
+
+void Node::accept(IVisitor* visitor) throw(NodeError) {
+    Traversal<IVisitor> traversal;
+    traversal.run(this, visitor);
 }
 
 NProgram::NProgram(
     NStatementList* statements,
-    int line,
-    int column)
-        : Node(line, column), _statements(statements)
+    unsigned int offset)
+        : Node(PROGRAM, offset), _statements(statements)
 {}
 
-NProgram::~NProgram(void) {
-    delete _statements;
-}
+NProgram::~NProgram(void) {}
 
 NStatementList* NProgram::getStatementList(void) const {
     return _statements;
 }
 
-void NProgram::accept(IVisitor* visitor) throw(NodeError) {
-    visitor->preVisit(this);
-    visitor->visit(this);
-    _statements->accept(visitor);
-    visitor->postVisit(this);
-}
-
-NStatementList::NStatementList(int line, int column) : Node(line, column) {}
+NStatementList::NStatementList(unsigned int offset)
+        : Node(STATEMENT_LIST, offset)
+{}
 
-NStatementList::~NStatementList(void) {
-    list<NStatement*>::iterator it;
-    for (it = _statements.begin(); it != _statements.end(); it++) {
-        delete *it;
-    }
-}
+NStatementList::~NStatementList(void) {}
 
 void NStatementList::appendStatement(NStatement* node) {
     _statements.push_back(node);
@@ -81,58 +77,31 @@ NStatementList& NStatementList::operator<<(NStatement* node) {
     return *this;
 }
 
-list<NStatement*> NStatementList::getStatements(void) {
-    return _statements;
-}
-
-void NStatementList::accept(IVisitor* visitor) throw(NodeError) {
-    visitor->preVisit(this);
-    visitor->visit(this);
-    switch (visitor->getChildVisitOrder(this)) {
-        case IVisitor::NORMAL: {
-            list<NStatement*>::iterator it;
-            for (it = _statements.begin(); it != _statements.end(); it++) {
-                (*it)->accept(visitor);
-                if (it != --_statements.end()) {
-                    visitor->betweenChildren(this);
-                }
-            }
-            break;
-        }
-
-        case IVisitor::REVERSED: {
-            list<NStatement*>::reverse_iterator it;
-            for (it = _statements.rbegin(); it != _statements.rend(); it++) {
-                (*it)->accept(visitor);
-                if (it != --_statements.rend()) {
-                    visitor->betweenChildren(this);
-                }
-            }
-            break;
-        }
-
-        default:
-            throw NodeError("Unknown visit order");
+void NStatementList::appendStatements(NStatementList* other) {
+    if (_statements.empty()) {
+        _statements.swap(other->_statements);
+        return;
     }
-    visitor->postVisit(this);
+    _statements.insert(_statements.end(),
+                       other->_statements.begin(),
+                       other->_statements.end());
+    other->_statements.clear();
 }
 
-NStatement::NStatement(int line, int column) : Node(line, column) {}
+NStatement::NStatement(Type type, unsigned int offset)
+        : Node(type, offset)
+{}
 
 NStatement::~NStatement(void) {}
 
 NAssignment::NAssignment(
     NVariable* variable,
     NExpression* expr,
-    int line,
-    int column)
-        : NStatement(line, column), _variable(variable), _expr(expr)
+    unsigned int offset)
+        : NStatement(ASSIGNMENT, offset), _variable(variable), _expr(expr)
 {}
 
-NAssignment::~NAssignment(void) {
-    delete _variable;
-    delete _expr;
-}
+NAssignment::~NAssignment(void) {}
 
 NVariable* NAssignment::getVariable(void) const {
     return _variable;
@@ -142,32 +111,8 @@ NExpression* NAssignment::getExpression(void) const {
     return _expr;
 }
 
-void NAssignment::accept(IVisitor* visitor) throw(NodeError) {
-    visitor->preVisit(this);
-    visitor->visit(this);
-    switch (visitor->getChildVisitOrder(this)) {
-        case IVisitor::NORMAL: {
-            _variable->accept(visitor);
-            visitor->betweenChildren(this);
-            _expr->accept(visitor);
-            break;
-        }
-
-        case IVisitor::REVERSED: {
-            _expr->accept(visitor);
-            visitor->betweenChildren(this);
-            _variable->accept(visitor);
-            break;
-        }
-
-        default:
-            throw NodeError("Unknown visit order");
-    }
-    visitor->postVisit(this);
-}
-
-NPrint::NPrint(NExpression* expr, int line, int column)
-        : NStatement(line, column), _expr(expr)
+NPrint::NPrint(NExpression* expr, unsigned int offset)
+        : NStatement(PRINT, offset), _expr(expr)
 {}
 
 NPrint::~NPrint(void) {}
@@ -176,28 +121,20 @@ NExpression* NPrint::getExpression(void) const {
     return _expr;
 }
 
-void NPrint::accept(IVisitor* visitor) throw(NodeError) {
-    visitor->preVisit(this);
-    visitor->visit(this);
-    _expr->accept(visitor);
-    visitor->postVisit(this);
-}
-
-NExpression::NExpression(int line, int column) : Node(line, column) {}
+NExpression::NExpression(Type type, unsigned int offset)
+        : Node(type, offset)
+{}
 
 NExpression::~NExpression(void) {}
 
 NExpressionUnary::NExpressionUnary(
     ExpressionOperator op,
     NExpression* expr,
-    int line,
-    int column)
-        : NExpression(line, column), _op(op), _expr(expr)
+    unsigned int offset)
+        : NExpression(EXPRESSION_UNARY, offset), _op(op), _expr(expr)
 {}
 
-NExpressionUnary::~NExpressionUnary(void) {
-    delete _expr;
-}
+NExpressionUnary::~NExpressionUnary(void) {}
 
 NExpression* NExpressionUnary::getExpression(void) const {
     return _expr;
@@ -207,26 +144,15 @@ ExpressionOperator NExpressionUnary::getOperator(void) const {
     return _op;
 }
 
-void NExpressionUnary::accept(IVisitor* visitor) throw(NodeError) {
-    visitor->preVisit(this);
-    visitor->visit(this);
-    _expr->accept(visitor);
-    visitor->postVisit(this);
-}
-
 NExpressionBinary::NExpressionBinary(
     NExpression* lhs,
     ExpressionOperator op,
     NExpression* rhs,
-    int line,
-    int column)
-        : NExpression(line, column), _lhs(lhs), _op(op), _rhs(rhs)
+    unsigned int offset)
+        : NExpression(EXPRESSION_BINARY, offset), _lhs(lhs), _op(op), _rhs(rhs)
 {}
 
-NExpressionBinary::~NExpressionBinary(void) {
-    delete _lhs;
-    delete _rhs;
-}
+NExpressionBinary::~NExpressionBinary(void) {}
 
 NExpression* NExpressionBinary::getLhsExpression(void) const {
     return _lhs;
@@ -240,58 +166,30 @@ NExpression* NExpressionBinary::getRhsExpression(void) const {
     return _rhs;
 }
 
-void NExpressionBinary::accept(IVisitor* visitor) throw(NodeError) {
-    visitor->preVisit(this);
-    visitor->visit(this);
-    switch (visitor->getChildVisitOrder(this)) {
-        case IVisitor::NORMAL: {
-            _lhs->accept(visitor);
-            visitor->betweenChildren(this);
-            _rhs->accept(visitor);
-            break;
-        }
-
-        case IVisitor::REVERSED: {
-            _rhs->accept(visitor);
-            visitor->betweenChildren(this);
-            _lhs->accept(visitor);
-            break;
-        }
-
-        default:
-            throw NodeError("Unknown visit order");
-    }
-    visitor->postVisit(this);
-}
-
-NNumber::NNumber(const string& number, int line, int column)
-        : NExpression(line, column), _number(number) {}
+NNumber::NNumber(const TextSpan& number, unsigned int offset)
+        : NExpression(NUMBER, offset), _number(number) {}
 
 NNumber::~NNumber(void) {}
 
-string NNumber::getNumber(void) const {
+TextSpan NNumber::getNumber(void) const {
     return _number;
 }
 
-void NNumber::accept(IVisitor* visitor) throw(NodeError) {
-    visitor->preVisit(this);
-    visitor->visit(this);
-    visitor->postVisit(this);
-}
-
-NVariable::NVariable(const string& name, int line, int column)
-        : NExpression(line, column), _name(name) {}
+NVariable::NVariable(const TextSpan& name, unsigned int offset)
+        : NExpression(VARIABLE, offset), _name(name), _symbol(-1) {}
 
 NVariable::~NVariable(void) {}
 
-string NVariable::getName(void) const {
+TextSpan NVariable::getName(void) const {
     return _name;
 }
 
-void NVariable::accept(IVisitor* visitor) throw(NodeError) {
-    visitor->preVisit(this);
-    visitor->visit(this);
-    visitor->postVisit(this);
+int NVariable::getSymbol(void) const {
+    return _symbol;
+}
+
+void NVariable::setSymbol(int symbol) {
+    _symbol = symbol;
 }
 
 IVisitor::~IVisitor(void) {}
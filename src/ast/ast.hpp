@@ -31,9 +31,12 @@
  * @brief Defines the classes needed for the AST.
  */
 
+#include "node_arena.hpp"
+#include "text_span.hpp"
+#include <cstddef>
 #include <exception>
-#include <list>
 #include <string>
+#include <vector>
 
 /**
  * @brief Contains all classes and functions used for constructing an AST.
@@ -103,76 +106,143 @@ class NodeError : public std::exception {
  * \brief Abstract base class for the AST nodes.
  *
  * The Node class provides the methods that will be needed for all nodes in the
- * AST. These include line and column access methods, but also declares the \c
- * accept(IVisitor*) method that must be implemented by all deriving subclasses.
- * Each implementation of accept(IVisitor*) must work as follows:
+ * AST. These include the source location access method, but also the
+ * \c accept(IVisitor*) method, which visits a node and its descendants as
+ * follows:
  *     -# Invoke IVisitor::preVisit()
  *     -# Invoke IVisitor::visit()
- *     -# Invoke accept() on all child nodes
- *         - Between each accept() to the children,
+ *     -# Visit all child nodes in the same way
+ *         - Between the visits to the children,
  *           invoke IVisitor::betweenChildren()
  *     -# Invoke IVisitor::postVisit()
  *
  * The order in which the child nodes are visited is determined by making a
  * call to the corresponding IVisitor::getChildVisitOrder() method. This is of
- * course only needed when the node contains more than one child.
+ * course only needed when the node contains more than one child. In
+ * IVisitor::NORMAL order, the statements of a list are visited in the order of
+ * getStatements(), the variable of an assignment before its expression, and
+ * the left-hand side of a binary expression before its right-hand side.
+ *
+ * The tree is walked by a Traversal, which keeps its own stack of the nodes
+ * being visited, so the depth of the tree is not limited by the native stack.
+ * An expression node may have several parents when it was created by an
+ * ExpressionFactory which shares expressions, and is then visited once for
+ * every parent.
  *
  * The IVisitor::preVisit() and IVisitor::postVisit() methods have its uses when
  * actions must be taken before or after a node is visited. For example, when
  * pretty-printing an AST, the IVisitor::preVisit() and IVisitor::postVisit()
  * methods can be used to control the level of indentation.
+ *
+ * Nodes can only be created in a NodeArena, with
+ * <code>new (arena) NNumber(...)</code>, and are never deleted one by one.
+ * The whole AST is released together with the arena.
  */
 class Node {
+  public:
+    /**
+     * Defines the type of a node, one per concrete node class. With it a
+     * StaticVisitor can find the class of a node without a virtual call.
+     */
+    enum Type {
+        PROGRAM,
+        STATEMENT_LIST,
+        ASSIGNMENT,
+        PRINT,
+        EXPRESSION_UNARY,
+        EXPRESSION_BINARY,
+        NUMBER,
+        VARIABLE
+    };
+
   public:
     /**
      * Creates a node.
      * 
-     * @param line
-     *        Line number at which this node was found.
-     * @param column
-     *        Column number at which this node was found.
+     * @param type
+     *        Type of the node.
+     * @param offset
+     *        Source offset (in bytes) at which this node was found.
      */
-    Node(int line, int column);
+    Node(Type type, unsigned int offset);
 
     /**
-     * Destroys this node and all of its child nodes.
+     * Destroys this node. The child nodes are not destroyed, as they are
+     * released together with the arena.
      */
     virtual ~Node(void);
 
     /**
-     * Get line number at which this node was declared.
+     * Allocates a node in an arena.
      *
-     * @returns Line number.
+     * @param size
+     *        Size of the node (in bytes).
+     * @param arena
+     *        Arena.
+     * @returns Memory for the node.
      */
-    int getLine(void) const;
+    static void* operator new(size_t size, NodeArena* arena);
 
     /**
-     * Get column number at which this node was declared.
+     * Called only if the constructor of a node allocated by
+     * operator new(size_t, NodeArena*) throws. Does nothing, as the memory is
+     * released with the arena.
      *
-     * @returns Column number.
+     * @param node
+     *        Memory of the node.
+     * @param arena
+     *        Arena.
      */
-    int getColumn(void) const;
+    static void operator delete(void* node, NodeArena* arena);
 
     /**
-     * Makes a visit to this node by the given visitor.
+     * Gets the source offset at which this node was declared. The line and
+     * column are found from the offset with a NewlineIndex of the source.
+     *
+     * @returns Byte offset.
+     */
+    unsigned int getOffset(void) const;
+
+    /**
+     * Gets the type of this node.
+     *
+     * @returns Node type.
+     */
+    Type getType(void) const {
+        return _type;
+    }
+
+    /**
+     * Makes a visit to this node and all of its descendants by the given
+     * visitor.
      *
      * @param visitor
      *        Visitor.
      * @throws NodeError
      *         When an error occurs.
      */
-    virtual void accept(IVisitor* visitor) throw(NodeError) = 0;
+    void accept(IVisitor* visitor) throw(NodeError);
+
+  protected:
+    /**
+     * Does nothing, as the memory of a node is released with its arena. It is
+     * not public, so that nodes cannot be deleted one by one.
+     *
+     * @param node
+     *        Memory of the node.
+     */
+    static void operator delete(void* node);
 
   private:
     /**
-     * Line number at which this node was declared.
+     * Source offset at which this node was declared.
      */
-    int _line;
+    unsigned int _offset;
 
     /**
-     * Column number at which this node was declared.
+     * Type of this node.
      */
-    int _column;
+    Type _type;
 };
 
 /**
@@ -183,15 +253,17 @@ class Node {
 class NProgram : public Node {
   public:
     /**
-     * \copydoc Node::Node(int, int)
+     * Creates a node.
      *
      * @param statements
      *        Statement list node.
+     *
+     * @param offset
+     *        Source offset (in bytes) at which this node was found.
      */
     NProgram(
         NStatementList* statements,
-        int line,
-        int column);
+        unsigned int offset);
 
     /**
      * \copydoc Node::~Node(void)
@@ -205,11 +277,6 @@ class NProgram : public Node {
      */
     NStatementList* getStatementList(void) const;
 
-    /**
-     * \copydoc Node::accept(IVisitor*)
-     */
-    virtual void accept(IVisitor* visitor) throw(NodeError);
-
   private:
     /**
      * Statement list node.
@@ -220,14 +287,20 @@ class NProgram : public Node {
 /**
  * \brief Statement list node class.
  *
- * Class for a list of statements.
+ * Class for a list of statements, which are stored contiguously so that a
+ * pass over a long program is a linear scan over an array. As the list holds
+ * memory of its own, it must be registered with NodeArena::track() when it is
+ * created.
  */
 class NStatementList : public Node {
   public:
     /**
-     * \copydoc Node::Node(int, int)
+     * Creates a node.
+     *
+     * @param offset
+     *        Source offset (in bytes) at which this node was found.
      */
-    NStatementList(int line, int column);
+    NStatementList(unsigned int offset);
 
     /**
      * \copydoc Node::~Node(void)
@@ -252,25 +325,50 @@ class NStatementList : public Node {
     NStatementList& operator<<(NStatement* node);
 
     /**
-     * Gets all statement nodes that are children of this node.
+     * Moves all statement nodes of another statement list to the end of this
+     * node, keeping their order. The other list is left empty.
+     *
+     * @param other
+     *        Statement list node.
+     */
+    void appendStatements(NStatementList* other);
+
+    /**
+     * Gets all statement nodes that are children of this node, without
+     * copying them.
      *
-     * @returns List of statement nodes.
+     * @returns Statement nodes, valid until this node is modified.
      */
-    std::list<NStatement*> getStatements(void);
+    const std::vector<NStatement*>& getStatements(void) const {
+        return _statements;
+    }
 
     /**
-     * \copydoc Node::accept(IVisitor*)
+     * Gets the number of statement nodes that are children of this node.
      *
-     * In IVisitor::NORMAL visiting order, the child nodes are visited in the
-     * order they appear in the list retrieved from getStatements(void).
+     * @returns Number of statement nodes.
      */
-    virtual void accept(IVisitor* visitor) throw(NodeError);
+    size_t getNumStatements(void) const {
+        return _statements.size();
+    }
+
+    /**
+     * Gets a statement node that is a child of this node.
+     *
+     * @param i
+     *        Index of the statement, which must be less than
+     *        getNumStatements().
+     * @returns Statement node.
+     */
+    NStatement* getStatement(size_t i) const {
+        return _statements[i];
+    }
 
   private:
     /**
-     * List of statement nodes.
+     * Statement nodes.
      */
-    std::list<NStatement*> _statements;
+    std::vector<NStatement*> _statements;
 };
 
 /**
@@ -281,9 +379,9 @@ class NStatementList : public Node {
 class NStatement : public Node {
   public:
     /**
-     * \copydoc Node::Node(int, int)
+     * \copydoc Node::Node(Type, unsigned int)
      */
-    NStatement(int line, int column);
+    NStatement(Type type, unsigned int offset);
 
     /**
      * \copydoc Node::~Node(void)
@@ -299,14 +397,17 @@ class NStatement : public Node {
 class NAssignment : public NStatement {
   public:
     /**
-     * \copydoc Node::Node(int, int)
+     * Creates a node.
      *
      * @param variable
      *        Variable node
      * @param expr
      *        Expression node.
+     *
+     * @param offset
+     *        Source offset (in bytes) at which this node was found.
      */
-    NAssignment(NVariable* variable, NExpression* expr, int line, int column);
+    NAssignment(NVariable* variable, NExpression* expr, unsigned int offset);
 
     /**
      * \copydoc Node::~Node(void)
@@ -327,14 +428,6 @@ class NAssignment : public NStatement {
      */
     NExpression* getExpression(void) const;
 
-    /**
-     * \copydoc Node::accept(IVisitor*)
-     *
-     * In IVisitor::NORMAL visiting order, the variable node is visited before
-     * the expression node.
-     */
-    virtual void accept(IVisitor* visitor) throw(NodeError);
-
   private:
     /**
      * Variable node.
@@ -355,12 +448,15 @@ class NAssignment : public NStatement {
 class NPrint : public NStatement {
   public:
     /**
-     * \copydoc Node::Node(int, int)
+     * Creates a node.
      *
      * @param expr
      *        Expression node.
+     *
+     * @param offset
+     *        Source offset (in bytes) at which this node was found.
      */
-    NPrint(NExpression* expr, int line, int column);
+    NPrint(NExpression* expr, unsigned int offset);
 
     /**
      * \copydoc Node::~Node(void)
@@ -374,11 +470,6 @@ class NPrint : public NStatement {
      */
     NExpression* getExpression(void) const;
 
-    /**
-     * \copydoc Node::accept(IVisitor*)
-     */
-    virtual void accept(IVisitor* visitor) throw(NodeError);
-
   private:
     /**
      * Expression node.
@@ -394,9 +485,9 @@ class NPrint : public NStatement {
 class NExpression : public Node {
   public:
     /**
-     * \copydoc Node::Node(int, int)
+     * \copydoc Node::Node(Type, unsigned int)
      */
-    NExpression(int line, int column);
+    NExpression(Type type, unsigned int offset);
 
     /**
      * \copydoc Node::~Node(void)
@@ -412,18 +503,20 @@ class NExpression : public Node {
 class NExpressionUnary : public NExpression {
   public:
     /**
-     * \copydoc Node::Node(int, int)
+     * Creates a node.
      *
      * @param op
      *        Unary operator.
      * @param expr
      *        Expression node.
+     *
+     * @param offset
+     *        Source offset (in bytes) at which this node was found.
      */
     NExpressionUnary(
         ExpressionOperator op,
         NExpression* expr,
-        int line,
-        int column);
+        unsigned int offset);
 
     /**
      * \copydoc Node::~Node(void)
@@ -444,11 +537,6 @@ class NExpressionUnary : public NExpression {
      */
     ExpressionOperator getOperator(void) const;
 
-    /**
-     * \copydoc Node::accept(IVisitor*)
-     */
-    virtual void accept(IVisitor* visitor) throw(NodeError);
-
   private:
     /**
      * Expression operator.
@@ -469,7 +557,7 @@ class NExpressionUnary : public NExpression {
 class NExpressionBinary : public NExpression {
   public:
     /**
-     * \copydoc Node::Node(int, int)
+     * Creates a node.
      *
      * @param lhs
      *        Left-hand side expression node.
@@ -477,13 +565,15 @@ class NExpressionBinary : public NExpression {
      *        Binary operator.
      * @param rhs
      *        Right-hand side expression node.
+     *
+     * @param offset
+     *        Source offset (in bytes) at which this node was found.
      */
     NExpressionBinary(
         NExpression* lhs,
         ExpressionOperator op,
         NExpression* rhs,
-        int line,
-        int column);
+        unsigned int offset);
 
     /**
      * \copydoc Node::~Node(void)
@@ -511,14 +601,6 @@ class NExpressionBinary : public NExpression {
      */
     NExpression* getRhsExpression(void) const;
 
-    /**
-     * \copydoc Node::accept(IVisitor*)
-     *
-     * In IVisitor::NORMAL visiting order, the left-hand side expression node is
-     * visited before the right-hand side expression node.
-     */
-    virtual void accept(IVisitor* visitor) throw(NodeError);
-
   private:
     /**
      * Left-hand side expression node.
@@ -539,17 +621,21 @@ class NExpressionBinary : public NExpression {
 /**
  * \brief Number node class
  *
- * Class for a number.
+ * Class for a number. The number text refers into a source buffer or into
+ * the NodeArena, either of which outlives the AST.
  */
 class NNumber : public NExpression {
   public:
     /**
-     * \copydoc Node::Node(int, int)
+     * Creates a node.
      *
      * @param number
-     *        Number value.
+     *        Number value. It is not copied, and must outlive the node.
+     *
+     * @param offset
+     *        Source offset (in bytes) at which this node was found.
      */
-    NNumber(const std::string& number, int line, int column);
+    NNumber(const TextSpan& number, unsigned int offset);
 
     /**
      * \copydoc Node::~Node(void)
@@ -557,38 +643,37 @@ class NNumber : public NExpression {
     virtual ~NNumber(void);
 
     /**
-     * Gets the number value.
+     * Gets the number value. This does not allocate.
      *
-     * @returns Number value.
+     * @returns Number value, valid as long as the node.
      */
-    std::string getNumber(void) const;
-
-    /**
-     * \copydoc Node::accept(IVisitor*)
-     */
-    virtual void accept(IVisitor* visitor) throw(NodeError);
+    TextSpan getNumber(void) const;
 
   private:
     /**
-     * Number as a string.
+     * Number as text.
      */
-    std::string _number;
+    TextSpan _number;
 };
 
 /**
  * \brief Variable node class.
  *
- * Class for a variable.
+ * Class for a variable. The name refers into a source buffer or into the
+ * NodeArena, either of which outlives the AST.
  */
 class NVariable : public NExpression {
   public:
     /**
-     * \copydoc Node::Node(int, int)
+     * Creates a node.
      *
      * @param name
-     *        Variable name.
+     *        Variable name. It is not copied, and must outlive the node.
+     *
+     * @param offset
+     *        Source offset (in bytes) at which this node was found.
      */
-    NVariable(const std::string& name, int line, int column);
+    NVariable(const TextSpan& name, unsigned int offset);
 
     /**
      * \copydoc Node::~Node(void)
@@ -596,22 +681,39 @@ class NVariable : public NExpression {
     virtual ~NVariable(void);
 
     /**
-     * Gets the variable name.
+     * Gets the variable name. This does not allocate.
      *
-     * @returns Variable name.
+     * @returns Variable name, valid as long as the node.
      */
-    std::string getName(void) const;
+    TextSpan getName(void) const;
 
     /**
-     * \copydoc Node::accept(IVisitor*)
+     * Gets the symbol id of the variable, i.e. the index of its record in the
+     * symbol table. It is set when the symbol table is built, so that the
+     * later passes need not look up the name again.
+     *
+     * @returns Symbol id, or -1 if the variable has not been resolved.
      */
-    virtual void accept(IVisitor* visitor) throw(NodeError);
+    int getSymbol(void) const;
+
+    /**
+     * Sets the symbol id of the variable.
+     *
+     * @param symbol
+     *        Symbol id.
+     */
+    void setSymbol(int symbol);
 
   private:
     /**
      * Variable name.
      */
-    std::string _name;
+    TextSpan _name;
+
+    /**
+     * Symbol id, or -1.
+     */
+    int _symbol;
 };
 
 /**
@@ -0,0 +1,230 @@
+#include "expression_factory.hpp"
+
+using namespace AST;
+using std::vector;
+
+ExpressionFactory::ExpressionFactory(NodeArena* arena)
+        : _arena(arena), _sharing(false), _num_entries(0), _num_variables(0)
+{}
+
+ExpressionFactory::~ExpressionFactory(void) {}
+
+void ExpressionFactory::setSharing(bool sharing) {
+    _sharing = sharing;
+}
+
+bool ExpressionFactory::isSharing(void) const {
+    return _sharing;
+}
+
+NNumber* ExpressionFactory::createNumber(
+    const TextSpan& number,
+    unsigned int offset,
+    bool copy)
+{
+    if (!_sharing) {
+        return new (_arena) NNumber(keep(number, copy), offset);
+    }
+
+    reserveEntry();
+    size_t hash = number.hash();
+    Entry* entry = findNumber(number, hash);
+    if (!entry->node) {
+        entry->hash = hash;
+        entry->node = new (_arena) NNumber(keep(number, copy), offset);
+        _num_entries++;
+    }
+    return static_cast<NNumber*>(entry->node);
+}
+
+NVariable* ExpressionFactory::createVariable(
+    const TextSpan& name,
+    unsigned int offset,
+    bool copy)
+{
+    if (!_sharing) {
+        return new (_arena) NVariable(keep(name, copy), offset);
+    }
+
+    reserveVariableEntry();
+    size_t hash = name.hash();
+    VariableEntry* entry = findVariable(name, hash);
+    if (entry->name.length() == 0) {
+        entry->hash = hash;
+        entry->name = keep(name, copy);
+        _num_variables++;
+    }
+    if (!entry->node) {
+        entry->node = new (_arena) NVariable(entry->name, offset);
+    }
+    return entry->node;
+}
+
+NExpressionUnary* ExpressionFactory::createUnary(
+    ExpressionOperator op,
+    NExpression* expr,
+    unsigned int offset)
+{
+    if (!_sharing) {
+        return new (_arena) NExpressionUnary(op, expr, offset);
+    }
+
+    reserveEntry();
+    size_t hash = combine(combine(Node::EXPRESSION_UNARY, op),
+                          reinterpret_cast<size_t>(expr));
+    Entry* entry =
+        findExpression(Node::EXPRESSION_UNARY, op, expr, NULL, hash);
+    if (!entry->node) {
+        entry->hash = hash;
+        entry->node = new (_arena) NExpressionUnary(op, expr, offset);
+        _num_entries++;
+    }
+    return static_cast<NExpressionUnary*>(entry->node);
+}
+
+NExpressionBinary* ExpressionFactory::createBinary(
+    NExpression* lhs,
+    ExpressionOperator op,
+    NExpression* rhs,
+    unsigned int offset)
+{
+    if (!_sharing) {
+        return new (_arena) NExpressionBinary(lhs, op, rhs, offset);
+    }
+
+    reserveEntry();
+    size_t hash = combine(combine(combine(Node::EXPRESSION_BINARY, op),
+                                  reinterpret_cast<size_t>(lhs)),
+                          reinterpret_cast<size_t>(rhs));
+    Entry* entry =
+        findExpression(Node::EXPRESSION_BINARY, op, lhs, rhs, hash);
+    if (!entry->node) {
+        entry->hash = hash;
+        entry->node = new (_arena) NExpressionBinary(lhs, op, rhs, offset);
+        _num_entries++;
+    }
+    return static_cast<NExpressionBinary*>(entry->node);
+}
+
+void ExpressionFactory::assign(const TextSpan& name) {
+    if (!_sharing || _variables.empty()) return;
+
+    // The entry is kept, so that the variable need not be hashed in again
+    VariableEntry* entry = findVariable(name, name.hash());
+    entry->node = NULL;
+}
+
+void ExpressionFactory::clear(void) {
+    _entries.clear();
+    _num_entries = 0;
+    _variables.clear();
+    _num_variables = 0;
+}
+
+ExpressionFactory::Entry* ExpressionFactory::findNumber(
+    const TextSpan& number,
+    size_t hash)
+{
+    size_t mask = _entries.size() - 1;
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+        Entry* entry = &_entries[i];
+        if (!entry->node) return entry;
+        if (entry->hash == hash && entry->node->getType() == Node::NUMBER
+            && static_cast<NNumber*>(entry->node)->getNumber() == number)
+        {
+            return entry;
+        }
+    }
+}
+
+ExpressionFactory::Entry* ExpressionFactory::findExpression(
+    Node::Type type,
+    ExpressionOperator op,
+    NExpression* lhs,
+    NExpression* rhs,
+    size_t hash)
+{
+    size_t mask = _entries.size() - 1;
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+        Entry* entry = &_entries[i];
+        if (!entry->node) return entry;
+        if (entry->hash != hash || entry->node->getType() != type) continue;
+        if (type == Node::EXPRESSION_UNARY) {
+            NExpressionUnary* node =
+                static_cast<NExpressionUnary*>(entry->node);
+            if (node->getOperator() == op && node->getExpression() == lhs) {
+                return entry;
+            }
+        }
+        else {
+            NExpressionBinary* node =
+                static_cast<NExpressionBinary*>(entry->node);
+            if (node->getOperator() == op && node->getLhsExpression() == lhs
+                && node->getRhsExpression() == rhs)
+            {
+                return entry;
+            }
+        }
+    }
+}
+
+ExpressionFactory::VariableEntry* ExpressionFactory::findVariable(
+    const TextSpan& name,
+    size_t hash)
+{
+    size_t mask = _variables.size() - 1;
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+        VariableEntry* entry = &_variables[i];
+        if (entry->name.length() == 0) return entry;
+        if (entry->hash == hash && entry->name == name) return entry;
+    }
+}
+
+void ExpressionFactory::reserveEntry(void) {
+    if (2 * (_num_entries + 1) <= _entries.size()) return;
+
+    vector<Entry> old;
+    old.swap(_entries);
+    Entry free = { 0, NULL };
+    _entries.resize(old.empty() ? 64 : 2 * old.size(), free);
+    size_t mask = _entries.size() - 1;
+    for (size_t i = 0; i < old.size(); i++) {
+        if (!old[i].node) continue;
+        size_t j = old[i].hash & mask;
+        while (_entries[j].node) j = (j + 1) & mask;
+        _entries[j] = old[i];
+    }
+}
+
+void ExpressionFactory::reserveVariableEntry(void) {
+    if (2 * (_num_variables + 1) <= _variables.size()) return;
+
+    vector<VariableEntry> old;
+    old.swap(_variables);
+    VariableEntry free = { 0, TextSpan(), NULL };
+    _variables.resize(old.empty() ? 64 : 2 * old.size(), free);
+    size_t mask = _variables.size() - 1;
+    for (size_t i = 0; i < old.size(); i++) {
+        if (old[i].name.length() == 0) continue;
+        size_t j = old[i].hash & mask;
+        while (_variables[j].name.length() != 0) j = (j + 1) & mask;
+        _variables[j] = old[i];
+    }
+}
+
+TextSpan ExpressionFactory::keep(const TextSpan& text, bool copy) {
+    if (!copy) return text;
+    return TextSpan(_arena->copyText(text.data(), text.length()),
+                    text.length());
+}
+
+size_t ExpressionFactory::combine(size_t hash, size_t value) {
+    // The low bits of a node pointer are always zero, and the tables are
+    // indexed by the low bits of the hash, so every value is mixed first
+    value ^= value >> 16;
+    value *= 0x85ebca6bu;
+    value ^= value >> 13;
+    value *= 0xc2b2ae35u;
+    value ^= value >> 16;
+    return hash ^ (value + 0x9e3779b9u + (hash << 6) + (hash >> 2));
+}
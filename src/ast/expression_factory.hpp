@@ -0,0 +1,350 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CEE_AST_EXPRESSION_FACTORY__H
+#define CEE_AST_EXPRESSION_FACTORY__H
+
+/**
+ * @file
+ * @brief Defines the factory through which the parsers create expression
+ *        nodes.
+ */
+
+#include "ast.hpp"
+#include "node_arena.hpp"
+#include "text_span.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace AST {
+
+/**
+ * \brief Factory through which the parsers create expression nodes.
+ *
+ * The ExpressionFactory class creates the expression nodes of an AST in a
+ * NodeArena. By default, every call creates a new node, and the AST is a
+ * tree. With sharing turned on, the factory hash-conses the nodes instead:
+ * an expression which is structurally identical to one created before (the
+ * same operator and the same children, or the same number or variable) is
+ * not created again, but the earlier node is returned. The AST then becomes
+ * a DAG, in which a node may be the child of several nodes, and programs
+ * which repeat the same subexpressions take much less memory.
+ *
+ * As the children of a node are shared themselves, two expressions are
+ * identical exactly when their children are the same nodes, so a node is
+ * found by one hash lookup, without comparing subtrees.
+ *
+ * A variable which is read is only shared until it is next assigned to,
+ * which the parser reports with assign(). After that, reading it creates a
+ * new node, and so do all expressions which read it. A shared node therefore
+ * has the same value wherever it is used, which makes the DAG a basis for
+ * reusing common subexpressions in the code generator.
+ *
+ * A shared node keeps the source offset of its first occurrence, which is
+ * the one diagnostics and line tables refer to for all uses. Sharing should
+ * therefore be off when a line table is generated, as every other use would
+ * be attributed to the wrong line. The passes walk the DAG as a tree,
+ * visiting a shared node once for every use.
+ */
+class ExpressionFactory {
+  public:
+    /**
+     * Creates a factory with sharing turned off.
+     *
+     * @param arena
+     *        Arena in which the nodes are created.
+     */
+    ExpressionFactory(NodeArena* arena);
+
+    /**
+     * Destroys this factory. The nodes it created are kept in the arena.
+     */
+    ~ExpressionFactory(void);
+
+    /**
+     * Turns sharing of identical expressions on or off. Nodes created while
+     * it was off are never shared.
+     *
+     * @param sharing
+     *        Whether to share identical expressions.
+     */
+    void setSharing(bool sharing);
+
+    /**
+     * Checks whether identical expressions are shared.
+     *
+     * @returns \c true if so.
+     */
+    bool isSharing(void) const;
+
+    /**
+     * Creates a number node, or gets the shared one.
+     *
+     * @param number
+     *        Number value.
+     * @param offset
+     *        Source offset (in bytes) at which the number was found.
+     * @param copy
+     *        Whether the number must be copied into the arena, as it does not
+     *        outlive the AST.
+     * @returns Number node.
+     */
+    NNumber* createNumber(
+        const TextSpan& number,
+        unsigned int offset,
+        bool copy = false);
+
+    /**
+     * Creates a node for a variable which is read, or gets the shared one.
+     *
+     * @param name
+     *        Variable name.
+     * @param offset
+     *        Source offset (in bytes) at which the variable was found.
+     * @param copy
+     *        Whether the name must be copied into the arena, as it does not
+     *        outlive the AST.
+     * @returns Variable node.
+     */
+    NVariable* createVariable(
+        const TextSpan& name,
+        unsigned int offset,
+        bool copy = false);
+
+    /**
+     * Creates a unary expression node, or gets the shared one.
+     *
+     * @param op
+     *        Expression operator.
+     * @param expr
+     *        Expression node.
+     * @param offset
+     *        Source offset (in bytes) at which the expression was found.
+     * @returns Unary expression node.
+     */
+    NExpressionUnary* createUnary(
+        ExpressionOperator op,
+        NExpression* expr,
+        unsigned int offset);
+
+    /**
+     * Creates a binary expression node, or gets the shared one.
+     *
+     * @param lhs
+     *        Left-hand side expression node.
+     * @param op
+     *        Expression operator.
+     * @param rhs
+     *        Right-hand side expression node.
+     * @param offset
+     *        Source offset (in bytes) at which the expression was found.
+     * @returns Binary expression node.
+     */
+    NExpressionBinary* createBinary(
+        NExpression* lhs,
+        ExpressionOperator op,
+        NExpression* rhs,
+        unsigned int offset);
+
+    /**
+     * Reports that a variable is assigned to, after the expression assigned
+     * to it has been created. Later reads of the variable are not shared with
+     * the earlier ones.
+     *
+     * @param name
+     *        Variable name.
+     */
+    void assign(const TextSpan& name);
+
+    /**
+     * Forgets all shared nodes, e.g. when the arena has been released.
+     */
+    void clear(void);
+
+  private:
+    /**
+     * \brief Shared number or expression node.
+     */
+    struct Entry {
+        /**
+         * Hash of the node.
+         */
+        size_t hash;
+
+        /**
+         * Node, or \c NULL if the entry is free.
+         */
+        NExpression* node;
+    };
+
+    /**
+     * \brief Variable whose reads are shared.
+     */
+    struct VariableEntry {
+        /**
+         * Hash of the name.
+         */
+        size_t hash;
+
+        /**
+         * Name, or an empty span if the entry is free.
+         */
+        TextSpan name;
+
+        /**
+         * Node shared by the reads since the last assignment, or \c NULL if
+         * there has been none since.
+         */
+        NVariable* node;
+    };
+
+  private:
+    /**
+     * Finds the entry of a number, or the free entry where it belongs.
+     *
+     * @param number
+     *        Number value.
+     * @param hash
+     *        Hash of the number.
+     * @returns Entry.
+     */
+    Entry* findNumber(const TextSpan& number, size_t hash);
+
+    /**
+     * Finds the entry of a unary or binary expression, or the free entry
+     * where it belongs.
+     *
+     * @param type
+     *        Node type.
+     * @param op
+     *        Expression operator.
+     * @param lhs
+     *        Only or left-hand side expression node.
+     * @param rhs
+     *        Right-hand side expression node, or \c NULL.
+     * @param hash
+     *        Hash of the expression.
+     * @returns Entry.
+     */
+    Entry* findExpression(
+        Node::Type type,
+        ExpressionOperator op,
+        NExpression* lhs,
+        NExpression* rhs,
+        size_t hash);
+
+    /**
+     * Finds the entry of a variable, or the free entry where it belongs.
+     *
+     * @param name
+     *        Variable name.
+     * @param hash
+     *        Hash of the name.
+     * @returns Entry.
+     */
+    VariableEntry* findVariable(const TextSpan& name, size_t hash);
+
+    /**
+     * Makes room for one more entry, doubling the table when it is half
+     * full.
+     */
+    void reserveEntry(void);
+
+    /**
+     * Makes room for one more variable entry, doubling the table when it is
+     * half full.
+     */
+    void reserveVariableEntry(void);
+
+    /**
+     * Copies a text into the arena if needed.
+     *
+     * @param text
+     *        Text.
+     * @param copy
+     *        Whether to copy it.
+     * @returns Text which outlives the AST.
+     */
+    TextSpan keep(const TextSpan& text, bool copy);
+
+    /**
+     * Combines a hash with a value.
+     *
+     * @param hash
+     *        Hash.
+     * @param value
+     *        Value.
+     * @returns Combined hash.
+     */
+    static size_t combine(size_t hash, size_t value);
+
+    /**
+     * Hidden copy constructor.
+     */
+    ExpressionFactory(const ExpressionFactory&);
+
+    /**
+     * Hidden assignment operator.
+     */
+    ExpressionFactory& operator=(const ExpressionFactory&);
+
+  private:
+    /**
+     * Arena in which the nodes are created.
+     */
+    NodeArena* _arena;
+
+    /**
+     * Whether identical expressions are shared.
+     */
+    bool _sharing;
+
+    /**
+     * Open-addressing hash table of the shared numbers and expressions. Its
+     * size is zero or a power of two.
+     */
+    std::vector<Entry> _entries;
+
+    /**
+     * Number of used entries.
+     */
+    size_t _num_entries;
+
+    /**
+     * Open-addressing hash table of the variables which have been read. Its
+     * size is zero or a power of two.
+     */
+    std::vector<VariableEntry> _variables;
+
+    /**
+     * Number of used variable entries.
+     */
+    size_t _num_variables;
+};
+
+}
+
+#endif
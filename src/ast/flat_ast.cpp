@@ -0,0 +1,166 @@
+#include "flat_ast.hpp"
+#include <stack>
+
+using namespace AST;
+using std::stack;
+
+namespace AST {
+
+/**
+ * Implements a visitor which appends the nodes of an AST to a FlatAst, in
+ * post-order.
+ */
+class FlatAstBuilder : public DefaultVisitor {
+  public:
+    FlatAstBuilder(FlatAst* ast) : _ast(ast), _target(NULL) {}
+
+    virtual void preVisit(NAssignment* node) throw(NodeError) {
+        _target = node->getVariable();
+    }
+
+    virtual void postVisit(NAssignment* node) throw(NodeError) {
+        NVariable* variable = node->getVariable();
+        unsigned int name = _ast->appendText(variable->getName(),
+                                             variable->getSymbol());
+        unsigned int i = _ast->append(FlatAst::ASSIGNMENT, PLUS,
+                                      node->getOffset(), name);
+        _ast->appendStatement(i);
+    }
+
+    virtual void postVisit(NPrint* node) throw(NodeError) {
+        unsigned int i = _ast->append(FlatAst::PRINT, PLUS,
+                                      node->getOffset(), 0);
+        _ast->appendStatement(i);
+    }
+
+    virtual void preVisit(NExpressionUnary* node) throw(NodeError) {
+        _ast->append(FlatAst::UNARY_START, node->getOperator(),
+                     node->getOffset(), 0);
+    }
+
+    virtual void postVisit(NExpressionUnary* node) throw(NodeError) {
+        _ast->append(FlatAst::UNARY, node->getOperator(), node->getOffset(),
+                     0);
+    }
+
+    virtual void betweenChildren(NExpressionBinary* node) throw(NodeError) {
+        _lhs.push(_ast->getNumNodes() - 1);
+    }
+
+    virtual void postVisit(NExpressionBinary* node) throw(NodeError) {
+        _ast->append(FlatAst::BINARY, node->getOperator(), node->getOffset(),
+                     _lhs.top());
+        _lhs.pop();
+    }
+
+    virtual void visit(NVariable* node) throw(NodeError) {
+        // The variable assigned to is kept by the assignment
+        if (node == _target) return;
+        unsigned int name = _ast->appendText(node->getName(),
+                                             node->getSymbol());
+        _ast->append(FlatAst::VARIABLE, PLUS, node->getOffset(), name);
+    }
+
+    virtual void visit(NNumber* node) throw(NodeError) {
+        unsigned int number = _ast->appendText(node->getNumber());
+        _ast->append(FlatAst::NUMBER, PLUS, node->getOffset(), number);
+    }
+
+  private:
+    FlatAst* _ast;
+    NVariable* _target;
+    stack<unsigned int> _lhs;
+};
+
+}
+
+FlatAst::FlatAst(void) {}
+
+FlatAst::~FlatAst(void) {}
+
+void FlatAst::build(NProgram* program) {
+    clear();
+    FlatAstBuilder builder(this);
+    program->accept(&builder);
+}
+
+void FlatAst::clear(void) {
+    _kinds.clear();
+    _operators.clear();
+    _offsets.clear();
+    _values.clear();
+    _texts.clear();
+    _symbols.clear();
+    _statements.clear();
+}
+
+unsigned int FlatAst::append(
+    Kind kind,
+    ExpressionOperator op,
+    unsigned int offset,
+    unsigned int value)
+{
+    _kinds.push_back(kind);
+    _operators.push_back(op);
+    _offsets.push_back(offset);
+    _values.push_back(value);
+    return _kinds.size() - 1;
+}
+
+unsigned int FlatAst::appendText(const TextSpan& text, int symbol) {
+    _texts.push_back(text);
+    _symbols.push_back(symbol);
+    return _texts.size() - 1;
+}
+
+void FlatAst::appendStatement(unsigned int node) {
+    _statements.push_back(node);
+}
+
+void FlatAst::appendStatements(FlatAst* other) {
+    // The node and text indices of the other AST are shifted by the nodes and
+    // texts in front of them
+    unsigned int num_nodes = _kinds.size();
+    unsigned int num_texts = _texts.size();
+    _kinds.insert(_kinds.end(), other->_kinds.begin(), other->_kinds.end());
+    _operators.insert(_operators.end(), other->_operators.begin(),
+                      other->_operators.end());
+    _offsets.insert(_offsets.end(), other->_offsets.begin(),
+                    other->_offsets.end());
+    _values.reserve(_values.size() + other->_values.size());
+    for (size_t i = 0; i < other->_values.size(); i++) {
+        unsigned int value = other->_values[i];
+        switch (other->_kinds[i]) {
+            case BINARY:
+                value += num_nodes;
+                break;
+
+            case NUMBER:
+            case VARIABLE:
+            case ASSIGNMENT:
+                value += num_texts;
+                break;
+
+            default:
+                break;
+        }
+        _values.push_back(value);
+    }
+    _texts.insert(_texts.end(), other->_texts.begin(), other->_texts.end());
+    _symbols.insert(_symbols.end(), other->_symbols.begin(),
+                    other->_symbols.end());
+    _statements.reserve(_statements.size() + other->_statements.size());
+    for (size_t i = 0; i < other->_statements.size(); i++) {
+        _statements.push_back(other->_statements[i] + num_nodes);
+    }
+
+    // The other AST is usually not used again, so its memory is released
+    FlatAst empty;
+    other->_kinds.swap(empty._kinds);
+    other->_operators.swap(empty._operators);
+    other->_offsets.swap(empty._offsets);
+    other->_values.swap(empty._values);
+    other->_texts.swap(empty._texts);
+    other->_symbols.swap(empty._symbols);
+    other->_statements.swap(empty._statements);
+}
@@ -0,0 +1,341 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CEE_AST_FLAT_AST__H
+#define CEE_AST_FLAT_AST__H
+
+/**
+ * @file
+ * @brief Defines a flat, index-based representation of the AST.
+ */
+
+#include "ast.hpp"
+#include "text_span.hpp"
+#include <vector>
+
+namespace AST {
+
+/**
+ * \brief Flat, index-based representation of the AST.
+ *
+ * The FlatAst class stores the nodes of a program as a structure of arrays,
+ * in the same way as the TokenBuffer stores tokens: one array of kinds, one
+ * of operators, one of source offsets and one of values, all addressed by a
+ * 32-bit node index. There are no pointers between the nodes and no virtual
+ * calls, so a pass over the program is a linear walk over a few arrays.
+ *
+ * The nodes are stored in post-order, i.e. every node comes after its
+ * children, and the statements come in source order. This is the order in
+ * which the code of a stack machine is generated and in which the variables
+ * must be declared, so both the SymbolTableBuilder and the CodeGenerator can
+ * process the nodes from first to last. As the last child of a node always
+ * comes right before it, only the left-hand side of a binary expression is
+ * stored explicitly.
+ *
+ * Two nodes differ from the pointer-based AST:
+ *     - The variable assigned to is not a node of its own. The name is kept
+ *       by the ASSIGNMENT node instead, as it is not evaluated.
+ *     - A unary expression also has an UNARY_START node in front of its
+ *       operand, as it is the only node with an action before its operand
+ *       (the code generator pushes the 0 from which the operand is
+ *       subtracted).
+ *
+ *
+ * A FlatAst is either converted from the pointer-based AST with build(), or
+ * filled node by node with append(), which lets the FastParser, the
+ * ParallelParser and the ParseCache produce it without building the
+ * pointer-based AST at all. Identifier and number texts are not copied, so
+ * the text they refer to (usually the source text) must outlive the FlatAst,
+ * but the pointer-based AST it was converted from may be released. The symbol
+ * ids of the variables are taken over from the AST, if they have been
+ * resolved.
+ */
+class FlatAst {
+  public:
+    /**
+     * Node kinds.
+     */
+    enum Kind {
+        /**
+         * Number. The value is the index of its text.
+         */
+        NUMBER,
+
+        /**
+         * Variable which is read. The value is the index of its name.
+         */
+        VARIABLE,
+
+        /**
+         * Start of a unary expression, in front of its operand.
+         */
+        UNARY_START,
+
+        /**
+         * Unary expression. Its operand is the previous node.
+         */
+        UNARY,
+
+        /**
+         * Binary expression. The value is the index of its left-hand side,
+         * and its right-hand side is the previous node.
+         */
+        BINARY,
+
+        /**
+         * Assignment. The value is the index of the name of the variable, and
+         * the expression is the previous node.
+         */
+        ASSIGNMENT,
+
+        /**
+         * Print statement. The expression is the previous node.
+         */
+        PRINT
+    };
+
+  public:
+    /**
+     * Creates an empty flat AST.
+     */
+    FlatAst(void);
+
+    /**
+     * Destroys this flat AST.
+     */
+    ~FlatAst(void);
+
+    /**
+     * Builds the flat representation of a program, replacing any previous
+     * content.
+     *
+     * @param program
+     *        Program node.
+     */
+    void build(NProgram* program);
+
+    /**
+     * Removes all nodes.
+     */
+    void clear(void);
+
+    /**
+     * Appends a node. The nodes must be appended in post-order.
+     *
+     * @param kind
+     *        Node kind.
+     * @param op
+     *        Expression operator, if any.
+     * @param offset
+     *        Source offset.
+     * @param value
+     *        Value, whose meaning depends on the kind.
+     * @returns Node index.
+     */
+    unsigned int append(
+        Kind kind,
+        ExpressionOperator op,
+        unsigned int offset,
+        unsigned int value);
+
+    /**
+     * Appends a text, to which a NUMBER, VARIABLE or ASSIGNMENT node then
+     * refers by its index.
+     *
+     * @param text
+     *        Text, which is not copied.
+     * @param symbol
+     *        Symbol id, if the text is the name of a resolved variable.
+     * @returns Text index.
+     */
+    unsigned int appendText(const TextSpan& text, int symbol = -1);
+
+    /**
+     * Marks a node as the end of the next statement.
+     *
+     * @param node
+     *        Node index of an ASSIGNMENT or PRINT node.
+     */
+    void appendStatement(unsigned int node);
+
+    /**
+     * Moves all nodes of another flat AST to the end of this one, as further
+     * statements. The other flat AST is left empty.
+     *
+     * @param other
+     *        Flat AST.
+     */
+    void appendStatements(FlatAst* other);
+
+    /**
+     * Gets the number of nodes.
+     *
+     * @returns Number of nodes.
+     */
+    unsigned int getNumNodes(void) const {
+        return _kinds.size();
+    }
+
+    /**
+     * Gets the kind of a node.
+     *
+     * @param i
+     *        Node index.
+     * @returns Node kind.
+     */
+    Kind getKind(unsigned int i) const {
+        return static_cast<Kind>(_kinds[i]);
+    }
+
+    /**
+     * Gets the operator of a unary or binary expression.
+     *
+     * @param i
+     *        Node index.
+     * @returns Expression operator.
+     */
+    ExpressionOperator getOperator(unsigned int i) const {
+        return static_cast<ExpressionOperator>(_operators[i]);
+    }
+
+    /**
+     * Gets the source offset of a node.
+     *
+     * @param i
+     *        Node index.
+     * @returns Byte offset.
+     */
+    unsigned int getOffset(unsigned int i) const {
+        return _offsets[i];
+    }
+
+    /**
+     * Gets the left-hand side of a binary expression.
+     *
+     * @param i
+     *        Node index.
+     * @returns Node index of the left-hand side.
+     */
+    unsigned int getLhs(unsigned int i) const {
+        return _values[i];
+    }
+
+    /**
+     * Gets the text of a number, or the name of a variable which is read or
+     * assigned to.
+     *
+     * @param i
+     *        Node index.
+     * @returns Text, valid as long as the AST it was built from.
+     */
+    TextSpan getText(unsigned int i) const {
+        return _texts[_values[i]];
+    }
+
+    /**
+     * Gets the symbol id of a variable which is read or assigned to (see
+     * AST::NVariable::getSymbol()).
+     *
+     * @param i
+     *        Node index.
+     * @returns Symbol id, or -1 if the variable has not been resolved.
+     */
+    int getSymbol(unsigned int i) const {
+        return _symbols[_values[i]];
+    }
+
+    /**
+     * Sets the symbol id of a variable which is read or assigned to.
+     *
+     * @param i
+     *        Node index.
+     * @param symbol
+     *        Symbol id.
+     */
+    void setSymbol(unsigned int i, int symbol) {
+        _symbols[_values[i]] = symbol;
+    }
+
+    /**
+     * Gets the number of statements.
+     *
+     * @returns Number of statements.
+     */
+    unsigned int getNumStatements(void) const {
+        return _statements.size();
+    }
+
+    /**
+     * Gets the node of a statement, which is the last node of its subtree.
+     *
+     * @param i
+     *        Statement index.
+     * @returns Node index.
+     */
+    unsigned int getStatement(unsigned int i) const {
+        return _statements[i];
+    }
+
+  private:
+    /**
+     * Kind of each node.
+     */
+    std::vector<unsigned char> _kinds;
+
+    /**
+     * Operator of each node, for unary and binary expressions.
+     */
+    std::vector<unsigned char> _operators;
+
+    /**
+     * Source offset of each node.
+     */
+    std::vector<unsigned int> _offsets;
+
+    /**
+     * Value of each node, whose meaning depends on its kind.
+     */
+    std::vector<unsigned int> _values;
+
+    /**
+     * Texts of the numbers and variables.
+     */
+    std::vector<TextSpan> _texts;
+
+    /**
+     * Symbol id of each text, or -1.
+     */
+    std::vector<int> _symbols;
+
+    /**
+     * Node of each statement.
+     */
+    std::vector<unsigned int> _statements;
+};
+
+}
+
+#endif
@@ -0,0 +1,108 @@
+#include "node_arena.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdint.h>
+
+using namespace AST;
+
+NodeArena::NodeArena(size_t block_size)
+        : _block_size(block_size), _blocks(NULL), _next(NULL), _end(NULL)
+{}
+
+NodeArena::~NodeArena(void) {
+    release();
+}
+
+void* NodeArena::allocate(size_t size, size_t alignment) {
+    uintptr_t address = reinterpret_cast<uintptr_t>(_next);
+    size_t padding = (alignment - (address & (alignment - 1)))
+                     & (alignment - 1);
+    if (_next && padding + size <= static_cast<size_t>(_end - _next)) {
+        char* memory = _next + padding;
+        _next = memory + size;
+        return memory;
+    }
+
+    // A request which does not fit in a block gets a block of its own, and
+    // the current block is kept for the requests that follow
+    if (size + alignment > _block_size / 4) {
+        Block* current = _blocks;
+        char* memory = allocateBlock(size + alignment);
+        if (current) {
+            Block* block = _blocks;
+            _blocks = block->next;
+            block->next = current->next;
+            current->next = block;
+        }
+        else {
+            _next = _end = memory;
+        }
+        address = reinterpret_cast<uintptr_t>(memory);
+        return memory + ((alignment - (address & (alignment - 1)))
+                         & (alignment - 1));
+    }
+
+    _next = allocateBlock(_block_size);
+    _end = _next + _block_size;
+    return allocate(size, alignment);
+}
+
+const char* NodeArena::copyText(const char* data, size_t length) {
+    char* text = static_cast<char*>(allocate(length, 1));
+    memcpy(text, data, length);
+    return text;
+}
+
+void NodeArena::splice(NodeArena* other) {
+    if (other == this || !other->_blocks) return;
+
+    // The blocks of the other arena are linked in behind the current block,
+    // so that this arena goes on allocating from where it was
+    Block* last = other->_blocks;
+    while (last->next) last = last->next;
+    if (_blocks) {
+        last->next = _blocks->next;
+        _blocks->next = other->_blocks;
+    }
+    else {
+        _blocks = other->_blocks;
+        _next = other->_next;
+        _end = other->_end;
+    }
+    _finalizers.insert(_finalizers.end(), other->_finalizers.begin(),
+                       other->_finalizers.end());
+
+    other->_blocks = NULL;
+    other->_next = other->_end = NULL;
+    other->_finalizers.clear();
+}
+
+void NodeArena::release(void) {
+    for (size_t i = _finalizers.size(); i > 0; i--) {
+        _finalizers[i - 1].destroy(_finalizers[i - 1].object);
+    }
+    _finalizers.clear();
+
+    while (_blocks) {
+        Block* next = _blocks->next;
+        free(_blocks);
+        _blocks = next;
+    }
+    _next = _end = NULL;
+}
+
+char* NodeArena::allocateBlock(size_t size) {
+    // The header takes a whole alignment unit, so the usable memory starts
+    // aligned
+    void* memory = malloc(ALIGNMENT + size);
+    if (!memory) throw std::bad_alloc();
+    Block* block = static_cast<Block*>(memory);
+    block->next = _blocks;
+    _blocks = block;
+    return static_cast<char*>(memory) + ALIGNMENT;
+}
+
+const size_t NodeArena::DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+const size_t NodeArena::ALIGNMENT = 16;
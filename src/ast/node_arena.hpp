@@ -0,0 +1,221 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CEE_AST_NODE_ARENA__H
+#define CEE_AST_NODE_ARENA__H
+
+/**
+ * @file
+ * @brief Defines the memory arena in which the AST nodes are allocated.
+ */
+
+#include <cstddef>
+#include <vector>
+
+namespace AST {
+
+/**
+ * \brief Memory arena in which the AST nodes are allocated.
+ *
+ * The NodeArena class hands out memory by bumping a pointer through large
+ * blocks, so the nodes of an AST are allocated cheaply and lie close together
+ * in the order in which they were created. The memory is never given back
+ * node by node. Instead, all of it is released at once when the arena is
+ * released or destroyed, without the tree being walked.
+ *
+ * Nodes are therefore not destroyed individually. The few objects which hold
+ * memory of their own (e.g. the container of an AST::NStatementList) are
+ * registered with track(), and are destroyed when the arena is released.
+ */
+class NodeArena {
+  public:
+    /**
+     * Creates an empty arena. No memory is allocated until it is needed.
+     *
+     * @param block_size
+     *        Size of each block (in bytes). Larger requests get a block of
+     *        their own.
+     */
+    NodeArena(size_t block_size = DEFAULT_BLOCK_SIZE);
+
+    /**
+     * Destroys this arena, releasing all of its memory.
+     */
+    ~NodeArena(void);
+
+    /**
+     * Allocates memory from this arena.
+     *
+     * @param size
+     *        Size (in bytes).
+     * @param alignment
+     *        Alignment, which must be a power of 2.
+     * @returns Memory, valid until the arena is released.
+     * @throws std::bad_alloc
+     *         When no memory is available.
+     */
+    void* allocate(size_t size, size_t alignment = ALIGNMENT);
+
+    /**
+     * Copies a piece of text into this arena.
+     *
+     * @param data
+     *        Text.
+     * @param length
+     *        Number of characters.
+     * @returns Copy of the text, which is not <code>NUL</code>-terminated.
+     */
+    const char* copyText(const char* data, size_t length);
+
+    /**
+     * Registers an object allocated in this arena to be destroyed when the
+     * arena is released. Objects are destroyed in the reverse order of
+     * registration.
+     *
+     * @param object
+     *        Object.
+     * @returns The object.
+     */
+    template <class T>
+    T* track(T* object) {
+        Finalizer finalizer = { &destroy<T>, object };
+        _finalizers.push_back(finalizer);
+        return object;
+    }
+
+    /**
+     * Takes over all memory and registered objects of another arena, which is
+     * left empty. This allows an AST built in one arena to outlive it.
+     *
+     * @param other
+     *        Arena.
+     */
+    void splice(NodeArena* other);
+
+    /**
+     * Destroys the registered objects and releases all memory of this arena,
+     * which may then be used again.
+     */
+    void release(void);
+
+  public:
+    /**
+     * Default size of a block (in bytes).
+     */
+    static const size_t DEFAULT_BLOCK_SIZE;
+
+    /**
+     * Default alignment of an allocation, which suits any node.
+     */
+    static const size_t ALIGNMENT;
+
+  private:
+    /**
+     * \brief Header of a block of memory.
+     */
+    struct Block {
+        /**
+         * Next block, or \c NULL.
+         */
+        Block* next;
+    };
+
+    /**
+     * \brief Object to be destroyed when the arena is released.
+     */
+    struct Finalizer {
+        /**
+         * Function which destroys the object.
+         */
+        void (*destroy)(void*);
+
+        /**
+         * Object.
+         */
+        void* object;
+    };
+
+  private:
+    /**
+     * Allocates a new block and links it into the list of blocks.
+     *
+     * @param size
+     *        Usable size (in bytes).
+     * @returns First usable byte of the block.
+     */
+    char* allocateBlock(size_t size);
+
+    /**
+     * Destroys an object of a given type.
+     *
+     * @param object
+     *        Object.
+     */
+    template <class T>
+    static void destroy(void* object) {
+        static_cast<T*>(object)->~T();
+    }
+
+    /**
+     * Hidden copy constructor.
+     */
+    NodeArena(const NodeArena&);
+
+    /**
+     * Hidden assignment operator.
+     */
+    NodeArena& operator=(const NodeArena&);
+
+  private:
+    /**
+     * Size of each block (in bytes).
+     */
+    size_t _block_size;
+
+    /**
+     * Most recently allocated block, from which the other blocks are linked.
+     */
+    Block* _blocks;
+
+    /**
+     * Next free byte of the current block.
+     */
+    char* _next;
+
+    /**
+     * End of the current block.
+     */
+    char* _end;
+
+    /**
+     * Objects to be destroyed when the arena is released.
+     */
+    std::vector<Finalizer> _finalizers;
+};
+
+}
+
+#endif
@@ -0,0 +1,261 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CEE_AST_STATIC_VISITOR__H
+#define CEE_AST_STATIC_VISITOR__H
+
+/**
+ * @file
+ * @brief Defines a visitor whose hooks are resolved at compile time.
+ */
+
+#include "ast.hpp"
+#include "traversal.hpp"
+
+namespace AST {
+
+/**
+ * \brief AST visitor whose hooks are resolved at compile time.
+ *
+ * The StaticVisitor class is an alternative to the IVisitor for visitors
+ * whose class is known where the traversal starts. A visitor \c V derives
+ * from <code>StaticVisitor<V></code> (the <em>curiously recurring template
+ * pattern</em>) and defines the hooks it needs as non-virtual methods of the
+ * same name as in the IVisitor. traverse() finds the class of each node with
+ * Node::getType() and calls the hooks of \c V directly, so no call is
+ * virtual, and the hooks left undefined are the empty inline methods of this
+ * class which compile away. Like Node::accept(IVisitor*), it walks the tree
+ * with a Traversal, and calls the hooks in the same order.
+ *
+ * A method of \c V hides all methods of this class with the same name, so
+ * \c V must bring the other overloads of each hook it defines into scope with
+ * a using-declaration, e.g. <code>using AST::StaticVisitor<V>::visit;</code>.
+ * The hooks must be public.
+ */
+template <class Visitor>
+class StaticVisitor {
+  public:
+    /**
+     * Visits a node and all of its descendants.
+     *
+     * @param node
+     *        Node.
+     * @throws NodeError
+     *         When a hook fails, or the visit order is unknown.
+     */
+    void traverse(Node* node) throw(NodeError);
+
+    /**
+     * \copydoc IVisitor::preVisit(NProgram*)
+     */
+    void preVisit(NProgram* node) throw(NodeError) {}
+
+    /**
+     * \copydoc IVisitor::visit(NProgram*)
+     */
+    void visit(NProgram* node) throw(NodeError) {}
+
+    /**
+     * \copydoc IVisitor::postVisit(NProgram*)
+     */
+    void postVisit(NProgram* node) throw(NodeError) {}
+
+    /**
+     * \copydoc IVisitor::preVisit(NStatementList*)
+     */
+    void preVisit(NStatementList* node) throw(NodeError) {}
+
+    /**
+     * \copydoc IVisitor::visit(NStatementList*)
+     */
+    void visit(NStatementList* node) throw(NodeError) {}
+
+    /**
+     * \copydoc IVisitor::postVisit(NStatementList*)
+     */
+    void postVisit(NStatementList* node) throw(NodeError) {}
+
+    /**
+     * \copydoc IVisitor::betweenChildren(NStatementList*)
+     */
+    void betweenChildren(NStatementList* node) throw(NodeError) {}
+
+    /**
+     * \copydoc IVisitor::getChildVisitOrder(NStatementList*)
+     *
+     * @returns IVisitor::NORMAL by default.
+     */
+    IVisitor::VisitOrder getChildVisitOrder(NStatementList* node)
+        throw(NodeError)
+    {
+        return IVisitor::NORMAL;
+    }
+
+    /**
+     * \copydoc IVisitor::preVisit(NAssignment*)
+     */
+    void preVisit(NAssignment* node) throw(NodeError) {}
+
+    /**
+     * \copydoc IVisitor::visit(NAssignment*)
+     */
+    void visit(NAssignment* node) throw(NodeError) {}
+
+    /**
+     * \copydoc IVisitor::postVisit(NAssignment*)
+     */
+    void postVisit(NAssignment* node) throw(NodeError) {}
+
+    /**
+     * \copydoc IVisitor::betweenChildren(NAssignment*)
+     */
+    void betweenChildren(NAssignment* node) throw(NodeError) {}
+
+    /**
+     * \copydoc IVisitor::getChildVisitOrder(NAssignment*)
+     *
+     * @returns IVisitor::NORMAL by default.
+     */
+    IVisitor::VisitOrder getChildVisitOrder(NAssignment* node)
+        throw(NodeError)
+    {
+        return IVisitor::NORMAL;
+    }
+
+    /**
+     * \copydoc IVisitor::preVisit(NPrint*)
+     */
+    void preVisit(NPrint* node) throw(NodeError) {}
+
+    /**
+     * \copydoc IVisitor::visit(NPrint*)
+     */
+    void visit(NPrint* node) throw(NodeError) {}
+
+    /**
+     * \copydoc IVisitor::postVisit(NPrint*)
+     */
+    void postVisit(NPrint* node) throw(NodeError) {}
+
+    /**
+     * \copydoc IVisitor::preVisit(NExpressionUnary*)
+     */
+    void preVisit(NExpressionUnary* node) throw(NodeError) {}
+
+    /**
+     * \copydoc IVisitor::visit(NExpressionUnary*)
+     */
+    void visit(NExpressionUnary* node) throw(NodeError) {}
+
+    /**
+     * \copydoc IVisitor::postVisit(NExpressionUnary*)
+     */
+    void postVisit(NExpressionUnary* node) throw(NodeError) {}
+
+    /**
+     * \copydoc IVisitor::preVisit(NExpressionBinary*)
+     */
+    void preVisit(NExpressionBinary* node) throw(NodeError) {}
+
+    /**
+     * \copydoc IVisitor::visit(NExpressionBinary*)
+     */
+    void visit(NExpressionBinary* node) throw(NodeError) {}
+
+    /**
+     * \copydoc IVisitor::postVisit(NExpressionBinary*)
+     */
+    void postVisit(NExpressionBinary* node) throw(NodeError) {}
+
+    /**
+     * \copydoc IVisitor::betweenChildren(NExpressionBinary*)
+     */
+    void betweenChildren(NExpressionBinary* node) throw(NodeError) {}
+
+    /**
+     * \copydoc IVisitor::getChildVisitOrder(NExpressionBinary*)
+     *
+     * @returns IVisitor::NORMAL by default.
+     */
+    IVisitor::VisitOrder getChildVisitOrder(NExpressionBinary* node)
+        throw(NodeError)
+    {
+        return IVisitor::NORMAL;
+    }
+
+    /**
+     * \copydoc IVisitor::preVisit(NVariable*)
+     */
+    void preVisit(NVariable* node) throw(NodeError) {}
+
+    /**
+     * \copydoc IVisitor::visit(NVariable*)
+     */
+    void visit(NVariable* node) throw(NodeError) {}
+
+    /**
+     * \copydoc IVisitor::postVisit(NVariable*)
+     */
+    void postVisit(NVariable* node) throw(NodeError) {}
+
+    /**
+     * \copydoc IVisitor::preVisit(NNumber*)
+     */
+    void preVisit(NNumber* node) throw(NodeError) {}
+
+    /**
+     * \copydoc IVisitor::visit(NNumber*)
+     */
+    void visit(NNumber* node) throw(NodeError) {}
+
+    /**
+     * \copydoc IVisitor::postVisit(NNumber*)
+     */
+    void postVisit(NNumber* node) throw(NodeError) {}
+
+  protected:
+    /**
+     * Destroys this visitor. It is not virtual, as a visitor is never
+     * destroyed through this class.
+     */
+    ~StaticVisitor(void) {}
+
+  private:
+    /**
+     * Traversal, which keeps its stack from one call of traverse() to the
+     * next.
+     */
+    Traversal<Visitor> _traversal;
+};
+
+template <class Visitor>
+void StaticVisitor<Visitor>::traverse(Node* node) throw(NodeError) {
+    _traversal.run(node, static_cast<Visitor*>(this));
+}
+
+}
+
+#endif
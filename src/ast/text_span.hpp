@@ -0,0 +1,164 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CEE_AST_TEXT_SPAN__H
+#define CEE_AST_TEXT_SPAN__H
+
+/**
+ * @file
+ * @brief Defines a non-owning reference to a piece of text.
+ */
+
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+/**
+ * \brief Non-owning reference to a piece of text.
+ *
+ * A TextSpan is a pointer and a length. It does not own the text, which need
+ * not be <code>NUL</code>-terminated, so the text must outlive the span. It
+ * is used for identifiers and numbers which refer directly into the source
+ * buffer, so that passing them around does not allocate.
+ */
+class TextSpan {
+  public:
+    /**
+     * Creates an empty span.
+     */
+    TextSpan(void) : _data(NULL), _length(0) {}
+
+    /**
+     * Creates a span.
+     *
+     * @param data
+     *        First character.
+     * @param length
+     *        Number of characters.
+     */
+    TextSpan(const char* data, size_t length)
+        : _data(data), _length(length) {}
+
+    /**
+     * Creates a span of the content of a string. The string must not be
+     * modified while the span is in use.
+     *
+     * @param str
+     *        String.
+     */
+    TextSpan(const std::string& str)
+        : _data(str.data()), _length(str.size()) {}
+
+    /**
+     * Gets the first character.
+     *
+     * @returns Pointer to the text.
+     */
+    const char* data(void) const {
+        return _data;
+    }
+
+    /**
+     * Gets the number of characters.
+     *
+     * @returns Length.
+     */
+    size_t length(void) const {
+        return _length;
+    }
+
+    /**
+     * Copies the text into a string.
+     *
+     * @returns Text.
+     */
+    std::string toString(void) const {
+        return std::string(_data, _length);
+    }
+
+    /**
+     * Checks whether two spans hold the same text.
+     *
+     * @param rhs
+     *        Other span.
+     * @returns \c true if the texts are equal.
+     */
+    bool operator==(const TextSpan& rhs) const {
+        return _length == rhs._length
+            && (_length == 0 || memcmp(_data, rhs._data, _length) == 0);
+    }
+
+    /**
+     * Checks whether two spans hold different text.
+     *
+     * @param rhs
+     *        Other span.
+     * @returns \c true if the texts differ.
+     */
+    bool operator!=(const TextSpan& rhs) const {
+        return !(*this == rhs);
+    }
+
+    /**
+     * Computes a hash of the text (FNV-1a), for hash tables keyed by text.
+     *
+     * @returns Hash, which is the same for equal texts.
+     */
+    size_t hash(void) const {
+        size_t value = 2166136261u;
+        for (size_t i = 0; i < _length; i++) {
+            value = (value ^ static_cast<unsigned char>(_data[i])) * 16777619u;
+        }
+        return value;
+    }
+
+  private:
+    /**
+     * First character.
+     */
+    const char* _data;
+
+    /**
+     * Number of characters.
+     */
+    size_t _length;
+};
+
+/**
+ * Writes the text of a span to a stream.
+ *
+ * @param os
+ *        Output stream.
+ * @param span
+ *        Span.
+ * @returns The output stream.
+ */
+inline std::ostream& operator<<(std::ostream& os, const TextSpan& span) {
+    return os.write(span.data(), span.length());
+}
+
+#endif
@@ -0,0 +1,651 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CEE_AST_TRAVERSAL__H
+#define CEE_AST_TRAVERSAL__H
+
+/**
+ * @file
+ * @brief Defines the traversal of an AST with bounded recursion.
+ */
+
+#include "ast.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace AST {
+
+/**
+ * \brief Traversal of an AST with bounded recursion.
+ *
+ * The Traversal class walks an AST by recursion down to MAX_RECURSION_DEPTH
+ * levels, which covers the expressions of ordinary programs and is the
+ * fastest way to walk them. Deeper subtrees are walked with an explicit stack
+ * of the work left to do (children to visit, and hooks to call after them),
+ * so that expressions nested many thousands of levels deep need no more
+ * native stack than shallow ones. On the explicit stack, the first child of
+ * a node is visited right away, so a chain of unary expressions, or the
+ * left-hand sides of a chain of binary expressions, are walked without
+ * touching the stack. The stack memory is kept from one traversal to the
+ * next.
+ *
+ * The hooks are called on a \c Visitor, in the order described by
+ * Node::accept(), whichever way a subtree is walked. With \c Visitor being
+ * IVisitor, every hook is a virtual call; with the class of a StaticVisitor,
+ * the hooks are resolved at compile time.
+ */
+template <class Visitor>
+class Traversal {
+  public:
+    /**
+     * Visits a node and all of its descendants. A hook may start another
+     * traversal with the same object.
+     *
+     * @param root
+     *        Node.
+     * @param visitor
+     *        Visitor.
+     * @throws NodeError
+     *         When a hook fails, or the visit order is unknown.
+     */
+    void run(Node* root, Visitor* visitor) throw(NodeError);
+
+  private:
+    /**
+     * Number of levels of the tree which are walked by recursion.
+     */
+    static const unsigned int MAX_RECURSION_DEPTH;
+
+    /**
+     * Defines the work that can be left to do for a node. Each kind of node
+     * has actions of its own, so that a task is dispatched with one switch.
+     */
+    enum Action {
+        /**
+         * Call \c betweenChildren() for an assignment, and visit its second
+         * child.
+         */
+        SECOND_CHILD_OF_ASSIGNMENT,
+
+        /**
+         * Call \c betweenChildren() for a binary expression, and visit its
+         * second child.
+         */
+        SECOND_CHILD_OF_BINARY,
+
+        /**
+         * Visit the next statement of a statement list, calling
+         * \c betweenChildren() first unless it is the first one.
+         */
+        NEXT_STATEMENT,
+
+        /**
+         * Call \c postVisit() for a program.
+         */
+        POST_VISIT_PROGRAM,
+
+        /**
+         * Call \c postVisit() for a statement list.
+         */
+        POST_VISIT_STATEMENT_LIST,
+
+        /**
+         * Call \c postVisit() for an assignment.
+         */
+        POST_VISIT_ASSIGNMENT,
+
+        /**
+         * Call \c postVisit() for a print statement.
+         */
+        POST_VISIT_PRINT,
+
+        /**
+         * Call \c postVisit() for a unary expression.
+         */
+        POST_VISIT_UNARY,
+
+        /**
+         * Call \c postVisit() for a binary expression.
+         */
+        POST_VISIT_BINARY
+    };
+
+    /**
+     * \brief Work left to do for a node.
+     */
+    struct Task {
+        /**
+         * Node.
+         */
+        Node* node;
+
+        /**
+         * Child to visit, for the actions which visit one.
+         */
+        Node* child;
+
+        /**
+         * Action.
+         */
+        Action action;
+    };
+
+    /**
+     * \brief Position in a statement list whose statements are being visited.
+     */
+    struct Cursor {
+        /**
+         * Next statement in normal order, or the statement after the next one
+         * in reversed order.
+         */
+        std::vector<NStatement*>::const_iterator next;
+
+        /**
+         * End of the statements in the visit order.
+         */
+        std::vector<NStatement*>::const_iterator end;
+
+        /**
+         * Whether the statements are visited in reversed order.
+         */
+        bool reversed;
+
+        /**
+         * Whether no statement has been visited yet.
+         */
+        bool first;
+    };
+
+  private:
+    /**
+     * Visits a node and all of its descendants by recursion, or with the
+     * explicit stack once the maximum depth is reached.
+     *
+     * @param node
+     *        Node.
+     * @param visitor
+     *        Visitor.
+     * @param depth
+     *        Depth of the node below the root of the traversal.
+     * @throws NodeError
+     *         When a hook fails, or the visit order is unknown.
+     */
+    void recurse(Node* node, Visitor* visitor, unsigned int depth)
+        throw(NodeError);
+
+    /**
+     * Visits the two children of a node by recursion, in the order given by
+     * the visitor, calling \c betweenChildren() in between.
+     *
+     * @param node
+     *        Node.
+     * @param first
+     *        Child visited first in IVisitor::NORMAL order.
+     * @param second
+     *        Child visited second in IVisitor::NORMAL order.
+     * @param visitor
+     *        Visitor.
+     * @param depth
+     *        Depth of the children below the root of the traversal.
+     * @throws NodeError
+     *         When a hook fails, or the visit order is unknown.
+     */
+    template <class T>
+    void recurseChildren(
+        T* node,
+        Node* first,
+        Node* second,
+        Visitor* visitor,
+        unsigned int depth) throw(NodeError);
+
+    /**
+     * Visits a node and all of its descendants with the explicit stack.
+     *
+     * @param root
+     *        Node.
+     * @param visitor
+     *        Visitor.
+     * @throws NodeError
+     *         When a hook fails, or the visit order is unknown.
+     */
+    void iterate(Node* root, Visitor* visitor) throw(NodeError);
+
+    /**
+     * Visits a node, and then its first child and so on, leaving the work
+     * for the other children on the explicit stack.
+     *
+     * @param node
+     *        Node.
+     * @param visitor
+     *        Visitor.
+     * @throws NodeError
+     *         When a hook fails, or the visit order is unknown.
+     */
+    void visit(Node* node, Visitor* visitor) throw(NodeError);
+
+    /**
+     * Visits the next statement of the innermost statement list, if any.
+     *
+     * @param list
+     *        Statement list node.
+     * @param visitor
+     *        Visitor.
+     * @throws NodeError
+     *         When a hook fails, or the visit order is unknown.
+     */
+    void visitNextStatement(NStatementList* list, Visitor* visitor)
+        throw(NodeError);
+
+    /**
+     * Pushes work for a node.
+     *
+     * @param action
+     *        Action.
+     * @param node
+     *        Node.
+     * @param child
+     *        Child to visit, or \c NULL.
+     */
+    void push(Action action, Node* node, Node* child = NULL);
+
+    /**
+     * Gets whether a visit order is reversed.
+     *
+     * @param order
+     *        Visit order.
+     * @returns \c true for IVisitor::REVERSED.
+     * @throws NodeError
+     *         When the visit order is unknown.
+     */
+    static bool isReversed(IVisitor::VisitOrder order) throw(NodeError);
+
+  private:
+    /**
+     * Work left to do, to be done from last to first.
+     */
+    std::vector<Task> _tasks;
+
+    /**
+     * Statement lists being visited, innermost last.
+     */
+    std::vector<Cursor> _cursors;
+};
+
+template <class Visitor>
+void Traversal<Visitor>::run(Node* root, Visitor* visitor) throw(NodeError) {
+    recurse(root, visitor, 0);
+}
+
+template <class Visitor>
+void Traversal<Visitor>::recurse(
+    Node* node,
+    Visitor* visitor,
+    unsigned int depth) throw(NodeError)
+{
+    if (depth >= MAX_RECURSION_DEPTH) {
+        iterate(node, visitor);
+        return;
+    }
+
+    switch (node->getType()) {
+        case Node::PROGRAM: {
+            NProgram* program = static_cast<NProgram*>(node);
+            visitor->preVisit(program);
+            visitor->visit(program);
+            recurse(program->getStatementList(), visitor, depth + 1);
+            visitor->postVisit(program);
+            break;
+        }
+
+        case Node::STATEMENT_LIST: {
+            NStatementList* list = static_cast<NStatementList*>(node);
+            const std::vector<NStatement*>& statements =
+                list->getStatements();
+            visitor->preVisit(list);
+            visitor->visit(list);
+            if (isReversed(visitor->getChildVisitOrder(list))) {
+                for (size_t i = statements.size(); i > 0; i--) {
+                    if (i < statements.size()) visitor->betweenChildren(list);
+                    recurse(statements[i - 1], visitor, depth + 1);
+                }
+            }
+            else {
+                for (size_t i = 0; i < statements.size(); i++) {
+                    if (i > 0) visitor->betweenChildren(list);
+                    recurse(statements[i], visitor, depth + 1);
+                }
+            }
+            visitor->postVisit(list);
+            break;
+        }
+
+        case Node::ASSIGNMENT: {
+            NAssignment* assignment = static_cast<NAssignment*>(node);
+            visitor->preVisit(assignment);
+            visitor->visit(assignment);
+            recurseChildren(assignment,
+                            assignment->getVariable(),
+                            assignment->getExpression(),
+                            visitor,
+                            depth + 1);
+            visitor->postVisit(assignment);
+            break;
+        }
+
+        case Node::PRINT: {
+            NPrint* print = static_cast<NPrint*>(node);
+            visitor->preVisit(print);
+            visitor->visit(print);
+            recurse(print->getExpression(), visitor, depth + 1);
+            visitor->postVisit(print);
+            break;
+        }
+
+        case Node::EXPRESSION_UNARY: {
+            NExpressionUnary* unary = static_cast<NExpressionUnary*>(node);
+            visitor->preVisit(unary);
+            visitor->visit(unary);
+            recurse(unary->getExpression(), visitor, depth + 1);
+            visitor->postVisit(unary);
+            break;
+        }
+
+        case Node::EXPRESSION_BINARY: {
+            NExpressionBinary* binary = static_cast<NExpressionBinary*>(node);
+            visitor->preVisit(binary);
+            visitor->visit(binary);
+            recurseChildren(binary,
+                            binary->getLhsExpression(),
+                            binary->getRhsExpression(),
+                            visitor,
+                            depth + 1);
+            visitor->postVisit(binary);
+            break;
+        }
+
+        case Node::NUMBER: {
+            NNumber* number = static_cast<NNumber*>(node);
+            visitor->preVisit(number);
+            visitor->visit(number);
+            visitor->postVisit(number);
+            break;
+        }
+
+        case Node::VARIABLE: {
+            NVariable* variable = static_cast<NVariable*>(node);
+            visitor->preVisit(variable);
+            visitor->visit(variable);
+            visitor->postVisit(variable);
+            break;
+        }
+
+        default:
+            throw NodeError("Unknown node type");
+    }
+}
+
+template <class Visitor>
+template <class T>
+void Traversal<Visitor>::recurseChildren(
+    T* node,
+    Node* first,
+    Node* second,
+    Visitor* visitor,
+    unsigned int depth) throw(NodeError)
+{
+    if (isReversed(visitor->getChildVisitOrder(node))) {
+        std::swap(first, second);
+    }
+    recurse(first, visitor, depth);
+    visitor->betweenChildren(node);
+    recurse(second, visitor, depth);
+}
+
+template <class Visitor>
+void Traversal<Visitor>::iterate(Node* root, Visitor* visitor)
+    throw(NodeError)
+{
+    // Work below the bases belongs to a traversal which is still running
+    size_t task_base = _tasks.size();
+    size_t cursor_base = _cursors.size();
+    try {
+        visit(root, visitor);
+        while (_tasks.size() > task_base) {
+            Task task = _tasks.back();
+            _tasks.pop_back();
+            switch (task.action) {
+                case SECOND_CHILD_OF_ASSIGNMENT: {
+                    visitor->betweenChildren(
+                        static_cast<NAssignment*>(task.node));
+                    visit(task.child, visitor);
+                    break;
+                }
+
+                case SECOND_CHILD_OF_BINARY: {
+                    visitor->betweenChildren(
+                        static_cast<NExpressionBinary*>(task.node));
+                    visit(task.child, visitor);
+                    break;
+                }
+
+                case NEXT_STATEMENT: {
+                    visitNextStatement(static_cast<NStatementList*>(task.node),
+                                       visitor);
+                    break;
+                }
+
+                case POST_VISIT_PROGRAM: {
+                    visitor->postVisit(static_cast<NProgram*>(task.node));
+                    break;
+                }
+
+                case POST_VISIT_STATEMENT_LIST: {
+                    visitor->postVisit(
+                        static_cast<NStatementList*>(task.node));
+                    break;
+                }
+
+                case POST_VISIT_ASSIGNMENT: {
+                    visitor->postVisit(static_cast<NAssignment*>(task.node));
+                    break;
+                }
+
+                case POST_VISIT_PRINT: {
+                    visitor->postVisit(static_cast<NPrint*>(task.node));
+                    break;
+                }
+
+                case POST_VISIT_UNARY: {
+                    visitor->postVisit(
+                        static_cast<NExpressionUnary*>(task.node));
+                    break;
+                }
+
+                case POST_VISIT_BINARY: {
+                    visitor->postVisit(
+                        static_cast<NExpressionBinary*>(task.node));
+                    break;
+                }
+            }
+        }
+    }
+    catch (NodeError&) {
+        _tasks.resize(task_base);
+        _cursors.resize(cursor_base);
+        throw;
+    }
+}
+
+template <class Visitor>
+void Traversal<Visitor>::visit(Node* node, Visitor* visitor)
+    throw(NodeError)
+{
+    for (;;) {
+        switch (node->getType()) {
+            case Node::PROGRAM: {
+                NProgram* program = static_cast<NProgram*>(node);
+                visitor->preVisit(program);
+                visitor->visit(program);
+                push(POST_VISIT_PROGRAM, node);
+                node = program->getStatementList();
+                break;
+            }
+
+            case Node::STATEMENT_LIST: {
+                NStatementList* list = static_cast<NStatementList*>(node);
+                const std::vector<NStatement*>& statements =
+                    list->getStatements();
+                visitor->preVisit(list);
+                visitor->visit(list);
+                Cursor cursor;
+                cursor.reversed =
+                    isReversed(visitor->getChildVisitOrder(list));
+                cursor.next = cursor.reversed ? statements.end()
+                                              : statements.begin();
+                cursor.end = cursor.reversed ? statements.begin()
+                                             : statements.end();
+                cursor.first = true;
+                _cursors.push_back(cursor);
+                push(POST_VISIT_STATEMENT_LIST, node);
+                visitNextStatement(list, visitor);
+                return;
+            }
+
+            case Node::ASSIGNMENT: {
+                NAssignment* assignment = static_cast<NAssignment*>(node);
+                visitor->preVisit(assignment);
+                visitor->visit(assignment);
+                Node* first = assignment->getVariable();
+                Node* second = assignment->getExpression();
+                if (isReversed(visitor->getChildVisitOrder(assignment))) {
+                    std::swap(first, second);
+                }
+                push(POST_VISIT_ASSIGNMENT, node);
+                push(SECOND_CHILD_OF_ASSIGNMENT, node, second);
+                node = first;
+                break;
+            }
+
+            case Node::PRINT: {
+                NPrint* print = static_cast<NPrint*>(node);
+                visitor->preVisit(print);
+                visitor->visit(print);
+                push(POST_VISIT_PRINT, node);
+                node = print->getExpression();
+                break;
+            }
+
+            case Node::EXPRESSION_UNARY: {
+                NExpressionUnary* unary = static_cast<NExpressionUnary*>(node);
+                visitor->preVisit(unary);
+                visitor->visit(unary);
+                push(POST_VISIT_UNARY, node);
+                node = unary->getExpression();
+                break;
+            }
+
+            case Node::EXPRESSION_BINARY: {
+                NExpressionBinary* binary =
+                    static_cast<NExpressionBinary*>(node);
+                visitor->preVisit(binary);
+                visitor->visit(binary);
+                Node* first = binary->getLhsExpression();
+                Node* second = binary->getRhsExpression();
+                if (isReversed(visitor->getChildVisitOrder(binary))) {
+                    std::swap(first, second);
+                }
+                push(POST_VISIT_BINARY, node);
+                push(SECOND_CHILD_OF_BINARY, node, second);
+                node = first;
+                break;
+            }
+
+            case Node::NUMBER: {
+                NNumber* number = static_cast<NNumber*>(node);
+                visitor->preVisit(number);
+                visitor->visit(number);
+                visitor->postVisit(number);
+                return;
+            }
+
+            case Node::VARIABLE: {
+                NVariable* variable = static_cast<NVariable*>(node);
+                visitor->preVisit(variable);
+                visitor->visit(variable);
+                visitor->postVisit(variable);
+                return;
+            }
+
+            default:
+                throw NodeError("Unknown node type");
+        }
+    }
+}
+
+template <class Visitor>
+void Traversal<Visitor>::visitNextStatement(
+    NStatementList* list,
+    Visitor* visitor) throw(NodeError)
+{
+    Cursor& cursor = _cursors.back();
+    if (cursor.next == cursor.end) {
+        _cursors.pop_back();
+        return;
+    }
+    if (!cursor.first) visitor->betweenChildren(list);
+    cursor.first = false;
+    Node* statement = cursor.reversed ? *--cursor.next : *cursor.next++;
+    push(NEXT_STATEMENT, list);
+    visit(statement, visitor);
+}
+
+template <class Visitor>
+void Traversal<Visitor>::push(Action action, Node* node, Node* child) {
+    Task task;
+    task.node = node;
+    task.child = child;
+    task.action = action;
+    _tasks.push_back(task);
+}
+
+template <class Visitor>
+bool Traversal<Visitor>::isReversed(IVisitor::VisitOrder order)
+    throw(NodeError)
+{
+    switch (order) {
+        case IVisitor::NORMAL:   return false;
+        case IVisitor::REVERSED: return true;
+        default:                 throw NodeError("Unknown visit order");
+    }
+}
+
+template <class Visitor>
+const unsigned int Traversal<Visitor>::MAX_RECURSION_DEPTH = 256;
+
+}
+
+#endif
@@ -0,0 +1,565 @@
+#include "parse_cache.hpp"
+#include "../io/file_writer.hpp"
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <unistd.h>
+
+using namespace AST;
+using std::ios_base;
+using std::map;
+using std::string;
+using std::vector;
+
+namespace {
+
+/**
+ * Magic bytes at the start of every cache file.
+ */
+const char MAGIC[8] = { 'C', 'E', 'E', 'P', 'A', 'R', 'S', 'E' };
+
+/**
+ * Copies an array into a file image.
+ *
+ * @param image
+ *        File image.
+ * @param position
+ *        Position of the array in the image.
+ * @param values
+ *        Array.
+ */
+template <class T>
+void copyArray(vector<char>* image, uint64_t position, const vector<T>& values)
+{
+    if (values.empty()) return;
+    memcpy(&(*image)[position], &values[0], values.size() * sizeof(T));
+}
+
+/**
+ * Checks whether a text is a number as the scanner finds it.
+ *
+ * @param text
+ *        Text.
+ * @returns \c true if it is a non-empty sequence of digits.
+ */
+bool isNumber(const TextSpan& text) {
+    if (text.length() == 0) return false;
+    for (size_t i = 0; i < text.length(); i++) {
+        if (text.data()[i] < '0' || text.data()[i] > '9') return false;
+    }
+    return true;
+}
+
+}
+
+ParseCache::ParseCache(const string& directory) : _directory(directory) {}
+
+ParseCache::~ParseCache(void) {}
+
+uint64_t ParseCache::hashSource(const char* data, size_t size) {
+    // FNV-1a over eight bytes at a time, folding the high half of the state
+    // back in so that every byte affects the low bits too
+    uint64_t hash = 14695981039346656037ULL ^ size;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * 1099511628211ULL;
+        hash ^= hash >> 32;
+    }
+    for (; i < size; i++) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+bool ParseCache::load(
+    uint64_t key,
+    size_t size,
+    ParseContext* context,
+    SymbolTable* symtab)
+{
+    MappedFile file;
+    Header header;
+    Layout layout;
+    if (!openFile(key, size, &file, &header, &layout)) return false;
+    const char* data = file.getData();
+
+    // The symbol table comes first, so that the variables are resolved as
+    // their nodes are created
+    vector<int> symbols(header.num_texts, -1);
+    if (!loadSymbols(data, header, layout, symtab, &symbols)) return false;
+    NProgram* program =
+        loadProgram(data, header, layout, symbols, context->getArena());
+    if (!program) {
+        symtab->clear();
+        return false;
+    }
+    context->setProgram(program);
+    return true;
+}
+
+bool ParseCache::load(
+    uint64_t key,
+    size_t size,
+    ParseContext* context,
+    FlatAst* ast,
+    SymbolTable* symtab)
+{
+    MappedFile file;
+    Header header;
+    Layout layout;
+    if (!openFile(key, size, &file, &header, &layout)) return false;
+    const char* data = file.getData();
+
+    vector<int> symbols(header.num_texts, -1);
+    if (!loadSymbols(data, header, layout, symtab, &symbols)) return false;
+    if (!loadFlatAst(data, header, layout, symbols, context->getArena(),
+                     ast))
+    {
+        ast->clear();
+        symtab->clear();
+        return false;
+    }
+    return true;
+}
+
+void ParseCache::store(
+    uint64_t key,
+    size_t size,
+    NProgram* program,
+    const SymbolTable& symtab) throw (ios_base::failure)
+{
+    FlatAst ast;
+    ast.build(program);
+    store(key, size, ast, symtab);
+}
+
+void ParseCache::store(
+    uint64_t key,
+    size_t size,
+    const FlatAst& ast,
+    const SymbolTable& symtab) throw (ios_base::failure)
+{
+    // Equal texts are stored once, which also covers the names of the
+    // symbols
+    vector<Text> texts;
+    string pool;
+    map<string, uint32_t> text_indices;
+    unsigned int num_nodes = ast.getNumNodes();
+    vector<uint32_t> offsets(num_nodes);
+    vector<uint32_t> values(num_nodes);
+    vector<unsigned char> kinds(num_nodes);
+    vector<unsigned char> operators(num_nodes);
+    for (unsigned int i = 0; i < num_nodes; i++) {
+        FlatAst::Kind kind = ast.getKind(i);
+        kinds[i] = kind;
+        operators[i] = ast.getOperator(i);
+        offsets[i] = ast.getOffset(i);
+        if (kind == FlatAst::BINARY) {
+            values[i] = ast.getLhs(i);
+        }
+        else if (kind == FlatAst::NUMBER
+                 || kind == FlatAst::VARIABLE
+                 || kind == FlatAst::ASSIGNMENT)
+        {
+            std::pair<map<string, uint32_t>::iterator, bool> result =
+                text_indices.insert(
+                    std::make_pair(ast.getText(i).toString(), texts.size()));
+            if (result.second) {
+                Text text = { static_cast<uint32_t>(pool.size()),
+                              static_cast<uint32_t>(ast.getText(i).length()) };
+                texts.push_back(text);
+                pool += result.first->first;
+            }
+            values[i] = result.first->second;
+        }
+    }
+    vector<Symbol> symbols;
+    for (size_t i = 0; i < symtab.getNumRecords(); i++) {
+        const SymbolTable::Record* record = symtab.getRecord(i);
+        string name = record->getName().toString();
+        std::pair<map<string, uint32_t>::iterator, bool> result =
+            text_indices.insert(std::make_pair(name, texts.size()));
+        if (result.second) {
+            Text text = { static_cast<uint32_t>(pool.size()),
+                          static_cast<uint32_t>(name.size()) };
+            texts.push_back(text);
+            pool += name;
+        }
+        Symbol symbol = { result.first->second,
+                          record->getOffset(),
+                          record->getMemoryIndex() };
+        symbols.push_back(symbol);
+    }
+
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.num_nodes = num_nodes;
+    header.key = key;
+    header.source_size = size;
+    header.num_texts = texts.size();
+    header.text_size = pool.size();
+    header.num_symbols = symbols.size();
+    Layout layout = computeLayout(header);
+    vector<char> image(layout.size);
+    copyArray(&image, layout.offsets, offsets);
+    copyArray(&image, layout.values, values);
+    copyArray(&image, layout.texts, texts);
+    copyArray(&image, layout.symbols, symbols);
+    copyArray(&image, layout.kinds, kinds);
+    copyArray(&image, layout.operators, operators);
+    if (!pool.empty()) memcpy(&image[layout.pool], pool.data(), pool.size());
+    header.checksum = hashSource(&image[sizeof(Header)],
+                                 layout.size - sizeof(Header));
+    memcpy(&image[0], &header, sizeof(header));
+
+    // The file is written under a name of its own, and then renamed into
+    // place
+    string path = getPath(key);
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%ld.tmp", static_cast<long>(getpid()));
+    string temporary = path + suffix;
+    try {
+        FileWriter writer;
+        writer.open(temporary);
+        writer << image;
+        writer.close();
+    }
+    catch (ios_base::failure) {
+        unlink(temporary.c_str());
+        throw;
+    }
+    if (rename(temporary.c_str(), path.c_str()) != 0) {
+        unlink(temporary.c_str());
+        throw ios_base::failure("Failed to write " + path);
+    }
+}
+
+string ParseCache::getPath(uint64_t key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.ast",
+             static_cast<unsigned long long>(key));
+    return _directory + "/" + name;
+}
+
+bool ParseCache::openFile(
+    uint64_t key,
+    size_t size,
+    MappedFile* file,
+    Header* header,
+    Layout* layout) const
+{
+    try {
+        file->open(getPath(key));
+    }
+    catch (ios_base::failure) {
+        return false;
+    }
+    if (file->getSize() < sizeof(Header)) return false;
+    const char* data = file->getData();
+    memcpy(header, data, sizeof(*header));
+    if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0
+        || header->version != FORMAT_VERSION
+        || header->key != key
+        || header->source_size != size)
+    {
+        return false;
+    }
+    *layout = computeLayout(*header);
+    if (layout->size != file->getSize()
+        || header->checksum != hashSource(data + sizeof(Header),
+                                          layout->size - sizeof(Header)))
+    {
+        return false;
+    }
+
+    // Every text must lie within the pool, so that the nodes and records can
+    // refer to them unchecked
+    const Text* texts = reinterpret_cast<const Text*>(data + layout->texts);
+    for (uint32_t i = 0; i < header->num_texts; i++) {
+        if (texts[i].start > header->text_size
+            || texts[i].length > header->text_size - texts[i].start)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+ParseCache::Layout ParseCache::computeLayout(const Header& header) {
+    // The 4-byte arrays come first, right after the 8-byte aligned header,
+    // so that no padding is needed
+    Layout layout;
+    uint64_t position = sizeof(Header);
+    layout.offsets = position;
+    position += header.num_nodes * static_cast<uint64_t>(sizeof(uint32_t));
+    layout.values = position;
+    position += header.num_nodes * static_cast<uint64_t>(sizeof(uint32_t));
+    layout.texts = position;
+    position += header.num_texts * static_cast<uint64_t>(sizeof(Text));
+    layout.symbols = position;
+    position += header.num_symbols * static_cast<uint64_t>(sizeof(Symbol));
+    layout.kinds = position;
+    position += header.num_nodes;
+    layout.operators = position;
+    position += header.num_nodes;
+    layout.pool = position;
+    position += header.text_size;
+    layout.size = position;
+    return layout;
+}
+
+NProgram* ParseCache::loadProgram(
+    const char* data,
+    const Header& header,
+    const Layout& layout,
+    const vector<int>& symbols,
+    NodeArena* arena)
+{
+    const uint32_t* offsets =
+        reinterpret_cast<const uint32_t*>(data + layout.offsets);
+    const uint32_t* values =
+        reinterpret_cast<const uint32_t*>(data + layout.values);
+    const Text* texts = reinterpret_cast<const Text*>(data + layout.texts);
+    const unsigned char* kinds =
+        reinterpret_cast<const unsigned char*>(data + layout.kinds);
+    const unsigned char* operators =
+        reinterpret_cast<const unsigned char*>(data + layout.operators);
+    const char* pool = arena->copyText(data + layout.pool, header.text_size);
+
+    // The nodes come in post-order, so the operands of every expression and
+    // statement are the topmost expressions on the stack
+    NStatementList* statements = NULL;
+    vector<NExpression*> stack;
+    for (uint32_t i = 0; i < header.num_nodes; i++) {
+        unsigned int offset = offsets[i];
+        uint32_t value = values[i];
+        ExpressionOperator op = static_cast<ExpressionOperator>(operators[i]);
+        if (operators[i] > DIV) return NULL;
+        TextSpan text;
+        if (value < header.num_texts) {
+            text = TextSpan(pool + texts[value].start, texts[value].length);
+        }
+
+        NStatement* statement = NULL;
+        switch (kinds[i]) {
+            case FlatAst::NUMBER: {
+                // The code generator relies on numbers being digits only
+                if (value >= header.num_texts || !isNumber(text)) return NULL;
+                stack.push_back(new (arena) NNumber(text, offset));
+                break;
+            }
+
+            case FlatAst::VARIABLE: {
+                if (value >= header.num_texts) return NULL;
+                NVariable* variable = new (arena) NVariable(text, offset);
+                variable->setSymbol(symbols[value]);
+                stack.push_back(variable);
+                break;
+            }
+
+            case FlatAst::UNARY_START: {
+                break;
+            }
+
+            case FlatAst::UNARY: {
+                if (stack.empty()) return NULL;
+                stack.back() =
+                    new (arena) NExpressionUnary(op, stack.back(), offset);
+                break;
+            }
+
+            case FlatAst::BINARY: {
+                if (stack.size() < 2) return NULL;
+                NExpression* rhs = stack.back();
+                stack.pop_back();
+                stack.back() = new (arena)
+                    NExpressionBinary(stack.back(), op, rhs, offset);
+                break;
+            }
+
+            case FlatAst::ASSIGNMENT: {
+                if (value >= header.num_texts || stack.size() != 1) {
+                    return NULL;
+                }
+                NVariable* variable = new (arena) NVariable(text, offset);
+                variable->setSymbol(symbols[value]);
+                statement =
+                    new (arena) NAssignment(variable, stack.back(), offset);
+                break;
+            }
+
+            case FlatAst::PRINT: {
+                if (stack.size() != 1) return NULL;
+                statement = new (arena) NPrint(stack.back(), offset);
+                break;
+            }
+
+            default:
+                return NULL;
+        }
+
+        if (statement) {
+            // The statement list is located at its first statement
+            if (!statements) {
+                statements = arena->track(new (arena) NStatementList(offset));
+            }
+            (*statements) << statement;
+            stack.clear();
+        }
+    }
+    if (!statements || !stack.empty()) return NULL;
+    return new (arena) NProgram(statements, statements->getOffset());
+}
+
+bool ParseCache::loadFlatAst(
+    const char* data,
+    const Header& header,
+    const Layout& layout,
+    const vector<int>& symbols,
+    NodeArena* arena,
+    FlatAst* ast)
+{
+    const uint32_t* offsets =
+        reinterpret_cast<const uint32_t*>(data + layout.offsets);
+    const uint32_t* values =
+        reinterpret_cast<const uint32_t*>(data + layout.values);
+    const Text* texts = reinterpret_cast<const Text*>(data + layout.texts);
+    const unsigned char* kinds =
+        reinterpret_cast<const unsigned char*>(data + layout.kinds);
+    const unsigned char* operators =
+        reinterpret_cast<const unsigned char*>(data + layout.operators);
+    const char* pool = arena->copyText(data + layout.pool, header.text_size);
+
+    // The nodes are taken over as they are, but the passes over a flat AST
+    // trust its structure, so it is checked with a stack of the expressions
+    // (by their last node) and the negations waiting for their operand
+    const uint32_t UNARY_MARK = UINT_MAX;
+    ast->clear();
+    vector<uint32_t> stack;
+    for (uint32_t i = 0; i < header.num_nodes; i++) {
+        unsigned int offset = offsets[i];
+        uint32_t value = values[i];
+        ExpressionOperator op = static_cast<ExpressionOperator>(operators[i]);
+        if (operators[i] > DIV) return false;
+        TextSpan text;
+        if (value < header.num_texts) {
+            text = TextSpan(pool + texts[value].start, texts[value].length);
+        }
+
+        size_t depth = stack.size();
+        switch (kinds[i]) {
+            case FlatAst::NUMBER: {
+                // The code generator relies on numbers being digits only
+                if (value >= header.num_texts || !isNumber(text)) {
+                    return false;
+                }
+                stack.push_back(ast->append(FlatAst::NUMBER, op, offset,
+                                            ast->appendText(text)));
+                break;
+            }
+
+            case FlatAst::VARIABLE: {
+                if (value >= header.num_texts) return false;
+                stack.push_back(ast->append(
+                    FlatAst::VARIABLE, op, offset,
+                    ast->appendText(text, symbols[value])));
+                break;
+            }
+
+            case FlatAst::UNARY_START: {
+                ast->append(FlatAst::UNARY_START, op, offset, 0);
+                stack.push_back(UNARY_MARK);
+                break;
+            }
+
+            case FlatAst::UNARY: {
+                if (depth < 2 || stack[depth - 1] == UNARY_MARK
+                    || stack[depth - 2] != UNARY_MARK)
+                {
+                    return false;
+                }
+                stack.pop_back();
+                stack.back() = ast->append(FlatAst::UNARY, op, offset, 0);
+                break;
+            }
+
+            case FlatAst::BINARY: {
+                if (depth < 2 || stack[depth - 1] == UNARY_MARK
+                    || stack[depth - 2] == UNARY_MARK
+                    || value != stack[depth - 2])
+                {
+                    return false;
+                }
+                stack.pop_back();
+                stack.back() = ast->append(FlatAst::BINARY, op, offset, value);
+                break;
+            }
+
+            case FlatAst::ASSIGNMENT: {
+                if (value >= header.num_texts || depth != 1
+                    || stack[0] == UNARY_MARK)
+                {
+                    return false;
+                }
+                ast->appendStatement(ast->append(
+                    FlatAst::ASSIGNMENT, op, offset,
+                    ast->appendText(text, symbols[value])));
+                stack.clear();
+                break;
+            }
+
+            case FlatAst::PRINT: {
+                if (depth != 1 || stack[0] == UNARY_MARK) return false;
+                ast->appendStatement(
+                    ast->append(FlatAst::PRINT, op, offset, 0));
+                stack.clear();
+                break;
+            }
+
+            default:
+                return false;
+        }
+    }
+    return ast->getNumStatements() > 0 && stack.empty();
+}
+
+bool ParseCache::loadSymbols(
+    const char* data,
+    const Header& header,
+    const Layout& layout,
+    SymbolTable* symtab,
+    vector<int>* text_symbols)
+{
+    const Text* texts = reinterpret_cast<const Text*>(data + layout.texts);
+    const Symbol* symbols =
+        reinterpret_cast<const Symbol*>(data + layout.symbols);
+    const char* pool = data + layout.pool;
+    symtab->clear();
+    for (uint32_t i = 0; i < header.num_symbols; i++) {
+        if (symbols[i].name >= header.num_texts
+            || symbols[i].memory_index < 0)
+        {
+            symtab->clear();
+            return false;
+        }
+        const Text& text = texts[symbols[i].name];
+        TextSpan name(pool + text.start, text.length);
+        if (!symtab->insert(name, symbols[i].offset)) {
+            symtab->clear();
+            return false;
+        }
+        symtab->getRecord(i)->setMemoryIndex(symbols[i].memory_index);
+        (*text_symbols)[symbols[i].name] = static_cast<int>(i);
+    }
+    return true;
+}
+
+const uint32_t ParseCache::FORMAT_VERSION = 1;
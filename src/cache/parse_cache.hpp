@@ -0,0 +1,456 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CEE_CACHE_PARSE_CACHE__H
+#define CEE_CACHE_PARSE_CACHE__H
+
+/**
+ * @file
+ * @brief Defines the cache of parsed programs and their symbol tables.
+ */
+
+#include "../ast/ast.hpp"
+#include "../ast/flat_ast.hpp"
+#include "../grammar/parse_context.hpp"
+#include "../io/mapped_file.hpp"
+#include "../symtab/symbol_table.hpp"
+#include <cstddef>
+#include <ios>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Cache of parsed programs and their symbol tables.
+ *
+ * The ParseCache class keeps the AST and the SymbolTable of a program in a
+ * directory, one file per source text, named after a hash of the source
+ * content. When the same source is compiled again, load() rebuilds the AST
+ * and the symbol table from the file, so scanning, parsing and building the
+ * symbol table are skipped entirely.
+ *
+ * A cache file is a binary image meant to be read in place from a mapping.
+ * After a fixed header come the arrays of a FlatAst (source offsets, values,
+ * kinds and operators, one entry per node in post-order), the table of
+ * texts, the symbol records and finally the text pool, each array aligned
+ * for its element type. Loading walks the node arrays once with a stack of
+ * expressions, creating the nodes in the NodeArena of a ParseContext, and
+ * copies the whole text pool into the arena in one piece. So loading takes
+ * time linear in the size of the file, and the only allocations are bump
+ * allocations in the arena. The node arrays can also be loaded into a
+ * FlatAst as they are, which only copies the text pool into the arena.
+ *
+ * A file is only used if its header matches the format version, the hash
+ * and the size of the source, if the rest of the file matches the checksum
+ * in the header, and if its content is consistent. Anything else is treated
+ * as a miss. The hash is not cryptographic, so the cache
+ * must not be shared with untrusted parties. Files are written under a
+ * temporary name and then renamed, so concurrent compilations never see a
+ * partial file.
+ */
+class ParseCache {
+  public:
+    /**
+     * Creates a cache.
+     *
+     * @param directory
+     *        Directory holding the cache files, which must exist.
+     */
+    ParseCache(const std::string& directory);
+
+    /**
+     * Destroys this cache. The files are kept.
+     */
+    ~ParseCache(void);
+
+    /**
+     * Computes the key of a source text.
+     *
+     * @param data
+     *        Source text.
+     * @param size
+     *        Size of the source text (in bytes).
+     * @returns Hash of the content.
+     */
+    static uint64_t hashSource(const char* data, size_t size);
+
+    /**
+     * Loads the AST and the symbol table of a source text, if cached. On
+     * success, the program is set in the context, with all nodes in its
+     * arena, and the symbol table holds the records which the
+     * SymbolTableBuilder produced for it.
+     *
+     * @param key
+     *        Key of the source text, from hashSource().
+     * @param size
+     *        Size of the source text (in bytes).
+     * @param context
+     *        Context receiving the AST.
+     * @param symtab
+     *        Symbol table receiving the records. It is cleared first.
+     * @returns \c true if the source was found in the cache.
+     */
+    bool load(
+        uint64_t key,
+        size_t size,
+        ParseContext* context,
+        SymbolTable* symtab);
+
+    /**
+     * Loads the flat AST and the symbol table of a source text, if cached,
+     * without building the pointer-based AST. On success, the texts of the
+     * flat AST are kept in the arena of the context, which gets no program,
+     * and its variables are resolved.
+     *
+     * @param key
+     *        Key of the source text, from hashSource().
+     * @param size
+     *        Size of the source text (in bytes).
+     * @param context
+     *        Context whose arena keeps the texts.
+     * @param ast
+     *        Flat AST receiving the nodes. It is cleared first.
+     * @param symtab
+     *        Symbol table receiving the records. It is cleared first.
+     * @returns \c true if the source was found in the cache.
+     */
+    bool load(
+        uint64_t key,
+        size_t size,
+        ParseContext* context,
+        AST::FlatAst* ast,
+        SymbolTable* symtab);
+
+    /**
+     * Stores the AST and the symbol table of a source text, replacing any
+     * earlier file for it.
+     *
+     * @param key
+     *        Key of the source text, from hashSource().
+     * @param size
+     *        Size of the source text (in bytes).
+     * @param program
+     *        Program node. Shared expressions are stored once per use.
+     * @param symtab
+     *        Symbol table built for the program.
+     * @throws std::ios_base::failure
+     *         When the file cannot be written.
+     */
+    void store(
+        uint64_t key,
+        size_t size,
+        AST::NProgram* program,
+        const SymbolTable& symtab) throw (std::ios_base::failure);
+
+    /**
+     * Stores the flat AST and the symbol table of a source text, replacing
+     * any earlier file for it.
+     *
+     * @param key
+     *        Key of the source text, from hashSource().
+     * @param size
+     *        Size of the source text (in bytes).
+     * @param ast
+     *        Flat AST.
+     * @param symtab
+     *        Symbol table built for the program.
+     * @throws std::ios_base::failure
+     *         When the file cannot be written.
+     */
+    void store(
+        uint64_t key,
+        size_t size,
+        const AST::FlatAst& ast,
+        const SymbolTable& symtab) throw (std::ios_base::failure);
+
+    /**
+     * Gets the path of the file of a source text.
+     *
+     * @param key
+     *        Key of the source text.
+     * @returns File path.
+     */
+    std::string getPath(uint64_t key) const;
+
+  public:
+    /**
+     * Version of the file format, which changes whenever the layout does.
+     */
+    static const uint32_t FORMAT_VERSION;
+
+  private:
+    /**
+     * \brief Header of a cache file.
+     */
+    struct Header {
+        /**
+         * Magic bytes, identifying the file type.
+         */
+        char magic[8];
+
+        /**
+         * Version of the file format. As it is stored in the byte order of
+         * the host, it also tells apart files of the other byte order.
+         */
+        uint32_t version;
+
+        /**
+         * Number of nodes.
+         */
+        uint32_t num_nodes;
+
+        /**
+         * Key of the source text.
+         */
+        uint64_t key;
+
+        /**
+         * Size of the source text (in bytes).
+         */
+        uint64_t source_size;
+
+        /**
+         * Number of entries in the table of texts.
+         */
+        uint32_t num_texts;
+
+        /**
+         * Size of the text pool (in bytes).
+         */
+        uint32_t text_size;
+
+        /**
+         * Number of symbol records.
+         */
+        uint32_t num_symbols;
+
+        /**
+         * Unused, always 0.
+         */
+        uint32_t reserved;
+
+        /**
+         * Hash of the rest of the file.
+         */
+        uint64_t checksum;
+    };
+
+    /**
+     * \brief Entry of the table of texts.
+     */
+    struct Text {
+        /**
+         * Position of the text in the text pool.
+         */
+        uint32_t start;
+
+        /**
+         * Number of characters.
+         */
+        uint32_t length;
+    };
+
+    /**
+     * \brief Symbol record.
+     */
+    struct Symbol {
+        /**
+         * Index of the name in the table of texts.
+         */
+        uint32_t name;
+
+        /**
+         * Source offset at which the variable was declared.
+         */
+        uint32_t offset;
+
+        /**
+         * Memory index of the variable.
+         */
+        int32_t memory_index;
+    };
+
+    /**
+     * \brief Location of the arrays of a cache file.
+     */
+    struct Layout {
+        /**
+         * Position of the source offsets.
+         */
+        uint64_t offsets;
+
+        /**
+         * Position of the values.
+         */
+        uint64_t values;
+
+        /**
+         * Position of the table of texts.
+         */
+        uint64_t texts;
+
+        /**
+         * Position of the symbol records.
+         */
+        uint64_t symbols;
+
+        /**
+         * Position of the kinds.
+         */
+        uint64_t kinds;
+
+        /**
+         * Position of the operators.
+         */
+        uint64_t operators;
+
+        /**
+         * Position of the text pool.
+         */
+        uint64_t pool;
+
+        /**
+         * Size of the file.
+         */
+        uint64_t size;
+    };
+
+  private:
+    /**
+     * Opens the file of a source text, and checks that it matches the source
+     * and is intact.
+     *
+     * @param key
+     *        Key of the source text.
+     * @param size
+     *        Size of the source text (in bytes).
+     * @param file
+     *        File to open, which must be kept open while its content is used.
+     * @param header
+     *        Destination of the header of the file.
+     * @param layout
+     *        Destination of the layout of the file.
+     * @returns \c true if the file can be loaded.
+     */
+    bool openFile(
+        uint64_t key,
+        size_t size,
+        MappedFile* file,
+        Header* header,
+        Layout* layout) const;
+
+    /**
+     * Computes the layout of a cache file.
+     *
+     * @param header
+     *        Header of the file.
+     * @returns Layout.
+     */
+    static Layout computeLayout(const Header& header);
+
+    /**
+     * Rebuilds the AST of a cache file which has been found to match, and
+     * whose table of texts has been checked.
+     *
+     * @param data
+     *        Content of the file.
+     * @param header
+     *        Header of the file.
+     * @param layout
+     *        Layout of the file.
+     * @param symbols
+     *        Symbol id of each text, or -1, with which the variables are
+     *        resolved.
+     * @param arena
+     *        Arena in which the nodes are created.
+     * @returns Program node, or \c NULL if the file was inconsistent.
+     */
+    static AST::NProgram* loadProgram(
+        const char* data,
+        const Header& header,
+        const Layout& layout,
+        const std::vector<int>& symbols,
+        AST::NodeArena* arena);
+
+    /**
+     * Fills a flat AST from a cache file which has been found to match, and
+     * whose table of texts has been checked.
+     *
+     * @param data
+     *        Content of the file.
+     * @param header
+     *        Header of the file.
+     * @param layout
+     *        Layout of the file.
+     * @param symbols
+     *        Symbol id of each text, or -1, with which the variables are
+     *        resolved.
+     * @param arena
+     *        Arena in which the texts are kept.
+     * @param ast
+     *        Flat AST receiving the nodes.
+     * @returns \c false if the file was inconsistent.
+     */
+    static bool loadFlatAst(
+        const char* data,
+        const Header& header,
+        const Layout& layout,
+        const std::vector<int>& symbols,
+        AST::NodeArena* arena,
+        AST::FlatAst* ast);
+
+    /**
+     * Rebuilds the symbol table of a cache file which has been found to
+     * match, and whose table of texts has been checked.
+     *
+     * @param data
+     *        Content of the file.
+     * @param header
+     *        Header of the file.
+     * @param layout
+     *        Layout of the file.
+     * @param symtab
+     *        Symbol table receiving the records.
+     * @param text_symbols
+     *        Symbol id of each text, which is set for the names of the
+     *        records and must otherwise be -1.
+     * @returns \c true if the file was consistent.
+     */
+    static bool loadSymbols(
+        const char* data,
+        const Header& header,
+        const Layout& layout,
+        SymbolTable* symtab,
+        std::vector<int>* text_symbols);
+
+  private:
+    /**
+     * Directory holding the cache files.
+     */
+    std::string _directory;
+};
+
+#endif
@@ -1,18 +1,115 @@
-
 #include "decoder.hpp"
 #include "../generator/code_listing.hpp"
 #include "../io/reporter.hpp"
 
-Decoder::Decoder(void) {
-    /* TASK: Add whatever code you find necessary */
-}
+using std::vector;
 
-Decoder::~Decoder(void) {
-    /* TASK: Add whatever code you find necessary */
-}
+Decoder::Decoder(void) : _program(NULL), _pc(0) {}
+
+Decoder::~Decoder(void) {}
 
 void Decoder::invoke(const vector<char>& program) {
-    /* TASK: Implement this method */
+    _program = &program;
+    _pc = 0;
+
+    if (!prepareEnvironment()) return;
+    if (getProgramSize() < HEADER_SIZE) {
+        Reporter& out = *Reporter::getInstance();
+        out << out.beginError() << "Program is too small to contain a header"
+            << out.endl();
+        return;
+    }
+    if (!processMagicNumber(readInt(0))) return;
+    if (!processMemorySize(readInt(4))) return;
+    if (!beforeCodeExecution()) return;
+
+    const int size = getProgramSize();
+    for (_pc = HEADER_SIZE; _pc < size; ) {
+        bool result;
+        int next_pc = _pc + 1;
+        char inst = program[_pc];
+        switch (inst) {
+            case CodeListing::LOAD: {
+                result = processInstLOAD();
+                break;
+            }
+
+            case CodeListing::STORE: {
+                result = processInstSTORE();
+                break;
+            }
+
+            case CodeListing::CONST_1B: {
+                if (!hasConstValue(1)) return;
+                result = processInstCONST_1B(program[_pc + 1]);
+                next_pc += 1;
+                break;
+            }
+
+            case CodeListing::CONST_2B: {
+                if (!hasConstValue(2)) return;
+                result = processInstCONST_2B(readShort(_pc + 1));
+                next_pc += 2;
+                break;
+            }
+
+            case CodeListing::CONST_4B: {
+                if (!hasConstValue(4)) return;
+                result = processInstCONST_4B(readInt(_pc + 1));
+                next_pc += 4;
+                break;
+            }
+
+            case CodeListing::CONST_0: {
+                result = processInstCONST_0();
+                break;
+            }
+
+            case CodeListing::CONST_1: {
+                result = processInstCONST_1();
+                break;
+            }
+
+            case CodeListing::ADD: {
+                result = processInstADD();
+                break;
+            }
+
+            case CodeListing::SUB: {
+                result = processInstSUB();
+                break;
+            }
+
+            case CodeListing::MUL: {
+                result = processInstMUL();
+                break;
+            }
+
+            case CodeListing::DIV: {
+                result = processInstDIV();
+                break;
+            }
+
+            case CodeListing::SWAP: {
+                result = processInstSWAP();
+                break;
+            }
+
+            case CodeListing::PRINT: {
+                result = processInstPRINT();
+                break;
+            }
+
+            default: {
+                result = processInstUnknown(inst);
+                break;
+            }
+        }
+        if (!result) return;
+        _pc = next_pc;
+    }
+
+    afterCodeExecution();
 }
 
 bool Decoder::beforeCodeExecution(void) {
@@ -25,14 +122,39 @@ bool Decoder::afterCodeExecution(void) {
 
 
 int Decoder::getPC(void) const {
-    /* TASK: Implement this method */
+    return _pc;
 }
 
 int Decoder::getPCAtEndOfProgram(void) const {
-    /* TASK: Implement this method */
+    return getProgramSize() > 0 ? getProgramSize() - 1 : 0;
 }
 
 int Decoder::getProgramSize(void) const {
-    /* TASK: Implement this method */
+    return _program ? static_cast<int>(_program->size()) : 0;
+}
+
+int Decoder::readInt(int offset) const {
+    const vector<char>& program = *_program;
+    return (static_cast<unsigned char>(program[offset])     << 24)
+         | (static_cast<unsigned char>(program[offset + 1]) << 16)
+         | (static_cast<unsigned char>(program[offset + 2]) <<  8)
+         |  static_cast<unsigned char>(program[offset + 3]);
+}
+
+short Decoder::readShort(int offset) const {
+    const vector<char>& program = *_program;
+    return static_cast<short>(
+        (static_cast<unsigned char>(program[offset]) << 8)
+        | static_cast<unsigned char>(program[offset + 1]));
+}
+
+bool Decoder::hasConstValue(int num_bytes) const {
+    if (_pc + num_bytes < getProgramSize()) return true;
+
+    Reporter& out = *Reporter::getInstance();
+    out << out.beginError() << "Missing constant value of instruction at "
+        << _pc << out.endl();
+    return false;
 }
 
+const int Decoder::HEADER_SIZE = 8;
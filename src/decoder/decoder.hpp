@@ -243,7 +243,49 @@ class Decoder {
     int getProgramSize(void) const;
 
   private:
-    /* TASK: Add whatever private members and methods you find necessary */
+    /**
+     * Reads a big-endian \c int from the program.
+     *
+     * @param offset
+     *        Offset of the first byte.
+     * @returns Value (in little-endian).
+     */
+    int readInt(int offset) const;
+
+    /**
+     * Reads a big-endian \c short from the program.
+     *
+     * @param offset
+     *        Offset of the first byte.
+     * @returns Value (in little-endian).
+     */
+    short readShort(int offset) const;
+
+    /**
+     * Checks that a constant value of a given size follows the current
+     * instruction, and reports an error if it does not.
+     *
+     * @param num_bytes
+     *        Size of the constant value.
+     * @returns \c true if the value is available.
+     */
+    bool hasConstValue(int num_bytes) const;
+
+  private:
+    /**
+     * Size of the program header (magic number and memory size).
+     */
+    static const int HEADER_SIZE;
+
+    /**
+     * Program currently being decoded.
+     */
+    const std::vector<char>* _program;
+
+    /**
+     * Program counter of the instruction currently being processed.
+     */
+    int _pc;
 };
 
 #endif
@@ -0,0 +1,107 @@
+#include "disassembler.hpp"
+#include <sstream>
+
+using std::map;
+using std::string;
+using std::stringstream;
+using std::vector;
+
+Disassembler::Disassembler(void) {}
+
+Disassembler::~Disassembler(void) {}
+
+void Disassembler::disassemble(const vector<char>& program) {
+    invoke(program);
+}
+
+string Disassembler::getInstruction(int pc) const {
+    map<int, string>::const_iterator it = _instructions.find(pc);
+    return it != _instructions.end() ? it->second : string();
+}
+
+unsigned int Disassembler::getNumInstructions(void) const {
+    return _instructions.size();
+}
+
+bool Disassembler::prepareEnvironment(void) {
+    _instructions.clear();
+    return true;
+}
+
+bool Disassembler::processMagicNumber(int number) {
+    return true;
+}
+
+bool Disassembler::processMemorySize(int value) {
+    return true;
+}
+
+bool Disassembler::processInstLOAD(void) {
+    return record("LOAD");
+}
+
+bool Disassembler::processInstSTORE(void) {
+    return record("STORE");
+}
+
+bool Disassembler::processInstCONST_1B(char value) {
+    return record("CONST_1B", value);
+}
+
+bool Disassembler::processInstCONST_2B(short value) {
+    return record("CONST_2B", value);
+}
+
+bool Disassembler::processInstCONST_4B(int value) {
+    return record("CONST_4B", value);
+}
+
+bool Disassembler::processInstCONST_0(void) {
+    return record("CONST_0");
+}
+
+bool Disassembler::processInstCONST_1(void) {
+    return record("CONST_1");
+}
+
+bool Disassembler::processInstADD(void) {
+    return record("ADD");
+}
+
+bool Disassembler::processInstSUB(void) {
+    return record("SUB");
+}
+
+bool Disassembler::processInstMUL(void) {
+    return record("MUL");
+}
+
+bool Disassembler::processInstDIV(void) {
+    return record("DIV");
+}
+
+bool Disassembler::processInstSWAP(void) {
+    return record("SWAP");
+}
+
+bool Disassembler::processInstPRINT(void) {
+    return record("PRINT");
+}
+
+bool Disassembler::processInstUnknown(char inst) {
+    stringstream ss;
+    ss << "Unknown instruction (0x" << std::hex << (short) (0x00FF & inst)
+       << ")";
+    return record(ss.str());
+}
+
+bool Disassembler::record(const string& text) {
+    _instructions[getPC()] = text;
+    return true;
+}
+
+bool Disassembler::record(const char* name, int value) {
+    stringstream ss;
+    ss << name << " (" << value << ")";
+    return record(ss.str());
+}
@@ -0,0 +1,200 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CEE_DECODER_DISASSEMBLER__H
+#define CEE_DECODER_DISASSEMBLER__H
+
+/**
+ * @file
+ * @brief Defines a decoder which disassembles a program.
+ */
+
+#include "decoder.hpp"
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Disassembles a program into readable text.
+ *
+ * The Disassembler class decodes a program once and keeps the text of every
+ * instruction, keyed by its program counter value. The text has the form
+ * <code>NAME</code> or <code>NAME (CONSTANT)</code>, as printed by the decoder
+ * test driver.
+ */
+class Disassembler : private Decoder {
+  public:
+    /**
+     * \copydoc Decoder::Decoder(void)
+     */
+    Disassembler(void);
+
+    /**
+     * \copydoc Decoder::~Decoder(void)
+     */
+    virtual ~Disassembler(void);
+
+    /**
+     * Disassembles a program. The text of any previously disassembled program
+     * is discarded.
+     *
+     * @param program
+     *        Program.
+     */
+    void disassemble(const std::vector<char>& program);
+
+    /**
+     * Gets the text of the instruction at a given program counter value.
+     *
+     * @param pc
+     *        Program counter value.
+     * @returns Instruction text, or an empty string if no instruction starts
+     *          at \c pc.
+     */
+    std::string getInstruction(int pc) const;
+
+    /**
+     * Gets the number of disassembled instructions.
+     *
+     * @returns Number of instructions.
+     */
+    unsigned int getNumInstructions(void) const;
+
+  protected:
+    /**
+     * \copydoc Decoder::prepareEnvironment(void)
+     */
+    virtual bool prepareEnvironment(void);
+
+    /**
+     * \copydoc Decoder::processMagicNumber(int)
+     */
+    virtual bool processMagicNumber(int number);
+
+    /**
+     * \copydoc Decoder::processMemorySize(int)
+     */
+    virtual bool processMemorySize(int value);
+
+    /**
+     * \copydoc Decoder::processInstLOAD(void)
+     */
+    virtual bool processInstLOAD(void);
+
+    /**
+     * \copydoc Decoder::processInstSTORE(void)
+     */
+    virtual bool processInstSTORE(void);
+
+    /**
+     * \copydoc Decoder::processInstCONST_1B(char)
+     */
+    virtual bool processInstCONST_1B(char value);
+
+    /**
+     * \copydoc Decoder::processInstCONST_2B(short)
+     */
+    virtual bool processInstCONST_2B(short value);
+
+    /**
+     * \copydoc Decoder::processInstCONST_4B(int)
+     */
+    virtual bool processInstCONST_4B(int value);
+
+    /**
+     * \copydoc Decoder::processInstCONST_0(void)
+     */
+    virtual bool processInstCONST_0(void);
+
+    /**
+     * \copydoc Decoder::processInstCONST_1(void)
+     */
+    virtual bool processInstCONST_1(void);
+
+    /**
+     * \copydoc Decoder::processInstADD(void)
+     */
+    virtual bool processInstADD(void);
+
+    /**
+     * \copydoc Decoder::processInstSUB(void)
+     */
+    virtual bool processInstSUB(void);
+
+    /**
+     * \copydoc Decoder::processInstMUL(void)
+     */
+    virtual bool processInstMUL(void);
+
+    /**
+     * \copydoc Decoder::processInstDIV(void)
+     */
+    virtual bool processInstDIV(void);
+
+    /**
+     * \copydoc Decoder::processInstSWAP(void)
+     */
+    virtual bool processInstSWAP(void);
+
+    /**
+     * \copydoc Decoder::processInstPRINT(void)
+     */
+    virtual bool processInstPRINT(void);
+
+    /**
+     * \copydoc Decoder::processInstUnknown(char)
+     */
+    virtual bool processInstUnknown(char inst);
+
+  private:
+    /**
+     * Records the text of the current instruction.
+     *
+     * @param text
+     *        Instruction text.
+     * @returns Always \c true.
+     */
+    bool record(const std::string& text);
+
+    /**
+     * Records the text of the current instruction with a constant value.
+     *
+     * @param name
+     *        Instruction name.
+     * @param value
+     *        Constant value.
+     * @returns Always \c true.
+     */
+    bool record(const char* name, int value);
+
+  private:
+    /**
+     * Instruction text per program counter value.
+     */
+    std::map<int, std::string> _instructions;
+};
+
+#endif
@@ -1,24 +1,408 @@
-
 #include "code_generator.hpp"
 #include "../io/reporter.hpp"
+#include <cstring>
+#include <sstream>
+#include <utility>
 
 using namespace AST;
+using std::stringstream;
 using std::vector;
 
 CodeGenerator::CodeGenerator(void)
+        : _symtab(NULL), _newlines(NULL), _lines(NULL), _line(1),
+          _line_start(0), _line_end(0), _left_side_mode(false),
+          _compiling(false)
+{}
+
+CodeGenerator::~CodeGenerator(void) {}
+
+bool CodeGenerator::generate(
+    NProgram* root,
+    const SymbolTable* symtab,
+    const NewlineIndex* newlines,
+    vector<char>* code,
+    LineTable* lines)
 {
-    /* TASK: Add whatever code you find necessary */
-}
+    begin(symtab, newlines, lines);
+    try {
+        traverse(root);
+    }
+    catch (NodeError& ex) {
+        Reporter& out = *Reporter::getInstance();
+        out << out.beginError() << ex.what() << out.endl();
+        return false;
+    }
 
-CodeGenerator::~CodeGenerator(void) {
-    /* TASK: Add whatever code you find necessary */
+    finish(code);
+    return true;
 }
 
 bool CodeGenerator::generate(
+    const FlatAst& ast,
+    const SymbolTable* symtab,
+    const NewlineIndex* newlines,
+    vector<char>* code,
+    LineTable* lines)
+{
+    begin(symtab, newlines, lines);
+    try {
+        // The nodes are in post-order, which is the order of the code
+        for (unsigned int i = 0; i < ast.getNumNodes(); i++) {
+            unsigned int offset = ast.getOffset(i);
+            switch (ast.getKind(i)) {
+                case FlatAst::NUMBER: {
+                    TextSpan number = ast.getText(i);
+                    appendConst(CodeListing::toInt(number.data(),
+                                                   number.length()),
+                                offset);
+                    break;
+                }
+
+                case FlatAst::VARIABLE: {
+                    const SymbolTable::Record* record =
+                        lookUp(ast.getSymbol(i), ast.getText(i), offset);
+                    appendConst(record->getMemoryIndex(), offset);
+                    append(CodeListing::LOAD, offset);
+                    break;
+                }
+
+                case FlatAst::UNARY_START: {
+                    if (ast.getOperator(i) != MINUS) {
+                        throw NodeError("Unsupported unary operator");
+                    }
+                    append(CodeListing::CONST_0, offset);
+                    break;
+                }
+
+                case FlatAst::UNARY: {
+                    append(CodeListing::SUB, offset);
+                    break;
+                }
+
+                case FlatAst::BINARY: {
+                    append(getBinaryInstruction(ast.getOperator(i)), offset);
+                    break;
+                }
+
+                case FlatAst::ASSIGNMENT: {
+                    const SymbolTable::Record* record =
+                        lookUp(ast.getSymbol(i), ast.getText(i), offset);
+                    appendConst(record->getMemoryIndex(), offset);
+                    append(CodeListing::STORE, offset);
+                    break;
+                }
+
+                case FlatAst::PRINT: {
+                    append(CodeListing::PRINT, offset);
+                    break;
+                }
+            }
+        }
+    }
+    catch (NodeError& ex) {
+        Reporter& out = *Reporter::getInstance();
+        out << out.beginError() << ex.what() << out.endl();
+        return false;
+    }
+
+    finish(code);
+    return true;
+}
+
+bool CodeGenerator::compile(
     NProgram* root,
+    SymbolTable* symtab,
+    const NewlineIndex* newlines,
+    vector<char>* code,
+    LineTable* lines)
+{
+    beginCompiling(symtab, newlines, lines);
+    try {
+        traverse(root);
+    }
+    catch (NodeError& ex) {
+        Reporter& out = *Reporter::getInstance();
+        out << out.beginError() << ex.what() << out.endl();
+        return false;
+    }
+
+    finish(code);
+    return true;
+}
+
+void CodeGenerator::begin(
     const SymbolTable* symtab,
-    vector<char>* code)
+    const NewlineIndex* newlines,
+    LineTable* lines)
+{
+    _listing = CodeListing();
+    _symtab = symtab;
+    _newlines = newlines;
+    _lines = lines;
+    _line_start = _line_end = 0;
+    _left_side_mode = false;
+    _compiling = false;
+    _fixups.clear();
+    if (_lines) _lines->clear();
+
+    // One memory location per variable
+    _listing.setNumMemoryLocations(countMemoryLocations());
+    _listing.generateInitCode();
+}
+
+void CodeGenerator::beginCompiling(
+    SymbolTable* symtab,
+    const NewlineIndex* newlines,
+    LineTable* lines)
+{
+    _symtab_builder.begin(symtab, newlines);
+    _allocator.begin(symtab);
+    begin(symtab, newlines, lines);
+    _compiling = true;
+}
+
+void CodeGenerator::addStatement(NStatement* node) throw(NodeError) {
+    _left_side_mode = false;
+    traverse(node);
+}
+
+void CodeGenerator::finish(vector<char>* code) {
+    if (_compiling) {
+        int num_locations = _allocator.assign();
+        _listing.updateNumMemoryLocations(num_locations);
+        link(code, num_locations);
+        return;
+    }
+    _listing.updateNumMemoryLocations(countMemoryLocations());
+    *code = _listing.getCode();
+}
+
+void CodeGenerator::preVisit(NAssignment* node) throw(NodeError) {
+    _left_side_mode = false;
+}
+
+IVisitor::VisitOrder CodeGenerator::getChildVisitOrder(NAssignment* node)
+    throw(NodeError)
 {
-     /* TASK: Implement this method */
+    return IVisitor::REVERSED;
 }
 
+void CodeGenerator::betweenChildren(NAssignment* node) throw(NodeError) {
+    _left_side_mode = true;
+}
+
+void CodeGenerator::postVisit(NAssignment* node) throw(NodeError) {
+    append(CodeListing::STORE, node->getOffset());
+    _left_side_mode = false;
+    if (_compiling) _allocator.endStatement();
+}
+
+void CodeGenerator::postVisit(NPrint* node) throw(NodeError) {
+    append(CodeListing::PRINT, node->getOffset());
+    if (_compiling) _allocator.endStatement();
+}
+
+void CodeGenerator::preVisit(NExpressionUnary* node) throw(NodeError) {
+    if (node->getOperator() != MINUS) {
+        throw NodeError("Unsupported unary operator");
+    }
+    append(CodeListing::CONST_0, node->getOffset());
+}
+
+void CodeGenerator::postVisit(NExpressionUnary* node) throw(NodeError) {
+    append(CodeListing::SUB, node->getOffset());
+}
+
+void CodeGenerator::postVisit(NExpressionBinary* node) throw(NodeError) {
+    append(getBinaryInstruction(node->getOperator()), node->getOffset());
+}
+
+void CodeGenerator::visit(NVariable* node) throw(NodeError) {
+    int symbol = appendVariable(node->getSymbol(), node->getName(),
+                                node->getOffset(), _left_side_mode);
+    if (_compiling) node->setSymbol(symbol);
+    if (!_left_side_mode) append(CodeListing::LOAD, node->getOffset());
+}
+
+void CodeGenerator::visit(NNumber* node) throw(NodeError) {
+    TextSpan number = node->getNumber();
+    appendConst(CodeListing::toInt(number.data(), number.length()),
+                node->getOffset());
+}
+
+CodeListing::Instruction CodeGenerator::getBinaryInstruction(
+    ExpressionOperator op) throw(NodeError)
+{
+    switch (op) {
+        case PLUS:  return CodeListing::ADD;
+        case MINUS: return CodeListing::SUB;
+        case MUL:   return CodeListing::MUL;
+        case DIV:   return CodeListing::DIV;
+        default:    throw NodeError("Unknown binary operator");
+    }
+}
+
+int CodeGenerator::countMemoryLocations(void) const {
+    int num_memory_locations = 0;
+    for (size_t i = 0; i < _symtab->getNumRecords(); i++) {
+        int memory_index = _symtab->getRecord(i)->getMemoryIndex();
+        if (memory_index >= num_memory_locations) {
+            num_memory_locations = memory_index + 1;
+        }
+    }
+    return num_memory_locations;
+}
+
+const SymbolTable::Record* CodeGenerator::lookUp(
+    int symbol,
+    const TextSpan& name,
+    unsigned int offset) throw(NodeError)
+{
+    if (symbol >= 0
+        && static_cast<size_t>(symbol) < _symtab->getNumRecords())
+    {
+        return _symtab->getRecord(symbol);
+    }
+
+    const SymbolTable::Record* record = _symtab->lookUp(name);
+    if (!record) {
+        int line, column;
+        locate(offset, &line, &column);
+        stringstream ss;
+        ss << "Variable \"" << name << "\" at "
+           << line << ":" << column << " is not in the symbol table";
+        throw NodeError(ss.str());
+    }
+    return record;
+}
+
+void CodeGenerator::locate(size_t offset, int* line, int* column) {
+    if (offset < _line_start || offset >= _line_end) {
+        _newlines->lookUp(offset, &_line, column);
+        _line_start = offset - (*column - 1);
+
+        // The last line may still grow, so it is not reused
+        unsigned int num_lines = _newlines->getNumLines();
+        _line_end = static_cast<unsigned int>(_line) < num_lines
+            ? _newlines->getLineStart(_line + 1) : _line_start;
+    }
+    *line = _line;
+    *column = static_cast<int>(offset - _line_start) + 1;
+}
+
+void CodeGenerator::addLine(unsigned int offset) {
+    if (_lines) {
+        int line, column;
+        locate(offset, &line, &column);
+        _lines->append(_listing.getCode().size(), line, column);
+    }
+}
+
+void CodeGenerator::append(
+    CodeListing::Instruction inst,
+    unsigned int offset)
+{
+    addLine(offset);
+    _listing << inst;
+}
+
+void CodeGenerator::appendConst(int value, unsigned int offset) {
+    addLine(offset);
+    appendConst(&_listing, value);
+}
+
+void CodeGenerator::appendConst(CodeListing* listing, int value) {
+    if (value == 0) {
+        *listing << CodeListing::CONST_0;
+    }
+    else if (value == 1) {
+        *listing << CodeListing::CONST_1;
+    }
+    else if (CodeListing::willFitInChar(value)) {
+        *listing << CodeListing::CONST_1B << static_cast<char>(value);
+    }
+    else if (CodeListing::willFitInShort(value)) {
+        *listing << CodeListing::CONST_2B << static_cast<short>(value);
+    }
+    else {
+        *listing << CodeListing::CONST_4B << value;
+    }
+}
+
+int CodeGenerator::appendVariable(
+    int symbol,
+    const TextSpan& name,
+    unsigned int offset,
+    bool declaration) throw(NodeError)
+{
+    if (!_compiling) {
+        const SymbolTable::Record* record = lookUp(symbol, name, offset);
+        appendConst(record->getMemoryIndex(), offset);
+        return symbol;
+    }
+
+    // The expression of an assignment is visited before its variable, so the
+    // uses are checked before the declaration, as by the SymbolTableBuilder
+    if (declaration) {
+        symbol = _symtab_builder.declare(name, offset);
+        _allocator.declare(symbol);
+    }
+    else {
+        symbol = _symtab_builder.use(name, offset);
+        _allocator.use(symbol);
+    }
+
+    // The placeholder gets a line table entry of its own, as the push would
+    Fixup fixup;
+    fixup.position = _listing.getCode().size();
+    fixup.symbol = symbol;
+    _fixups.push_back(fixup);
+    append(CodeListing::CONST_0, offset);
+    return symbol;
+}
+
+void CodeGenerator::link(vector<char>* code, int num_locations) {
+    // The push of every memory index is encoded once, and copied in between
+    // the rest of the code wherever the index is pushed
+    CodeListing pushes;
+    vector<unsigned int> push_starts(num_locations + 1);
+    for (int i = 0; i < num_locations; i++) {
+        push_starts[i] = pushes.getCode().size();
+        appendConst(&pushes, i);
+    }
+    push_starts[num_locations] = pushes.getCode().size();
+    size_t size = _listing.getCode().size() - _fixups.size();
+    for (size_t i = 0; i < _fixups.size(); i++) {
+        int index = _symtab->getRecord(_fixups[i].symbol)->getMemoryIndex();
+        _fixups[i].symbol = index;
+        size += push_starts[index + 1] - push_starts[index];
+    }
+
+    // The placeholders take one byte of their own, so the line table has the
+    // same entries as if the indices had been pushed, only at other positions
+    const vector<char>& unlinked = _listing.getCode();
+    code->resize(size);
+    char* destination = &(*code)[0];
+    vector<std::pair<int, int> > insertions;
+    size_t start = 0;
+    for (size_t i = 0; i <= _fixups.size(); i++) {
+        size_t end = i < _fixups.size() ? _fixups[i].position
+                                        : unlinked.size();
+        memcpy(destination, &unlinked[start], end - start);
+        destination += end - start;
+        if (i < _fixups.size()) {
+            int index = _fixups[i].symbol;
+            size_t push_size = push_starts[index + 1] - push_starts[index];
+            memcpy(destination, &pushes.getCode()[push_starts[index]],
+                   push_size);
+            destination += push_size;
+            if (_lines && push_size > 1) {
+                insertions.push_back(std::make_pair(end + 1, push_size - 1));
+            }
+            end++;
+        }
+        start = end;
+    }
+    if (_lines) _lines->insertCode(insertions);
+    vector<Fixup>().swap(_fixups);
+}
@@ -32,8 +32,14 @@
  */
 
 #include "code_listing.hpp"
+#include "line_table.hpp"
 #include "../ast/ast.hpp"
+#include "../ast/flat_ast.hpp"
+#include "../ast/static_visitor.hpp"
+#include "../grammar/newline_index.hpp"
+#include "../symtab/memory_allocator.hpp"
 #include "../symtab/symbol_table.hpp"
+#include "../symtab/symbol_table_builder.hpp"
 #include <string>
 #include <vector>
 
@@ -41,11 +47,33 @@
  * \brief Handles code generation.
  *
  * The CodeGenerator class converts the AST into code. The class derives the
- * AST::DefaultVisitor and processes the tree in a bottom-up fashion (as the
+ * AST::StaticVisitor and processes the tree in a bottom-up fashion (as the
  * reflect the true execution of the program).
+ *
+ * The variables are expected to have been resolved to their symbol ids by the
+ * SymbolTableBuilder which built the given symbol table, so their records are
+ * found without their names being looked up.
+ *
+ * As SCRAP requires every variable to be declared before it is used, the
+ * symbol table can also be built during the same traversal that generates
+ * the code (see compile()), which then checks the declarations in the same
+ * order and reports the same errors as the SymbolTableBuilder. The memory
+ * locations of the variables are assigned by the MemoryAllocator once all
+ * accesses are known, so until then the code has a one-byte placeholder
+ * wherever a memory index is pushed. The placeholders are replaced when the
+ * code is finished, which moves the rest of the code and the line table
+ * entries in one linear pass. The code is the same as that of building the
+ * symbol table, assigning the memory locations and generating the code one
+ * after the other.
  */
-class CodeGenerator : public AST::DefaultVisitor {
+class CodeGenerator : public AST::StaticVisitor<CodeGenerator> {
   public:
+    using AST::StaticVisitor<CodeGenerator>::preVisit;
+    using AST::StaticVisitor<CodeGenerator>::getChildVisitOrder;
+    using AST::StaticVisitor<CodeGenerator>::betweenChildren;
+    using AST::StaticVisitor<CodeGenerator>::postVisit;
+    using AST::StaticVisitor<CodeGenerator>::visit;
+
     /**
      * Creates a code generator. By default the code generator will be in
      * "R-value mode".
@@ -53,9 +81,9 @@ class CodeGenerator : public AST::DefaultVisitor {
     CodeGenerator(void);
 
     /**
-     * \copydoc AST::DefaultVisitor::~DefaultVisitor
+     * Destroys this code generator.
      */
-    virtual ~CodeGenerator(void);
+    ~CodeGenerator(void);
 
     /**
      * Generates code from a given program node and symbol table. If \c false is
@@ -65,19 +93,456 @@ class CodeGenerator : public AST::DefaultVisitor {
      *        Root node to process.
      * @param symtab
      *        Symbol table.
+     * @param newlines
+     *        Newline index of the source, for turning the source offsets of
+     *        the nodes into lines and columns.
      * @param code
      *        Code destination vector.
+     * @param lines
+     *        If not \c NULL, the line table is cleared and filled in with the
+     *        source position of every generated instruction.
      * @returns \c true if the generation was successful.
      */
     bool generate(
         AST::NProgram* root,
         const SymbolTable* symtab,
-        std::vector<char>* code);
+        const NewlineIndex* newlines,
+        std::vector<char>* code,
+        LineTable* lines = NULL);
+
+    /**
+     * Generates code from the flat representation of a program, in one linear
+     * pass over its nodes. The code is the same as that generated from the
+     * AST it was built from.
+     *
+     * @param ast
+     *        Flat AST.
+     * @param symtab
+     *        Symbol table.
+     * @param newlines
+     *        Newline index of the source, for turning the source offsets of
+     *        the nodes into lines and columns.
+     * @param code
+     *        Code destination vector.
+     * @param lines
+     *        If not \c NULL, the line table is cleared and filled in with the
+     *        source position of every generated instruction.
+     * @returns \c true if the generation was successful.
+     */
+    bool generate(
+        const AST::FlatAst& ast,
+        const SymbolTable* symtab,
+        const NewlineIndex* newlines,
+        std::vector<char>* code,
+        LineTable* lines = NULL);
+
+    /**
+     * Builds the symbol table of a program, checks that no variables are
+     * redefined or used before having been declared, assigns the memory
+     * locations of the variables and generates the code, in one traversal of
+     * the program. The variables are resolved to their symbol ids on the way.
+     * If \c false is returned, an error has been reported and the states of
+     * the symbol table and the code are undefined.
+     *
+     * @param root
+     *        Root node to process.
+     * @param symtab
+     *        Symbol table, which is cleared and then built.
+     * @param newlines
+     *        Newline index of the source, for turning the source offsets of
+     *        the nodes into lines and columns.
+     * @param code
+     *        Code destination vector.
+     * @param lines
+     *        If not \c NULL, the line table is cleared and filled in with the
+     *        source position of every generated instruction.
+     * @returns \c true if the compilation was successful.
+     */
+    bool compile(
+        AST::NProgram* root,
+        SymbolTable* symtab,
+        const NewlineIndex* newlines,
+        std::vector<char>* code,
+        LineTable* lines = NULL);
+
+    /**
+     * Starts generating code one statement at a time, for when the statements
+     * become available one by one. The symbol table may still grow while the
+     * code is generated, as long as each statement's variables are in it
+     * before the statement is added.
+     *
+     * @param symtab
+     *        Symbol table.
+     * @param newlines
+     *        Newline index of the source, which may also still grow as long
+     *        as each statement's text is in it before the statement is added.
+     * @param lines
+     *        If not \c NULL, the line table is cleared and filled in with the
+     *        source position of every generated instruction.
+     */
+    void begin(
+        const SymbolTable* symtab,
+        const NewlineIndex* newlines,
+        LineTable* lines = NULL);
+
+    /**
+     * Starts compiling one statement at a time, as compile() does for a whole
+     * program, for when the statements become available one by one. Code is
+     * generated for every statement as soon as it is added.
+     *
+     * @param symtab
+     *        Symbol table, which is cleared and then built.
+     * @param newlines
+     *        Newline index of the source, which may still grow as long as each
+     *        statement's text is in it before the statement is added.
+     * @param lines
+     *        If not \c NULL, the line table is cleared and filled in with the
+     *        source position of every generated instruction.
+     */
+    void beginCompiling(
+        SymbolTable* symtab,
+        const NewlineIndex* newlines,
+        LineTable* lines = NULL);
+
+    /**
+     * Generates the code of the next statement of the program. After
+     * beginCompiling(), its declarations are also added to the symbol table
+     * and its variable uses checked.
+     *
+     * @param node
+     *        Statement node.
+     * @throws NodeError
+     *         When a statement cannot be translated, or a variable is
+     *         redefined or used before having been declared.
+     */
+    void addStatement(AST::NStatement* node) throw(AST::NodeError);
+
+    /**
+     * Finishes the code started with begin() or beginCompiling(),
+     * setting the number of memory locations from the final symbol table.
+     * After beginCompiling(), the memory locations are assigned first and
+     * their indices inserted into the code.
+     *
+     * @param code
+     *        Code destination vector.
+     */
+    void finish(std::vector<char>* code);
+
+    /**
+     * Sets the mode to "R" mode, as the expression is visited first.
+     *
+     * @param node
+     *        Assignment node.
+     * @throws NodeError
+     *         Will not be thrown.
+     */
+    void preVisit(AST::NAssignment* node) throw(AST::NodeError);
+
+    /**
+     * Visits the expression before the variable, as the value must be on the
+     * stack below the memory index when the value is stored.
+     *
+     * @param node
+     *        Assignment node.
+     * @returns IVisitor::REVERSED.
+     * @throws NodeError
+     *         Will not be thrown.
+     */
+    AST::IVisitor::VisitOrder getChildVisitOrder(AST::NAssignment* node)
+        throw(AST::NodeError);
+
+    /**
+     * Sets the mode to "L" mode.
+     *
+     * @param node
+     *        Assignment node.
+     * @throws NodeError
+     *         Will not be thrown.
+     */
+    void betweenChildren(AST::NAssignment* node) throw(AST::NodeError);
+
+    /**
+     * Stores the value of the expression in the variable, which ends the
+     * statement.
+     *
+     * @param node
+     *        Assignment node.
+     * @throws NodeError
+     *         Will not be thrown.
+     */
+    void postVisit(AST::NAssignment* node) throw(AST::NodeError);
+
+    /**
+     * Prints the value of the expression.
+     *
+     * @param node
+     *        Print node.
+     * @throws NodeError
+     *         Will not be thrown.
+     */
+    void postVisit(AST::NPrint* node) throw(AST::NodeError);
+
+    /**
+     * Pushes 0, from which the operand will be subtracted.
+     *
+     * @param node
+     *        Unary expression node.
+     * @throws NodeError
+     *         When the operator is not supported.
+     */
+    void preVisit(AST::NExpressionUnary* node) throw(AST::NodeError);
+
+    /**
+     * Applies the unary operator.
+     *
+     * @param node
+     *        Unary expression node.
+     * @throws NodeError
+     *         Will not be thrown.
+     */
+    void postVisit(AST::NExpressionUnary* node) throw(AST::NodeError);
+
+    /**
+     * Applies the binary operator.
+     *
+     * @param node
+     *        Binary expression node.
+     * @throws NodeError
+     *         When the operator is unknown.
+     */
+    void postVisit(AST::NExpressionBinary* node) throw(AST::NodeError);
+
+    /**
+     * Pushes the memory index of the variable, and in "R" mode also loads its
+     * value. When compiling, the variable is also declared in "L" mode and
+     * checked in "R" mode, and its symbol id is set.
+     *
+     * @param node
+     *        Variable node.
+     * @throws NodeError
+     *         When the variable is not in the symbol table.
+     */
+    void visit(AST::NVariable* node) throw(AST::NodeError);
+
+    /**
+     * Pushes the number.
+     *
+     * @param node
+     *        Number node.
+     * @throws NodeError
+     *         Will not be thrown.
+     */
+    void visit(AST::NNumber* node) throw(AST::NodeError);
+
+  private:
+    /**
+     * \brief Push of a memory index which is not known yet.
+     */
+    struct Fixup {
+        /**
+         * Position in the code of the one-byte placeholder which is replaced
+         * by the push of the index.
+         */
+        unsigned int position;
+
+        /**
+         * Symbol id of the variable, which link() replaces by its memory
+         * index.
+         */
+        int symbol;
+    };
+
+  private:
+    /**
+     * Gets the number of memory locations used by the variables of the symbol
+     * table.
+     *
+     * @returns Number of memory locations.
+     */
+    int countMemoryLocations(void) const;
+
+    /**
+     * Gets the instruction of a binary operator.
+     *
+     * @param op
+     *        Binary operator.
+     * @returns Instruction.
+     * @throws NodeError
+     *         When the operator is unknown.
+     */
+    static CodeListing::Instruction getBinaryInstruction(
+        AST::ExpressionOperator op) throw(AST::NodeError);
+
+    /**
+     * Looks up the record of a variable. A resolved variable is found by its
+     * symbol id, and only an unresolved one by its name.
+     *
+     * @param symbol
+     *        Symbol id, or -1.
+     * @param name
+     *        Variable name.
+     * @param offset
+     *        Source offset of the variable.
+     * @returns Record.
+     * @throws NodeError
+     *         When the variable is not in the symbol table.
+     */
+    const SymbolTable::Record* lookUp(
+        int symbol,
+        const TextSpan& name,
+        unsigned int offset) throw(AST::NodeError);
+
+    /**
+     * Finds the line and column of a source offset. As the nodes are mostly
+     * visited in source order, the line of the previous offset is checked
+     * first.
+     *
+     * @param offset
+     *        Source offset.
+     * @param line
+     *        Destination of the line.
+     * @param column
+     *        Destination of the column.
+     */
+    void locate(size_t offset, int* line, int* column);
+
+    /**
+     * Records the source position of the code about to be appended, if a line
+     * table is to be filled in.
+     *
+     * @param offset
+     *        Source offset of the node that produces the code.
+     */
+    void addLine(unsigned int offset);
+
+    /**
+     * Appends an instruction produced by the node at a given source offset.
+     *
+     * @param inst
+     *        Instruction.
+     * @param offset
+     *        Source offset of the node that produced the instruction.
+     */
+    void append(CodeListing::Instruction inst, unsigned int offset);
+
+    /**
+     * Appends the shortest instruction which pushes a given constant.
+     *
+     * @param value
+     *        Constant value.
+     * @param offset
+     *        Source offset of the node that produced the constant.
+     */
+    void appendConst(int value, unsigned int offset);
+
+    /**
+     * Appends the shortest instruction which pushes a given constant to a code
+     * listing.
+     *
+     * @param listing
+     *        Code listing.
+     * @param value
+     *        Constant value.
+     */
+    static void appendConst(CodeListing* listing, int value);
+
+    /**
+     * Pushes the memory index of a variable. When compiling, the variable is
+     * first declared or checked, and a placeholder is appended instead, which
+     * link() replaces.
+     *
+     * @param symbol
+     *        Symbol id, or -1.
+     * @param name
+     *        Variable name.
+     * @param offset
+     *        Source offset of the variable.
+     * @param declaration
+     *        Whether the variable is assigned to, rather than read.
+     * @returns Symbol id of the variable.
+     * @throws NodeError
+     *         When the variable is not in the symbol table, or when compiling,
+     *         is redefined or used before having been declared.
+     */
+    int appendVariable(
+        int symbol,
+        const TextSpan& name,
+        unsigned int offset,
+        bool declaration) throw(AST::NodeError);
 
-    /* TASK: Override the appropriate visitor methods */
+    /**
+     * Replaces the placeholders by the pushes of the memory indices, once the
+     * memory locations have been assigned, and moves the line table entries
+     * accordingly.
+     *
+     * @param code
+     *        Code destination vector.
+     * @param num_locations
+     *        Number of memory locations.
+     */
+    void link(std::vector<char>* code, int num_locations);
 
   private:
-    /* TASK: Add whatever private members and methods you find necessary */
+    /**
+     * Code being generated.
+     */
+    CodeListing _listing;
+
+    /**
+     * Symbol table of the program.
+     */
+    const SymbolTable* _symtab;
+
+    /**
+     * Newline index of the source.
+     */
+    const NewlineIndex* _newlines;
+
+    /**
+     * Line table to fill in, or \c NULL.
+     */
+    LineTable* _lines;
+
+    /**
+     * Line found by the previous call to locate().
+     */
+    int _line;
+
+    /**
+     * Offset at which the previously found line starts.
+     */
+    size_t _line_start;
+
+    /**
+     * Offset at which the previously found line ends, which equals
+     * _line_start if the line is not to be reused.
+     */
+    size_t _line_end;
+
+    /**
+     * Flag for controlling "L" and "R" mode in assignment nodes.
+     */
+    bool _left_side_mode;
+
+    /**
+     * Whether the symbol table is built while the code is generated.
+     */
+    bool _compiling;
+
+    /**
+     * Builds the symbol table when compiling.
+     */
+    SymbolTableBuilder _symtab_builder;
+
+    /**
+     * Assigns the memory locations when compiling.
+     */
+    MemoryAllocator _allocator;
+
+    /**
+     * Memory indices to be pushed when compiling, in code order.
+     */
+    std::vector<Fixup> _fixups;
 };
 
 #endif
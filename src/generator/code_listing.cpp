@@ -25,6 +25,7 @@
 
 #include "code_listing.hpp"
 #include <climits>
+#include <cstddef>
 #include <sstream>
 
 using std::string;
@@ -41,7 +42,15 @@ void CodeListing::setNumMemoryLocations(int num) {
 
 void CodeListing::generateInitCode(void) {
     appendConstValue(static_cast<int>(0x1337D00D));
-    appendConstValue(switchEndianInt(_num_memory_locations));
+    appendConstValue(_num_memory_locations);
+}
+
+void CodeListing::updateNumMemoryLocations(int num) {
+    _num_memory_locations = num;
+    _code[4] = static_cast<char>(num >> 24);
+    _code[5] = static_cast<char>(num >> 16);
+    _code[6] = static_cast<char>(num >>  8);
+    _code[7] = static_cast<char>(num);
 }
 
 void CodeListing::appendInstruction(Instruction inst) {
@@ -97,11 +106,16 @@ bool CodeListing::willFitInShort(int value) {
 }
 
 short CodeListing::switchEndianShort(short value) {
-    /* TASK: Implement this method */
+    unsigned short v = static_cast<unsigned short>(value);
+    return static_cast<short>((v >> 8) | (v << 8));
 }
 
 int CodeListing::switchEndianInt(int value) {
-    /* TASK: Implement this method */
+    unsigned int v = static_cast<unsigned int>(value);
+    return static_cast<int>((v >> 24)
+                            | ((v >>  8) & 0x0000FF00)
+                            | ((v <<  8) & 0x00FF0000)
+                            | (v << 24));
 }
 
 int CodeListing::toInt(const string& str) {
@@ -110,3 +124,32 @@ int CodeListing::toInt(const string& str) {
     ss >> value;
     return value;
 }
+
+int CodeListing::toInt(const char* str, size_t length) {
+    int value = 0;
+    for (size_t i = 0; i < length; i++) {
+        int digit = str[i] - '0';
+        if (value > (INT_MAX - digit) / 10) return INT_MAX;
+        value = value * 10 + digit;
+    }
+    return value;
+}
+
+const char* CodeListing::getInstructionName(Instruction inst) {
+    switch (inst) {
+        case LOAD:     return "LOAD";
+        case STORE:    return "STORE";
+        case CONST_1B: return "CONST_1B";
+        case CONST_2B: return "CONST_2B";
+        case CONST_4B: return "CONST_4B";
+        case CONST_0:  return "CONST_0";
+        case CONST_1:  return "CONST_1";
+        case ADD:      return "ADD";
+        case SUB:      return "SUB";
+        case MUL:      return "MUL";
+        case DIV:      return "DIV";
+        case SWAP:     return "SWAP";
+        case PRINT:    return "PRINT";
+        default:       return NULL;
+    }
+}
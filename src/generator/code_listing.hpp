@@ -31,6 +31,7 @@
  * @brief Defines the classes and functions for managing code generation.
  */
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -268,6 +269,16 @@ class CodeListing {
      */
     void generateInitCode(void);
 
+    /**
+     * Changes the number of memory locations after generateInitCode() has been
+     * invoked, by rewriting it in the already generated code. This allows the
+     * code to be generated before all variables are known.
+     *
+     * @param num
+     *        Number of memory locations to use.
+     */
+    void updateNumMemoryLocations(int num);
+
     /**
      * Appends an instruction to this code listing. Using
      * operator<<(Instruction) has the same effect.
@@ -399,6 +410,29 @@ class CodeListing {
      */
     static int toInt(const std::string& str);
 
+    /**
+     * Converts a string of decimal digits into an \c int without allocating.
+     * Values too large for an \c int saturate, as with toInt(const
+     * std::string&).
+     *
+     * @param str
+     *        First digit.
+     * @param length
+     *        Number of digits.
+     * @returns Value as \c int.
+     */
+    static int toInt(const char* str, size_t length);
+
+    /**
+     * Gets the mnemonic of an instruction, as used in the instruction set
+     * description.
+     *
+     * @param inst
+     *        Instruction.
+     * @returns Mnemonic, or \c NULL if \c inst is not a known instruction.
+     */
+    static const char* getInstructionName(Instruction inst);
+
   private:
     /**
      * Contains the generated code.
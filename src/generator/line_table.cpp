@@ -0,0 +1,92 @@
+#include "line_table.hpp"
+#include <sstream>
+#include <string>
+
+using std::pair;
+using std::string;
+using std::stringstream;
+using std::vector;
+
+LineTable::LineTable(void) {}
+
+LineTable::~LineTable(void) {}
+
+void LineTable::append(int pc, int line, int column) {
+    if (!_entries.empty()) {
+        Entry& last = _entries.back();
+        if (last.line == line && last.column == column) return;
+        if (last.pc == pc) {
+            last.line = line;
+            last.column = column;
+            return;
+        }
+    }
+
+    Entry entry;
+    entry.pc = pc;
+    entry.line = line;
+    entry.column = column;
+    _entries.push_back(entry);
+}
+
+void LineTable::insertCode(const vector<pair<int, int> >& insertions) {
+    size_t next = 0;
+    int shift = 0;
+    for (size_t i = 0; i < _entries.size(); i++) {
+        while (next < insertions.size()
+               && insertions[next].first <= _entries[i].pc)
+        {
+            shift += insertions[next].second;
+            next++;
+        }
+        _entries[i].pc += shift;
+    }
+}
+
+bool LineTable::lookUp(int pc, int* line, int* column) const {
+    if (_entries.empty() || pc < _entries[0].pc) return false;
+
+    // Binary search for the last entry whose PC is not greater than pc
+    unsigned int low = 0, high = _entries.size();
+    while (high - low > 1) {
+        unsigned int mid = low + (high - low) / 2;
+        if (_entries[mid].pc <= pc) low = mid;
+        else high = mid;
+    }
+    *line = _entries[low].line;
+    *column = _entries[low].column;
+    return true;
+}
+
+unsigned int LineTable::getNumEntries(void) const {
+    return _entries.size();
+}
+
+void LineTable::clear(void) {
+    _entries.clear();
+}
+
+string LineTable::toString(void) const {
+    stringstream ss;
+    ss << "# SCRAP line table" << std::endl;
+    vector<Entry>::const_iterator it;
+    for (it = _entries.begin(); it != _entries.end(); it++) {
+        ss << it->pc << " " << it->line << " " << it->column << std::endl;
+    }
+    return ss.str();
+}
+
+bool LineTable::parse(const vector<char>& data) {
+    clear();
+    stringstream ss(string(data.begin(), data.end()));
+    string text;
+    while (std::getline(ss, text)) {
+        if (text.empty() || text[0] == '#') continue;
+        stringstream line_ss(text);
+        Entry entry;
+        if (!(line_ss >> entry.pc >> entry.line >> entry.column)) return false;
+        if (!_entries.empty() && entry.pc < _entries.back().pc) return false;
+        _entries.push_back(entry);
+    }
+    return true;
+}
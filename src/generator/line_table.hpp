@@ -0,0 +1,166 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CEE_GENERATOR_LINE_TABLE__H
+#define CEE_GENERATOR_LINE_TABLE__H
+
+/**
+ * @file
+ * @brief Defines the classes for mapping code to source positions.
+ */
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * \brief Maps program counter values to source positions.
+ *
+ * The LineTable class records which source line and column produced each part
+ * of a code listing. It is filled in by the CodeGenerator and used to map
+ * execution back to the source program, e.g. by the sampling profiler.
+ *
+ * Entries are appended in increasing program counter order, and an entry
+ * covers all code up to the next entry. Consecutive instructions from the same
+ * source position therefore share one entry.
+ *
+ * The table is stored as text, with one entry per line:
+ *
+ * <pre>
+ * # SCRAP line table
+ * PC LINE COLUMN
+ * ...
+ * </pre>
+ */
+class LineTable {
+  public:
+    /**
+     * Creates an empty line table.
+     */
+    LineTable(void);
+
+    /**
+     * Destroys this line table.
+     */
+    ~LineTable(void);
+
+    /**
+     * Records that the code starting at a given program counter value was
+     * produced from a given source position. If the position is the same as
+     * that of the last entry, no entry is added.
+     *
+     * @param pc
+     *        Program counter value (must not be less than that of the last
+     *        entry).
+     * @param line
+     *        Source line.
+     * @param column
+     *        Source column.
+     */
+    void append(int pc, int line, int column);
+
+    /**
+     * Moves the entries after code has been inserted into the code listing.
+     * Code inserted at a position goes in front of the code at that position,
+     * whose entry is moved along with it.
+     *
+     * @param insertions
+     *        Positions at which code is inserted, in increasing order, each
+     *        paired with the number of bytes inserted there.
+     */
+    void insertCode(const std::vector<std::pair<int, int> >& insertions);
+
+    /**
+     * Finds the source position of the code at a given program counter
+     * value.
+     *
+     * @param pc
+     *        Program counter value.
+     * @param line
+     *        Destination of the source line.
+     * @param column
+     *        Destination of the source column.
+     * @returns \c true if the program counter value is covered by the table.
+     */
+    bool lookUp(int pc, int* line, int* column) const;
+
+    /**
+     * Gets the number of entries in this line table.
+     *
+     * @returns Number of entries.
+     */
+    unsigned int getNumEntries(void) const;
+
+    /**
+     * Removes all entries.
+     */
+    void clear(void);
+
+    /**
+     * Formats this line table in its textual form.
+     *
+     * @returns Line table as text.
+     */
+    std::string toString(void) const;
+
+    /**
+     * Replaces the content of this line table with one in textual form.
+     *
+     * @param data
+     *        Line table as text.
+     * @returns \c true if the data was well-formed.
+     */
+    bool parse(const std::vector<char>& data);
+
+  private:
+    /**
+     * \brief Line table entry.
+     */
+    struct Entry {
+        /**
+         * First program counter value covered by the entry.
+         */
+        int pc;
+
+        /**
+         * Source line.
+         */
+        int line;
+
+        /**
+         * Source column.
+         */
+        int column;
+    };
+
+  private:
+    /**
+     * Entries, ordered by program counter value.
+     */
+    std::vector<Entry> _entries;
+};
+
+#endif
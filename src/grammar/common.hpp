@@ -33,6 +33,7 @@
 
 #ifndef SCANNER_BUILD
 #include "../ast/ast.hpp"
+#include "parse_context.hpp"
 #endif
 #include "../io/reporter.hpp"
 #include <cstddef>
@@ -42,4 +43,26 @@
 using namespace AST;
 #endif
 
+/**
+ * Text of an identifier, number or unknown token, as passed from the scanner
+ * to the parser. The text is not <code>NUL</code>-terminated.
+ */
+struct TokenText {
+    /**
+     * First character.
+     */
+    const char* data;
+
+    /**
+     * Number of characters.
+     */
+    unsigned int length;
+
+    /**
+     * Whether the text stays valid for the lifetime of the AST (e.g. because
+     * it refers into a mapped source file). If not, the parser copies it.
+     */
+    bool stable;
+};
+
 #endif
@@ -0,0 +1,48 @@
+#include "fast_lexer.hpp"
+#include "common.hpp" // Must be included before "parser.tab.h"
+#include "parser.tab.h"
+
+/* Parser token of every TokenBuffer::Kind. */
+static const int TOKEN_OF_KIND[] = {
+    T_IDENTIFIER,
+    T_NUMBER,
+    T_PRINT,
+    T_EQUAL,
+    T_SEMICOLON,
+    T_PLUS,
+    T_MINUS,
+    T_MUL,
+    T_DIV,
+    T_LPAREN,
+    T_RPAREN,
+    T_UNKNOWN
+};
+
+FastLexer::FastLexer(const TokenBuffer* tokens, bool stable)
+        : _tokens(tokens), _next(0), _stable(stable), _origin(0)
+{}
+
+FastLexer::~FastLexer(void) {}
+
+void FastLexer::setOrigin(unsigned int offset) {
+    _origin = offset;
+}
+
+int yylex(YYSTYPE* yylval, YYLTYPE* yylloc, void* scanner) {
+    FastLexer& lexer = *static_cast<FastLexer*>(scanner);
+    const TokenBuffer* tokens = lexer._tokens;
+    if (!tokens || lexer._next >= tokens->getNumTokens()) return 0;
+    unsigned int i = lexer._next++;
+
+    *yylloc = lexer._origin + tokens->getOffset(i);
+
+    TokenBuffer::Kind kind = tokens->getKind(i);
+    if (kind == TokenBuffer::IDENTIFIER || kind == TokenBuffer::NUMBER
+        || kind == TokenBuffer::UNKNOWN)
+    {
+        yylval->token_text.data = tokens->getTextPointer(i);
+        yylval->token_text.length = tokens->getLength(i);
+        yylval->token_text.stable = lexer._stable;
+    }
+    return TOKEN_OF_KIND[kind];
+}
@@ -0,0 +1,116 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CEE_GRAMMAR_FAST_LEXER__H
+#define CEE_GRAMMAR_FAST_LEXER__H
+
+/**
+ * @file
+ * @brief Defines the lexer for feeding a TokenBuffer to the parser.
+ *
+ * <code>fast_lexer.cpp</code> defines <code>yylex()</code> on top of a
+ * FastLexer, and is linked instead of the flex scanner. The parser is then
+ * invoked with <code>yyparse(&lexer, &context)</code>.
+ */
+
+#include "fast_scanner.hpp"
+
+union YYSTYPE;
+
+/**
+ * \brief Lexer which returns the tokens of a TokenBuffer to the parser.
+ *
+ * A FastLexer takes the place of the flex scanner as the scanner argument of
+ * <code>yyparse()</code>. All of its state is in the object, so one lexer per
+ * parse is enough for several sources to be parsed at the same time.
+ */
+class FastLexer {
+  public:
+    /**
+     * Creates a lexer which returns the tokens of a buffer, starting from the
+     * first one. The buffer must outlive the parsing.
+     *
+     * @param tokens
+     *        Token buffer.
+     * @param stable
+     *        Whether the source text outlives the AST, in which case
+     *        identifiers and numbers refer directly into it. Otherwise the
+     *        parser copies them.
+     */
+    FastLexer(const TokenBuffer* tokens, bool stable = true);
+
+    /**
+     * Destroys this lexer.
+     */
+    ~FastLexer(void);
+
+    /**
+     * Sets the offset of the first character of the source text within the
+     * whole source, which is 0 by default.
+     *
+     * @param offset
+     *        Byte offset.
+     */
+    void setOrigin(unsigned int offset);
+
+  private:
+    friend int yylex(YYSTYPE* yylval, unsigned int* yylloc, void* scanner);
+
+    /**
+     * Tokens being returned.
+     */
+    const TokenBuffer* _tokens;
+
+    /**
+     * Index of the next token.
+     */
+    unsigned int _next;
+
+    /**
+     * Whether the source text outlives the AST.
+     */
+    bool _stable;
+
+    /**
+     * Offset of the first character of the source text.
+     */
+    unsigned int _origin;
+};
+
+/**
+ * Returns the next token of a FastLexer to the parser.
+ *
+ * @param yylval
+ *        Destination of the semantic value.
+ * @param yylloc
+ *        Destination of the location (source offset).
+ * @param scanner
+ *        FastLexer.
+ * @returns Token, or 0 at the end of the input.
+ */
+int yylex(YYSTYPE* yylval, unsigned int* yylloc, void* scanner);
+
+#endif
@@ -0,0 +1,318 @@
+#include "fast_parser.hpp"
+#include <string>
+
+using namespace AST;
+using std::string;
+
+namespace {
+
+/**
+ * Precedence of the negation operator.
+ */
+const int UNARY_PRECEDENCE = 3;
+
+/**
+ * Names of the token kinds, as reported by the bison parser.
+ */
+const char* const KIND_NAMES[] = {
+    "T_IDENTIFIER",
+    "T_NUMBER",
+    "T_PRINT",
+    "T_EQUAL",
+    "T_SEMICOLON",
+    "T_PLUS",
+    "T_MINUS",
+    "T_MUL",
+    "T_DIV",
+    "T_LPAREN",
+    "T_RPAREN",
+    "T_UNKNOWN"
+};
+
+/**
+ * Gets the precedence of a binary operator.
+ *
+ * @param kind
+ *        Token kind.
+ * @param op
+ *        Destination of the operator.
+ * @returns Precedence, or 0 if the token is not a binary operator.
+ */
+int getBinaryPrecedence(int kind, ExpressionOperator* op) {
+    switch (kind) {
+        case TokenBuffer::PLUS:  *op = PLUS;  return 1;
+        case TokenBuffer::MINUS: *op = MINUS; return 1;
+        case TokenBuffer::MUL:   *op = MUL;   return 2;
+        case TokenBuffer::DIV:   *op = DIV;   return 2;
+        default:                 return 0;
+    }
+}
+
+}
+
+FastParser::FastParser(void)
+        : _tokens(NULL), _context(NULL), _arena(NULL), _expressions(NULL),
+          _flat(NULL), _statements(NULL), _next(0), _origin(0)
+{}
+
+FastParser::~FastParser(void) {}
+
+bool FastParser::parse(const TokenBuffer& tokens, ParseContext* context) {
+    _flat = NULL;
+    return parseProgram(tokens, context);
+}
+
+bool FastParser::parse(
+    const TokenBuffer& tokens,
+    FlatAst* ast,
+    ParseContext* context)
+{
+    ast->clear();
+    _flat = ast;
+    bool result = parseProgram(tokens, context);
+    _flat = NULL;
+    return result;
+}
+
+void FastParser::setOrigin(unsigned int offset) {
+    _origin = offset;
+}
+
+bool FastParser::parseProgram(
+    const TokenBuffer& tokens,
+    ParseContext* context)
+{
+    _tokens = &tokens;
+    _context = context;
+    _arena = context->getArena();
+    _expressions = context->getExpressionFactory();
+    _next = 0;
+
+    if (tokens.getNumTokens() == 0) {
+        error("T_IDENTIFIER or T_PRINT");
+        return false;
+    }
+    unsigned int offset = locate(0);
+    _statements = NULL;
+    if (!_flat) {
+        _statements = _arena->track(new (_arena) NStatementList(offset));
+    }
+    while (_next < tokens.getNumTokens()) {
+        if (!parseStatement()) return false;
+    }
+    if (!_flat) context->setProgram(new (_arena) NProgram(_statements, offset));
+    return true;
+}
+
+bool FastParser::parseStatement(void) {
+    unsigned int start = _next;
+    unsigned int offset = locate(start);
+
+    TokenBuffer::Kind kind = _tokens->getKind(start);
+    if (kind == TokenBuffer::IDENTIFIER) {
+        _next++;
+        if (!expect(TokenBuffer::EQUAL, "T_EQUAL")) return false;
+        if (!parseExpression()) return false;
+        if (!expect(TokenBuffer::SEMICOLON, NULL)) return false;
+        TextSpan name(_tokens->getTextPointer(start),
+                      _tokens->getLength(start));
+        if (_flat) {
+            _flat->appendStatement(_flat->append(
+                FlatAst::ASSIGNMENT, PLUS, offset, _flat->appendText(name)));
+            return true;
+        }
+        NVariable* variable = new (_arena) NVariable(name, offset);
+        _expressions->assign(name);
+        appendStatement(new (_arena) NAssignment(
+            variable, _operands.back().node, offset));
+        return true;
+    }
+    if (kind == TokenBuffer::PRINT) {
+        _next++;
+        if (!parseExpression()) return false;
+        if (!expect(TokenBuffer::SEMICOLON, NULL)) return false;
+        if (_flat) {
+            _flat->appendStatement(
+                _flat->append(FlatAst::PRINT, PLUS, offset, 0));
+            return true;
+        }
+        appendStatement(new (_arena) NPrint(_operands.back().node, offset));
+        return true;
+    }
+
+    bool at_start = start == 0 && _origin == 0;
+    error(at_start ? "T_IDENTIFIER or T_PRINT"
+                   : "T_IDENTIFIER or T_PRINT or end of file");
+    return false;
+}
+
+void FastParser::appendStatement(NStatement* node) {
+    (*_statements) << node;
+    _context->addStatement(node);
+}
+
+bool FastParser::parseExpression(void) {
+    static const char* const EXPECTED =
+        "T_IDENTIFIER or T_NUMBER or T_LPAREN or T_MINUS";
+
+    _operands.clear();
+    _operators.clear();
+    unsigned int num_tokens = _tokens->getNumTokens();
+    for (;;) {
+        // An operand, after any number of negations and opening parentheses
+        if (_next >= num_tokens) {
+            error(EXPECTED);
+            return false;
+        }
+        TokenBuffer::Kind kind = _tokens->getKind(_next);
+        if (kind == TokenBuffer::LPAREN || kind == TokenBuffer::MINUS) {
+            Operator pending;
+            pending.precedence =
+                kind == TokenBuffer::LPAREN ? 0 : UNARY_PRECEDENCE;
+            pending.op = MINUS;
+            pending.token = _next++;
+            _operators.push_back(pending);
+
+            // In post-order, a negation starts in front of its operand
+            if (_flat && kind == TokenBuffer::MINUS) {
+                _flat->append(FlatAst::UNARY_START, MINUS,
+                              locate(pending.token), 0);
+            }
+            continue;
+        }
+        Operand operand;
+        operand.node = NULL;
+        operand.index = 0;
+        operand.start = _next;
+        TextSpan text(_tokens->getTextPointer(_next),
+                      _tokens->getLength(_next));
+        unsigned int offset = locate(_next);
+        if (kind == TokenBuffer::IDENTIFIER) {
+            if (_flat) {
+                operand.index = _flat->append(FlatAst::VARIABLE, PLUS, offset,
+                                              _flat->appendText(text));
+            }
+            else {
+                operand.node = _expressions->createVariable(text, offset);
+            }
+        }
+        else if (kind == TokenBuffer::NUMBER) {
+            if (_flat) {
+                operand.index = _flat->append(FlatAst::NUMBER, PLUS, offset,
+                                              _flat->appendText(text));
+            }
+            else {
+                operand.node = _expressions->createNumber(text, offset);
+            }
+        }
+        else {
+            error(EXPECTED);
+            return false;
+        }
+        _next++;
+        _operands.push_back(operand);
+
+        // Any number of closing parentheses, and then a binary operator or
+        // the end of the expression
+        for (;;) {
+            ExpressionOperator op;
+            int precedence = _next < num_tokens
+                ? getBinaryPrecedence(_tokens->getKind(_next), &op) : 0;
+            if (precedence > 0) {
+                // All binary operators are left-associative, so the pending
+                // operators which bind at least as tightly are applied first
+                reduce(precedence);
+                Operator pending;
+                pending.precedence = precedence;
+                pending.op = op;
+                pending.token = _next++;
+                _operators.push_back(pending);
+                break;
+            }
+
+            reduce(1);
+            if (_operators.empty()) return true;
+
+            // The inner expression keeps its own location
+            if (!expect(TokenBuffer::RPAREN, NULL)) return false;
+            _operands.back().start = _operators.back().token;
+            _operators.pop_back();
+        }
+    }
+}
+
+void FastParser::reduce(int min_precedence) {
+    while (!_operators.empty()
+           && _operators.back().precedence >= min_precedence)
+    {
+        Operator pending = _operators.back();
+        _operators.pop_back();
+        Operand rhs = _operands.back();
+        _operands.pop_back();
+        if (pending.precedence == UNARY_PRECEDENCE) {
+            Operand operand;
+            operand.node = NULL;
+            operand.index = 0;
+            if (_flat) {
+                operand.index = _flat->append(FlatAst::UNARY, MINUS,
+                                              locate(pending.token), 0);
+            }
+            else {
+                operand.node = _expressions->createUnary(
+                    MINUS, rhs.node, locate(pending.token));
+            }
+            operand.start = pending.token;
+            _operands.push_back(operand);
+        }
+        else {
+            // A binary expression is located at its left-hand side
+            Operand& lhs = _operands.back();
+            if (_flat) {
+                lhs.index = _flat->append(FlatAst::BINARY, pending.op,
+                                          locate(lhs.start), lhs.index);
+            }
+            else {
+                lhs.node = _expressions->createBinary(
+                    lhs.node, pending.op, rhs.node, locate(lhs.start));
+            }
+        }
+    }
+}
+
+bool FastParser::expect(TokenBuffer::Kind kind, const char* expected) {
+    if (_next < _tokens->getNumTokens() && _tokens->getKind(_next) == kind) {
+        _next++;
+        return true;
+    }
+    error(expected);
+    return false;
+}
+
+void FastParser::error(const char* expected) {
+    string message = "syntax error, unexpected ";
+    if (_next < _tokens->getNumTokens()) {
+        message += KIND_NAMES[_tokens->getKind(_next)];
+    }
+    else {
+        message += "end of file";
+    }
+    if (expected) {
+        message += ", expecting ";
+        message += expected;
+    }
+    addDiagnostic(message);
+}
+
+void FastParser::addDiagnostic(const string& message) {
+    // At the end of the input, the error is placed at the last token
+    unsigned int num_tokens = _tokens->getNumTokens();
+    unsigned int offset = _origin;
+    if (num_tokens > 0) {
+        offset = locate(_next < num_tokens ? _next : num_tokens - 1);
+    }
+    _context->addDiagnostic(offset, message);
+}
+
+unsigned int FastParser::locate(unsigned int token) const {
+    return _origin + _tokens->getOffset(token);
+}
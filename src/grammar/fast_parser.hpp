@@ -0,0 +1,303 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CEE_GRAMMAR_FAST_PARSER__H
+#define CEE_GRAMMAR_FAST_PARSER__H
+
+/**
+ * @file
+ * @brief Defines a hand-written parser which reads a TokenBuffer.
+ */
+
+#include "../ast/ast.hpp"
+#include "../ast/flat_ast.hpp"
+#include "fast_scanner.hpp"
+#include "parse_context.hpp"
+#include <vector>
+
+/**
+ * \brief Hand-written parser which reads a TokenBuffer.
+ *
+ * The FastParser class is an alternative to the bison parser
+ * (<code>parser.y</code>). Statements are parsed by recursive descent and
+ * expressions by operator precedence, so there are no state tables. An
+ * expression is parsed with explicit stacks of operands and pending
+ * operators rather than by recursion, so that, as with bison, its nesting
+ * depth is only limited by the memory. It accepts the same language, and
+ * builds the same AST with the same node locations:
+ *
+ * <pre>
+ * program    : statement+
+ * statement  : IDENTIFIER '=' expr ';' | PRINT expr ';'
+ * expr       : expr ('+' | '-') expr     (left-associative, lowest)
+ *            | expr ('*' | '/') expr     (left-associative)
+ *            | '-' expr                  (highest)
+ *            | '(' expr ')' | IDENTIFIER | NUMBER
+ * </pre>
+ *
+ * Syntax errors are added to the ParseContext in the same form as by the bison
+ * parser. As the identifier and number nodes refer into the source text of
+ * the tokens, that text must outlive the AST.
+ *
+ * The nodes are created in post-order, as operator precedence parsing
+ * reduces every operand before its operator. So the parser can also append
+ * them straight to an AST::FlatAst instead, without building the
+ * pointer-based AST first.
+ */
+class FastParser {
+  public:
+    /**
+     * Creates a parser.
+     */
+    FastParser(void);
+
+    /**
+     * Destroys this parser.
+     */
+    ~FastParser(void);
+
+    /**
+     * Parses a token buffer. On success, the root of the AST is set in the
+     * context, and otherwise the syntax error is added to it.
+     *
+     * @param tokens
+     *        Token buffer.
+     * @param context
+     *        Parse context.
+     * @returns \c true if the input has no syntax error.
+     */
+    bool parse(const TokenBuffer& tokens, ParseContext* context);
+
+    /**
+     * Parses a token buffer into a flat AST, without building the
+     * pointer-based AST. The syntax errors are added to the context, which
+     * gets no program.
+     *
+     * @param tokens
+     *        Token buffer.
+     * @param ast
+     *        Flat AST, which is cleared first.
+     * @param context
+     *        Parse context.
+     * @returns \c true if the input has no syntax error.
+     */
+    bool parse(
+        const TokenBuffer& tokens,
+        AST::FlatAst* ast,
+        ParseContext* context);
+
+    /**
+     * Sets the offset of the first character of the source text of the
+     * tokens, which is 0 by default. This allows a chunk taken from the
+     * middle of a file to be parsed with the offsets it has in the file. A
+     * source starting elsewhere than at 0 is taken to continue a program,
+     * which only affects the wording of syntax errors.
+     *
+     * @param offset
+     *        Offset in bytes.
+     */
+    void setOrigin(unsigned int offset);
+
+  private:
+    /**
+     * Parses all tokens, into the flat AST if there is one.
+     *
+     * @param tokens
+     *        Token buffer.
+     * @param context
+     *        Parse context.
+     * @returns \c true if the input has no syntax error.
+     */
+    bool parseProgram(const TokenBuffer& tokens, ParseContext* context);
+
+    /**
+     * Parses a statement, and appends it to the statement list or the flat
+     * AST.
+     *
+     * @returns \c false on error.
+     */
+    bool parseStatement(void);
+
+    /**
+     * Appends a statement node to the statement list and the context.
+     *
+     * @param node
+     *        Statement node.
+     */
+    void appendStatement(AST::NStatement* node);
+
+    /**
+     * Parses an expression, which is left as the only operand.
+     *
+     * @returns \c false on error.
+     */
+    bool parseExpression(void);
+
+    /**
+     * Applies the pending operators on top of the stack which bind at least
+     * as tightly as a given precedence, replacing their operands by the
+     * resulting expressions. An opening parenthesis stops the reduction.
+     *
+     * @param min_precedence
+     *        Minimum precedence, at least 1.
+     */
+    void reduce(int min_precedence);
+
+    /**
+     * Consumes the next token if it is of a given kind, and reports an error
+     * otherwise.
+     *
+     * @param kind
+     *        Expected kind.
+     * @param expected
+     *        Description of the expected tokens, or \c NULL.
+     * @returns \c true if the token was consumed.
+     */
+    bool expect(TokenBuffer::Kind kind, const char* expected);
+
+    /**
+     * Adds a syntax error at the next token to the context.
+     *
+     * @param expected
+     *        Description of the expected tokens, or \c NULL.
+     */
+    void error(const char* expected);
+
+    /**
+     * Adds an error message at the next token to the context.
+     *
+     * @param message
+     *        Error message.
+     */
+    void addDiagnostic(const std::string& message);
+
+    /**
+     * Gets the source offset of a token.
+     *
+     * @param token
+     *        Token index.
+     * @returns Offset in bytes, counted from the origin of the source.
+     */
+    unsigned int locate(unsigned int token) const;
+
+  private:
+    /**
+     * \brief Operand of a pending operator.
+     */
+    struct Operand {
+        /**
+         * Expression node, unless the flat AST is built.
+         */
+        AST::NExpression* node;
+
+        /**
+         * Index of the last node of the expression in the flat AST.
+         */
+        unsigned int index;
+
+        /**
+         * Index of the first token of the operand, at which a binary
+         * expression with the operand as left-hand side is located.
+         */
+        unsigned int start;
+    };
+
+    /**
+     * \brief Operator or opening parenthesis waiting for its right-hand
+     * operand.
+     */
+    struct Operator {
+        /**
+         * Precedence, which is 0 for an opening parenthesis and
+         * UNARY_PRECEDENCE for a negation.
+         */
+        int precedence;
+
+        /**
+         * Operator of a binary expression.
+         */
+        AST::ExpressionOperator op;
+
+        /**
+         * Index of the token.
+         */
+        unsigned int token;
+    };
+
+  private:
+    /**
+     * Tokens being parsed.
+     */
+    const TokenBuffer* _tokens;
+
+    /**
+     * Context receiving the errors.
+     */
+    ParseContext* _context;
+
+    /**
+     * Arena of the context, in which the nodes are allocated.
+     */
+    AST::NodeArena* _arena;
+
+    /**
+     * Factory of the context, through which the expression nodes are created.
+     */
+    AST::ExpressionFactory* _expressions;
+
+    /**
+     * Flat AST to which the nodes are appended, or \c NULL if the
+     * pointer-based AST is built.
+     */
+    AST::FlatAst* _flat;
+
+    /**
+     * Statement list of the pointer-based AST.
+     */
+    AST::NStatementList* _statements;
+
+    /**
+     * Index of the next token.
+     */
+    unsigned int _next;
+
+    /**
+     * Operands of the expression being parsed, innermost last.
+     */
+    std::vector<Operand> _operands;
+
+    /**
+     * Pending operators of the expression being parsed, innermost last.
+     */
+    std::vector<Operator> _operators;
+
+    /**
+     * Offset of the first character of the source text.
+     */
+    unsigned int _origin;
+};
+
+#endif
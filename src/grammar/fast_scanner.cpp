@@ -0,0 +1,327 @@
+#include "fast_scanner.hpp"
+#include <climits>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+using std::string;
+
+TokenBuffer::TokenBuffer(void)
+        : _source(NULL), _source_size(0), _has_newlines(false)
+{}
+
+TokenBuffer::~TokenBuffer(void) {}
+
+string TokenBuffer::getText(unsigned int i) const {
+    return string(_source + _offsets[i], _lengths[i]);
+}
+
+void TokenBuffer::getLocation(unsigned int i, int* line, int* column) const {
+    getNewlineIndex().lookUp(_offsets[i], line, column);
+}
+
+const NewlineIndex& TokenBuffer::getNewlineIndex(void) const {
+    if (!_has_newlines) {
+        _newlines.build(_source, _source_size);
+        _has_newlines = true;
+    }
+    return _newlines;
+}
+
+const char* TokenBuffer::getSource(void) const {
+    return _source;
+}
+
+size_t TokenBuffer::getSourceSize(void) const {
+    return _source_size;
+}
+
+namespace {
+
+/**
+ * Classes of the first byte of a token.
+ */
+enum StartClass {
+    START_UNKNOWN,
+    START_LETTER,
+    START_DIGIT,
+    START_BLANK,
+    START_NEWLINE,
+    START_OPERATOR
+};
+
+/**
+ * Character classes of the bytes which may continue a token.
+ */
+enum RunClass {
+    /**
+     * <code>[a-zA-Z0-9_]</code>
+     */
+    RUN_IDENTIFIER,
+
+    /**
+     * <code>[0-9]</code>
+     */
+    RUN_DIGIT,
+
+    /**
+     * <code>[ \\r\\t\\n]</code>
+     */
+    RUN_SPACE
+};
+
+/**
+ * Table of the start class of every byte value, and of the token kind of
+ * every operator.
+ */
+class StartTable {
+  public:
+    StartTable(void) {
+        for (int c = 0; c < 256; c++) {
+            classes[c] = START_UNKNOWN;
+            kinds[c] = TokenBuffer::UNKNOWN;
+        }
+        for (int c = 'a'; c <= 'z'; c++) classes[c] = START_LETTER;
+        for (int c = 'A'; c <= 'Z'; c++) classes[c] = START_LETTER;
+        for (int c = '0'; c <= '9'; c++) classes[c] = START_DIGIT;
+        classes[static_cast<unsigned char>(' ')] = START_BLANK;
+        classes[static_cast<unsigned char>('\r')] = START_BLANK;
+        classes[static_cast<unsigned char>('\t')] = START_BLANK;
+        classes[static_cast<unsigned char>('\n')] = START_NEWLINE;
+        setOperator('=', TokenBuffer::EQUAL);
+        setOperator(';', TokenBuffer::SEMICOLON);
+        setOperator('+', TokenBuffer::PLUS);
+        setOperator('-', TokenBuffer::MINUS);
+        setOperator('*', TokenBuffer::MUL);
+        setOperator('/', TokenBuffer::DIV);
+        setOperator('(', TokenBuffer::LPAREN);
+        setOperator(')', TokenBuffer::RPAREN);
+    }
+
+  private:
+    void setOperator(char c, TokenBuffer::Kind kind) {
+        classes[static_cast<unsigned char>(c)] = START_OPERATOR;
+        kinds[static_cast<unsigned char>(c)] = kind;
+    }
+
+  public:
+    unsigned char classes[256];
+    unsigned char kinds[256];
+};
+
+const StartTable START_TABLE;
+
+/**
+ * Checks whether a byte belongs to a run class.
+ *
+ * @param c
+ *        Byte.
+ * @param cls
+ *        Run class.
+ * @returns \c true if it does.
+ */
+inline bool isInRun(unsigned char c, RunClass cls) {
+    switch (cls) {
+        case RUN_IDENTIFIER: {
+            return static_cast<unsigned char>((c | 0x20) - 'a') < 26
+                || static_cast<unsigned char>(c - '0') < 10
+                || c == '_';
+        }
+
+        case RUN_DIGIT: {
+            return static_cast<unsigned char>(c - '0') < 10;
+        }
+
+        default: {
+            return c == ' ' || c == '\r' || c == '\t' || c == '\n';
+        }
+    }
+}
+
+#ifdef __AVX2__
+
+/**
+ * Checks which bytes of a block lie in a range.
+ */
+inline __m256i inRange(__m256i block, char low, char high) {
+    __m256i shifted = _mm256_sub_epi8(block, _mm256_set1_epi8(low));
+    __m256i limit = _mm256_set1_epi8(static_cast<char>(high - low));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, limit), shifted);
+}
+
+/**
+ * Gets a mask of the bytes of a 32-byte block which belong to a run class.
+ */
+inline unsigned int runMask(const char* p, RunClass cls) {
+    __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i hits;
+    switch (cls) {
+        case RUN_IDENTIFIER: {
+            __m256i lower = _mm256_or_si256(block, _mm256_set1_epi8(0x20));
+            hits = _mm256_or_si256(
+                _mm256_or_si256(inRange(lower, 'a', 'z'),
+                                inRange(block, '0', '9')),
+                _mm256_cmpeq_epi8(block, _mm256_set1_epi8('_')));
+            break;
+        }
+
+        case RUN_DIGIT: {
+            hits = inRange(block, '0', '9');
+            break;
+        }
+
+        default: {
+            hits = _mm256_or_si256(
+                _mm256_or_si256(
+                    _mm256_cmpeq_epi8(block, _mm256_set1_epi8(' ')),
+                    _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\t'))),
+                _mm256_or_si256(
+                    _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\r')),
+                    _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\n'))));
+            break;
+        }
+    }
+    return static_cast<unsigned int>(_mm256_movemask_epi8(hits));
+}
+
+const size_t BLOCK_SIZE = 32;
+const unsigned int FULL_MASK = 0xFFFFFFFFu;
+
+#elif defined(__SSE2__)
+
+/**
+ * Checks which bytes of a block lie in a range.
+ */
+inline __m128i inRange(__m128i block, char low, char high) {
+    __m128i shifted = _mm_sub_epi8(block, _mm_set1_epi8(low));
+    __m128i limit = _mm_set1_epi8(static_cast<char>(high - low));
+    return _mm_cmpeq_epi8(_mm_min_epu8(shifted, limit), shifted);
+}
+
+/**
+ * Gets a mask of the bytes of a 16-byte block which belong to a run class.
+ */
+inline unsigned int runMask(const char* p, RunClass cls) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i hits;
+    switch (cls) {
+        case RUN_IDENTIFIER: {
+            __m128i lower = _mm_or_si128(block, _mm_set1_epi8(0x20));
+            hits = _mm_or_si128(
+                _mm_or_si128(inRange(lower, 'a', 'z'),
+                             inRange(block, '0', '9')),
+                _mm_cmpeq_epi8(block, _mm_set1_epi8('_')));
+            break;
+        }
+
+        case RUN_DIGIT: {
+            hits = inRange(block, '0', '9');
+            break;
+        }
+
+        default: {
+            hits = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(' ')),
+                             _mm_cmpeq_epi8(block, _mm_set1_epi8('\t'))),
+                _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('\r')),
+                             _mm_cmpeq_epi8(block, _mm_set1_epi8('\n'))));
+            break;
+        }
+    }
+    return static_cast<unsigned int>(_mm_movemask_epi8(hits));
+}
+
+const size_t BLOCK_SIZE = 16;
+const unsigned int FULL_MASK = 0xFFFFu;
+
+#endif
+
+/**
+ * Skips the bytes which belong to a run class.
+ *
+ * @param p
+ *        First byte to check.
+ * @param end
+ *        End of the source text.
+ * @param cls
+ *        Run class.
+ * @returns Pointer to the first byte which does not belong to the class.
+ */
+inline const char* skipRun(const char* p, const char* end, RunClass cls) {
+#if defined(__AVX2__) || defined(__SSE2__)
+    while (static_cast<size_t>(end - p) >= BLOCK_SIZE) {
+        unsigned int mask = runMask(p, cls);
+        if (mask != FULL_MASK) return p + __builtin_ctz(~mask);
+        p += BLOCK_SIZE;
+    }
+#endif
+    while (p < end && isInRun(static_cast<unsigned char>(*p), cls)) p++;
+    return p;
+}
+
+}
+
+FastScanner::FastScanner(void) {}
+
+FastScanner::~FastScanner(void) {}
+
+bool FastScanner::scan(const char* data, size_t size, TokenBuffer* tokens)
+    const
+{
+    tokens->_source = data;
+    tokens->_source_size = size;
+    tokens->_has_newlines = false;
+    tokens->_kinds.clear();
+    tokens->_offsets.clear();
+    tokens->_lengths.clear();
+    if (size > UINT_MAX) return false;
+
+    // Real programs have roughly one token per four bytes
+    size_t estimate = size / 4 + 16;
+    tokens->_kinds.reserve(estimate);
+    tokens->_offsets.reserve(estimate);
+    tokens->_lengths.reserve(estimate);
+
+    const char* p = data;
+    const char* end = data + size;
+    while (p < end) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        const char* start = p;
+        unsigned char kind;
+        switch (START_TABLE.classes[c]) {
+            case START_BLANK:
+            case START_NEWLINE: {
+                p = skipRun(p + 1, end, RUN_SPACE);
+                continue;
+            }
+
+            case START_LETTER: {
+                p = skipRun(p + 1, end, RUN_IDENTIFIER);
+                kind = (p - start == 5 && memcmp(start, "print", 5) == 0)
+                    ? TokenBuffer::PRINT : TokenBuffer::IDENTIFIER;
+                break;
+            }
+
+            case START_DIGIT: {
+                p = skipRun(p + 1, end, RUN_DIGIT);
+                kind = TokenBuffer::NUMBER;
+                break;
+            }
+
+            default: {
+                p++;
+                kind = START_TABLE.kinds[c];
+                break;
+            }
+        }
+        tokens->_kinds.push_back(kind);
+        tokens->_offsets.push_back(static_cast<unsigned int>(start - data));
+        tokens->_lengths.push_back(static_cast<unsigned int>(p - start));
+    }
+
+    return true;
+}
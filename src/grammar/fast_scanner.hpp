@@ -0,0 +1,267 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CEE_GRAMMAR_FAST_SCANNER__H
+#define CEE_GRAMMAR_FAST_SCANNER__H
+
+/**
+ * @file
+ * @brief Defines a hand-written scanner which tokenizes a whole buffer at once.
+ */
+
+#include "newline_index.hpp"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Token array produced by the FastScanner.
+ *
+ * The TokenBuffer class stores the tokens of a source text as a structure of
+ * arrays: one array of kinds, one of byte offsets into the source text and
+ * one of lengths. Whitespace and newlines produce no tokens. The token text
+ * is not copied; it is read from the source text, which must therefore
+ * outlive the buffer.
+ *
+ * Lines and columns are not computed while scanning. The first call to
+ * getLocation() builds a NewlineIndex of the source text.
+ */
+class TokenBuffer {
+  public:
+    /**
+     * Token kinds. These correspond to the tokens of the flex scanner
+     * (<code>T_IDENTIFIER</code> and so on).
+     */
+    enum Kind {
+        IDENTIFIER,
+        NUMBER,
+        PRINT,
+        EQUAL,
+        SEMICOLON,
+        PLUS,
+        MINUS,
+        MUL,
+        DIV,
+        LPAREN,
+        RPAREN,
+
+        /**
+         * Any single byte which does not start another token.
+         */
+        UNKNOWN
+    };
+
+  public:
+    /**
+     * Creates an empty token buffer.
+     */
+    TokenBuffer(void);
+
+    /**
+     * Destroys this token buffer.
+     */
+    ~TokenBuffer(void);
+
+    /**
+     * Gets the number of tokens.
+     *
+     * @returns Number of tokens.
+     */
+    unsigned int getNumTokens(void) const {
+        return _kinds.size();
+    }
+
+    /**
+     * Gets the kind of a token.
+     *
+     * @param i
+     *        Token index.
+     * @returns Token kind.
+     */
+    Kind getKind(unsigned int i) const {
+        return static_cast<Kind>(_kinds[i]);
+    }
+
+    /**
+     * Gets the byte offset of a token in the source text.
+     *
+     * @param i
+     *        Token index.
+     * @returns Byte offset.
+     */
+    unsigned int getOffset(unsigned int i) const {
+        return _offsets[i];
+    }
+
+    /**
+     * Gets the length of a token.
+     *
+     * @param i
+     *        Token index.
+     * @returns Length (in bytes).
+     */
+    unsigned int getLength(unsigned int i) const {
+        return _lengths[i];
+    }
+
+    /**
+     * Gets a pointer to the text of a token. The text is not
+     * <code>NUL</code>-terminated.
+     *
+     * @param i
+     *        Token index.
+     * @returns Pointer into the source text.
+     */
+    const char* getTextPointer(unsigned int i) const {
+        return _source + _offsets[i];
+    }
+
+    /**
+     * Gets a copy of the text of a token.
+     *
+     * @param i
+     *        Token index.
+     * @returns Token text.
+     */
+    std::string getText(unsigned int i) const;
+
+    /**
+     * Finds the line and column at which a token starts.
+     *
+     * @param i
+     *        Token index.
+     * @param line
+     *        Destination of the line.
+     * @param column
+     *        Destination of the column.
+     */
+    void getLocation(unsigned int i, int* line, int* column) const;
+
+    /**
+     * Gets the newline index of the source text, building it if necessary.
+     *
+     * @returns Newline index.
+     */
+    const NewlineIndex& getNewlineIndex(void) const;
+
+    /**
+     * Gets the source text.
+     *
+     * @returns Source text.
+     */
+    const char* getSource(void) const;
+
+    /**
+     * Gets the size of the source text.
+     *
+     * @returns Size (in bytes).
+     */
+    size_t getSourceSize(void) const;
+
+  private:
+    friend class FastScanner;
+
+    /**
+     * Source text.
+     */
+    const char* _source;
+
+    /**
+     * Size of the source text.
+     */
+    size_t _source_size;
+
+    /**
+     * Kind of each token.
+     */
+    std::vector<unsigned char> _kinds;
+
+    /**
+     * Byte offset of each token.
+     */
+    std::vector<unsigned int> _offsets;
+
+    /**
+     * Length of each token.
+     */
+    std::vector<unsigned int> _lengths;
+
+    /**
+     * Newline index of the source text (built on demand).
+     */
+    mutable NewlineIndex _newlines;
+
+    /**
+     * Whether _newlines has been built.
+     */
+    mutable bool _has_newlines;
+};
+
+/**
+ * \brief Hand-written scanner which tokenizes a whole buffer at once.
+ *
+ * The FastScanner class is an alternative to the flex scanner
+ * (<code>scanner.l</code>) and accepts exactly the same tokens:
+ *     - identifiers <code>[a-zA-Z][a-zA-Z0-9_]*</code>, of which
+ *       <code>print</code> is the keyword,
+ *     - numbers <code>[0-9]+</code>,
+ *     - the operators <code>= ; + - * / ( )</code>,
+ *     - blanks <code>[ \\r\\t]</code> and newlines, which are skipped, and
+ *     - any other single byte, as TokenBuffer::UNKNOWN.
+ *
+ * The first byte of a token is classified through a table, and the rest of an
+ * identifier, number or blank run is skipped 16 bytes (SSE2) or 32 bytes
+ * (AVX2) at a time when the target supports it.
+ *
+ * As offsets are 32 bits wide, the source text must be smaller than 4 GB.
+ */
+class FastScanner {
+  public:
+    /**
+     * Creates a scanner.
+     */
+    FastScanner(void);
+
+    /**
+     * Destroys this scanner.
+     */
+    ~FastScanner(void);
+
+    /**
+     * Tokenizes a source text, replacing the content of a token buffer.
+     *
+     * @param data
+     *        Source text.
+     * @param size
+     *        Size of the source text (in bytes).
+     * @param tokens
+     *        Destination token buffer.
+     * @returns \c false if the source text is too large.
+     */
+    bool scan(const char* data, size_t size, TokenBuffer* tokens) const;
+};
+
+#endif
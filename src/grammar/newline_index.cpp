@@ -0,0 +1,62 @@
+#include "newline_index.hpp"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using std::vector;
+
+NewlineIndex::NewlineIndex(void) : _size(0) {
+    _line_starts.push_back(0);
+}
+
+NewlineIndex::~NewlineIndex(void) {}
+
+void NewlineIndex::build(const char* data, size_t size) {
+    _line_starts.clear();
+    _line_starts.push_back(0);
+    _size = 0;
+    append(data, size);
+}
+
+void NewlineIndex::append(const char* data, size_t size) {
+    const size_t base = _size;
+    _size += size;
+
+    size_t i = 0;
+#ifdef __SSE2__
+    // Compare 16 bytes at a time and visit only the set bits of the mask
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; i + 16 <= size; i += 16) {
+        __m128i block = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(data + i));
+        unsigned int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+        while (mask) {
+            _line_starts.push_back(base + i + __builtin_ctz(mask) + 1);
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i < size; i++) {
+        if (data[i] == '\n') _line_starts.push_back(base + i + 1);
+    }
+}
+
+void NewlineIndex::lookUp(size_t offset, int* line, int* column) const {
+    // Binary search for the last line which starts at or before the offset
+    unsigned int low = 0, high = _line_starts.size();
+    while (high - low > 1) {
+        unsigned int mid = low + (high - low) / 2;
+        if (_line_starts[mid] <= offset) low = mid;
+        else high = mid;
+    }
+    *line = low + 1;
+    *column = static_cast<int>(offset - _line_starts[low]) + 1;
+}
+
+unsigned int NewlineIndex::getNumLines(void) const {
+    return _line_starts.size();
+}
+
+size_t NewlineIndex::getLineStart(unsigned int line) const {
+    return _line_starts[line - 1];
+}
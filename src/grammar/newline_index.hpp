@@ -0,0 +1,122 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CEE_GRAMMAR_NEWLINE_INDEX__H
+#define CEE_GRAMMAR_NEWLINE_INDEX__H
+
+/**
+ * @file
+ * @brief Defines the classes for mapping source offsets to lines and columns.
+ */
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * \brief Maps source offsets to lines and columns.
+ *
+ * The NewlineIndex class records the offset at which every line of a source
+ * text starts, so that the line and column of any byte offset can be found by
+ * a binary search. This allows tokens to carry only their offset, and the
+ * line and column to be computed when a diagnostic actually needs them.
+ *
+ * Lines and columns are counted from 1, and every byte (including tabs)
+ * advances the column by one, as in the flex scanner.
+ */
+class NewlineIndex {
+  public:
+    /**
+     * Creates an index of an empty source text.
+     */
+    NewlineIndex(void);
+
+    /**
+     * Destroys this index.
+     */
+    ~NewlineIndex(void);
+
+    /**
+     * Builds the index of a source text, replacing any previous content.
+     *
+     * @param data
+     *        Source text.
+     * @param size
+     *        Size of the source text (in bytes).
+     */
+    void build(const char* data, size_t size);
+
+    /**
+     * Extends the index with the next piece of a source text, for when the
+     * text is not available all at once.
+     *
+     * @param data
+     *        Piece of the source text.
+     * @param size
+     *        Size of the piece (in bytes).
+     */
+    void append(const char* data, size_t size);
+
+    /**
+     * Finds the line and column of a source offset.
+     *
+     * @param offset
+     *        Byte offset into the source text.
+     * @param line
+     *        Destination of the line.
+     * @param column
+     *        Destination of the column.
+     */
+    void lookUp(size_t offset, int* line, int* column) const;
+
+    /**
+     * Gets the number of lines.
+     *
+     * @returns Number of lines (at least 1).
+     */
+    unsigned int getNumLines(void) const;
+
+    /**
+     * Gets the offset at which a line starts.
+     *
+     * @param line
+     *        Line (counted from 1, at most getNumLines()).
+     * @returns Byte offset.
+     */
+    size_t getLineStart(unsigned int line) const;
+
+  private:
+    /**
+     * Offset of the first byte of each line.
+     */
+    std::vector<size_t> _line_starts;
+
+    /**
+     * Size of the indexed source text (in bytes).
+     */
+    size_t _size;
+};
+
+#endif
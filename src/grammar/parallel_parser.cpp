@@ -0,0 +1,207 @@
+#include "parallel_parser.hpp"
+#include "fast_parser.hpp"
+#include <climits>
+#include <cstring>
+#include <pthread.h>
+#include <unistd.h>
+
+using namespace AST;
+using std::vector;
+
+ParallelParser::ParallelParser(
+    unsigned int num_threads,
+    size_t min_chunk_size)
+        : _num_threads(num_threads),
+          _min_chunk_size(min_chunk_size > 0 ? min_chunk_size : 1),
+          _flat(NULL),
+          _next_chunk(0)
+{
+    if (_num_threads == 0) {
+        long num_processors = sysconf(_SC_NPROCESSORS_ONLN);
+        _num_threads = num_processors > 0 ? num_processors : 1;
+    }
+}
+
+ParallelParser::~ParallelParser(void) {
+    for (size_t i = 0; i < _chunks.size(); i++) {
+        delete _chunks[i];
+    }
+}
+
+bool ParallelParser::parse(
+    const char* data,
+    size_t size,
+    ParseContext* context)
+{
+    _flat = NULL;
+    return parseChunks(data, size, context);
+}
+
+bool ParallelParser::parse(
+    const char* data,
+    size_t size,
+    FlatAst* ast,
+    ParseContext* context)
+{
+    ast->clear();
+    _flat = ast;
+    bool result = parseChunks(data, size, context);
+    _flat = NULL;
+    return result;
+}
+
+size_t ParallelParser::getNumChunks(void) const {
+    return _chunks.size();
+}
+
+bool ParallelParser::parseChunks(
+    const char* data,
+    size_t size,
+    ParseContext* context)
+{
+    if (size > UINT_MAX) {
+        context->addDiagnostic(0, "source text is too large");
+        return false;
+    }
+
+    cut(data, size);
+    bool sharing = context->getExpressionFactory()->isSharing();
+    for (size_t i = 0; i < _chunks.size(); i++) {
+        _chunks[i]->context.getExpressionFactory()->setSharing(sharing);
+    }
+    run();
+
+    // Report the first error, which is the one a sequential parse finds
+    for (size_t i = 0; i < _chunks.size(); i++) {
+        Chunk& chunk = *_chunks[i];
+        if (chunk.parsed) continue;
+        const vector<ParseContext::Diagnostic>& diagnostics =
+            chunk.context.getDiagnostics();
+        for (size_t j = 0; j < diagnostics.size(); j++) {
+            context->addDiagnostic(diagnostics[j].offset,
+                                   diagnostics[j].message);
+        }
+        return false;
+    }
+
+    // The nodes of the flat ASTs only refer into the source text, so nothing
+    // else is needed from the chunks
+    if (_flat) {
+        for (size_t i = 0; i < _chunks.size(); i++) {
+            _flat->appendStatements(&_chunks[i]->flat);
+        }
+        return true;
+    }
+
+    // Join the statements of all chunks into the program of the first one,
+    // which has the offset of the first statement. The nodes are moved into
+    // the arena of the context, as the chunks do not outlive the parser
+    NProgram* program = _chunks[0]->context.getProgram();
+    NStatementList* statements = program->getStatementList();
+    for (size_t i = 0; i < _chunks.size(); i++) {
+        Chunk& chunk = *_chunks[i];
+        NProgram* chunk_program = chunk.context.getProgram();
+        if (i > 0 && chunk_program) {
+            statements->appendStatements(chunk_program->getStatementList());
+        }
+        context->getArena()->splice(chunk.context.getArena());
+    }
+    context->setProgram(program);
+    return true;
+}
+
+void ParallelParser::cut(const char* data, size_t size) {
+    for (size_t i = 0; i < _chunks.size(); i++) {
+        delete _chunks[i];
+    }
+    _chunks.clear();
+
+    size_t chunk_size = size / (_num_threads * CHUNKS_PER_THREAD);
+    if (chunk_size < _min_chunk_size) chunk_size = _min_chunk_size;
+    if (chunk_size > MAX_CHUNK_SIZE) chunk_size = MAX_CHUNK_SIZE;
+
+    // Each chunk is extended up to and including the next semicolon
+    size_t start = 0;
+    do {
+        size_t end = size;
+        if (size - start > chunk_size) {
+            const void* semicolon = memchr(data + start + chunk_size, ';',
+                                           size - start - chunk_size);
+            if (semicolon) {
+                end = static_cast<const char*>(semicolon) - data + 1;
+            }
+        }
+
+        Chunk* chunk = new Chunk;
+        chunk->data = data + start;
+        chunk->size = end - start;
+        chunk->offset = start;
+        chunk->scanned = false;
+        chunk->parsed = false;
+        _chunks.push_back(chunk);
+        start = end;
+    } while (start < size);
+}
+
+void ParallelParser::run(void) {
+    _next_chunk = 0;
+
+    // The calling thread is one of the workers
+    size_t num_threads = _num_threads;
+    if (num_threads > _chunks.size()) num_threads = _chunks.size();
+    vector<pthread_t> threads;
+    for (size_t i = 1; i < num_threads; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, runWorker, this) != 0) break;
+        threads.push_back(thread);
+    }
+    work();
+    for (size_t i = 0; i < threads.size(); i++) {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+void* ParallelParser::runWorker(void* parser) {
+    static_cast<ParallelParser*>(parser)->work();
+    return NULL;
+}
+
+void ParallelParser::work(void) {
+    for (;;) {
+        size_t i = __sync_fetch_and_add(&_next_chunk, 1);
+        if (i >= _chunks.size()) return;
+        parseChunk(_chunks[i], i == 0);
+    }
+}
+
+void ParallelParser::parseChunk(Chunk* chunk, bool is_first) {
+    FastScanner scanner;
+    chunk->scanned = scanner.scan(chunk->data, chunk->size, &chunk->tokens);
+    if (!chunk->scanned) {
+        chunk->context.addDiagnostic(chunk->offset, "statement is too large");
+        return;
+    }
+
+    // Only the last chunk can be empty, as every other chunk ends with a
+    // semicolon, and an empty end of a program is no error
+    if (!is_first && chunk->tokens.getNumTokens() == 0) {
+        chunk->parsed = true;
+        return;
+    }
+
+    FastParser parser;
+    parser.setOrigin(chunk->offset);
+    if (_flat) {
+        chunk->parsed =
+            parser.parse(chunk->tokens, &chunk->flat, &chunk->context);
+    }
+    else {
+        chunk->parsed = parser.parse(chunk->tokens, &chunk->context);
+    }
+}
+
+const size_t ParallelParser::DEFAULT_MIN_CHUNK_SIZE = 1 << 20;
+
+const size_t ParallelParser::MAX_CHUNK_SIZE = 1 << 30;
+
+const unsigned int ParallelParser::CHUNKS_PER_THREAD = 4;
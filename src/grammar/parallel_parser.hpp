@@ -0,0 +1,287 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CEE_GRAMMAR_PARALLEL_PARSER__H
+#define CEE_GRAMMAR_PARALLEL_PARSER__H
+
+/**
+ * @file
+ * @brief Defines a parser which parses chunks of a source text in parallel.
+ */
+
+#include "../ast/flat_ast.hpp"
+#include "fast_scanner.hpp"
+#include "parse_context.hpp"
+#include <cstddef>
+#include <vector>
+
+/**
+ * \brief Parser which parses chunks of a source text in parallel.
+ *
+ * Every statement ends with a semicolon, and a semicolon cannot appear
+ * anywhere else, so a source text can be cut right after any semicolon
+ * without splitting a statement. The ParallelParser class cuts the text into
+ * chunks in this way, and has a pool of threads scan and parse them with the
+ * FastScanner and the FastParser. Each chunk is parsed with the offset at
+ * which it starts in the text, and the statement lists of the chunks are
+ * then joined in order. The result is the same AST as parsing the whole text
+ * with the FastParser, with the same offsets and in the same statement
+ * order, so that e.g. the SymbolTableBuilder sees the declarations in order.
+ *
+ * As the offset of a chunk is known when it is cut, every chunk is scanned
+ * and parsed in one go. A syntax error is reported from the first chunk
+ * which has one, which is the error the FastParser would have found. Source
+ * texts larger than the range of the offsets (4 GB) are rejected.
+ *
+ * As the identifier and number nodes refer into the source text, the text
+ * must outlive the AST. The statements are parsed out of order, so they are
+ * not passed to ParseContext::addStatement() of the given context. When the
+ * AST::ExpressionFactory of the context shares expressions, every chunk
+ * shares the expressions within itself only, so the DAG is correct but may
+ * hold some identical nodes which a sequential parse would have shared.
+ *
+ * The chunks can also be parsed into flat ASTs, which are then appended to
+ * one AST::FlatAst in order, so that no pointer-based AST is built.
+ */
+class ParallelParser {
+  public:
+    /**
+     * Creates a parser.
+     *
+     * @param num_threads
+     *        Number of threads, or 0 for one per online processor.
+     * @param min_chunk_size
+     *        Smallest size of a chunk (in bytes) before it is cut.
+     */
+    ParallelParser(
+        unsigned int num_threads = 0,
+        size_t min_chunk_size = DEFAULT_MIN_CHUNK_SIZE);
+
+    /**
+     * Destroys this parser.
+     */
+    ~ParallelParser(void);
+
+    /**
+     * Parses a source text. On success, the root of the AST is set in the
+     * context, and otherwise the syntax error is added to it.
+     *
+     * @param data
+     *        Source text.
+     * @param size
+     *        Size of the source text (in bytes).
+     * @param context
+     *        Parse context.
+     * @returns \c true if the input has no syntax error.
+     */
+    bool parse(const char* data, size_t size, ParseContext* context);
+
+    /**
+     * Parses a source text into a flat AST, without building the
+     * pointer-based AST. The syntax error, if any, is added to the context,
+     * which gets no program.
+     *
+     * @param data
+     *        Source text.
+     * @param size
+     *        Size of the source text (in bytes).
+     * @param ast
+     *        Flat AST, which is cleared first.
+     * @param context
+     *        Parse context.
+     * @returns \c true if the input has no syntax error.
+     */
+    bool parse(
+        const char* data,
+        size_t size,
+        AST::FlatAst* ast,
+        ParseContext* context);
+
+    /**
+     * Gets the number of chunks of the last parsed source text.
+     *
+     * @returns Number of chunks.
+     */
+    size_t getNumChunks(void) const;
+
+  public:
+    /**
+     * Default smallest size of a chunk (in bytes).
+     */
+    static const size_t DEFAULT_MIN_CHUNK_SIZE;
+
+  private:
+    /**
+     * \brief Chunk of the source text.
+     */
+    struct Chunk {
+        /**
+         * First character of the chunk.
+         */
+        const char* data;
+
+        /**
+         * Size of the chunk (in bytes).
+         */
+        size_t size;
+
+        /**
+         * Offset of the first character of the chunk in the source text.
+         */
+        unsigned int offset;
+
+        /**
+         * Tokens of the chunk.
+         */
+        TokenBuffer tokens;
+
+        /**
+         * AST and syntax errors of the chunk.
+         */
+        ParseContext context;
+
+        /**
+         * Flat AST of the chunk, if the flat AST is built.
+         */
+        AST::FlatAst flat;
+
+        /**
+         * Whether the chunk has been scanned, which fails if it is too large
+         * for a TokenBuffer.
+         */
+        bool scanned;
+
+        /**
+         * Whether the chunk has been parsed without errors.
+         */
+        bool parsed;
+    };
+
+  private:
+    /**
+     * Cuts a source text into chunks, parses them and joins their ASTs, into
+     * the flat AST if there is one.
+     *
+     * @param data
+     *        Source text.
+     * @param size
+     *        Size of the source text (in bytes).
+     * @param context
+     *        Parse context.
+     * @returns \c true if the input has no syntax error.
+     */
+    bool parseChunks(const char* data, size_t size, ParseContext* context);
+
+    /**
+     * Cuts a source text into chunks.
+     *
+     * @param data
+     *        Source text.
+     * @param size
+     *        Size of the source text (in bytes).
+     */
+    void cut(const char* data, size_t size);
+
+    /**
+     * Scans and parses every chunk, using the pool of threads.
+     */
+    void run(void);
+
+    /**
+     * Entry point of the threads of the pool.
+     *
+     * @param parser
+     *        ParallelParser running the chunks.
+     * @returns \c NULL.
+     */
+    static void* runWorker(void* parser);
+
+    /**
+     * Takes chunks and scans and parses them until there are no chunks left.
+     */
+    void work(void);
+
+    /**
+     * Scans and parses a chunk.
+     *
+     * @param chunk
+     *        Chunk.
+     * @param is_first
+     *        Whether the chunk is the first one.
+     */
+    void parseChunk(Chunk* chunk, bool is_first);
+
+    /**
+     * Hidden copy constructor.
+     */
+    ParallelParser(const ParallelParser&);
+
+    /**
+     * Hidden assignment operator.
+     */
+    ParallelParser& operator=(const ParallelParser&);
+
+  private:
+    /**
+     * Largest size (in bytes) at which a chunk is aimed, which is well within
+     * the range of a TokenBuffer. A chunk is only larger if it has a longer
+     * statement.
+     */
+    static const size_t MAX_CHUNK_SIZE;
+
+    /**
+     * Number of chunks per thread which are aimed for, as chunks of equal
+     * size may still take different times.
+     */
+    static const unsigned int CHUNKS_PER_THREAD;
+
+    /**
+     * Number of threads.
+     */
+    unsigned int _num_threads;
+
+    /**
+     * Smallest size of a chunk (in bytes).
+     */
+    size_t _min_chunk_size;
+
+    /**
+     * Chunks of the last parsed source text.
+     */
+    std::vector<Chunk*> _chunks;
+
+    /**
+     * Flat AST being built, or \c NULL if the pointer-based AST is built.
+     */
+    AST::FlatAst* _flat;
+
+    /**
+     * Index of the next chunk to be taken by a thread.
+     */
+    volatile size_t _next_chunk;
+};
+
+#endif
@@ -0,0 +1,80 @@
+#include "parse_context.hpp"
+#include "../io/reporter.hpp"
+
+using namespace AST;
+using std::string;
+using std::vector;
+
+ParseContext::ParseContext(void)
+        : _source(NULL), _source_size(0), _has_newlines(true),
+          _expressions(&_arena), _program(NULL)
+{}
+
+ParseContext::~ParseContext(void) {}
+
+void ParseContext::setSource(const char* data, size_t size) {
+    _source = data;
+    _source_size = size;
+    _has_newlines = false;
+}
+
+void ParseContext::appendSource(const char* data, size_t size) {
+    _newlines.append(data, size);
+    _source_size += size;
+}
+
+const NewlineIndex& ParseContext::getNewlineIndex(void) const {
+    if (!_has_newlines) {
+        _newlines.build(_source, _source_size);
+        _has_newlines = true;
+    }
+    return _newlines;
+}
+
+NodeArena* ParseContext::getArena(void) {
+    return &_arena;
+}
+
+ExpressionFactory* ParseContext::getExpressionFactory(void) {
+    return &_expressions;
+}
+
+void ParseContext::setProgram(NProgram* program) {
+    _program = program;
+}
+
+NProgram* ParseContext::getProgram(void) const {
+    return _program;
+}
+
+void ParseContext::releaseProgram(void) {
+    _program = NULL;
+    _expressions.clear();
+    _arena.release();
+}
+
+void ParseContext::addStatement(NStatement* statement) {}
+
+void ParseContext::addDiagnostic(unsigned int offset, const string& message) {
+    Diagnostic diagnostic;
+    diagnostic.offset = offset;
+    diagnostic.message = message;
+    _diagnostics.push_back(diagnostic);
+}
+
+bool ParseContext::hasDiagnostics(void) const {
+    return !_diagnostics.empty();
+}
+
+const vector<ParseContext::Diagnostic>& ParseContext::getDiagnostics(void)
+    const
+{
+    return _diagnostics;
+}
+
+void ParseContext::reportDiagnostics(void) const {
+    Reporter& out = *Reporter::getInstance();
+    for (size_t i = 0; i < _diagnostics.size(); i++) {
+        out << out.beginError() << _diagnostics[i].message << out.endl();
+    }
+}
@@ -0,0 +1,256 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CEE_GRAMMAR_PARSE_CONTEXT__H
+#define CEE_GRAMMAR_PARSE_CONTEXT__H
+
+/**
+ * @file
+ * @brief Defines the state of a single parse.
+ */
+
+#include "../ast/ast.hpp"
+#include "../ast/expression_factory.hpp"
+#include "newline_index.hpp"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * \brief State of a single parse.
+ *
+ * The ParseContext class holds everything a parse produces: the root of the
+ * AST and the syntax errors found on the way. Nodes and errors are located by
+ * their source offset only, and the context also holds the NewlineIndex which
+ * turns an offset into a line and column when one is needed. The parsers
+ * write into a context given by the caller instead of into globals, so any
+ * number of sources may be parsed at the same time as long as each parse has
+ * its own context (and, for the bison parser, its own flex scanner).
+ *
+ * The nodes of the AST are allocated in the AST::NodeArena of the context,
+ * and are all released together with it. The expression nodes are created
+ * through the AST::ExpressionFactory of the context, which can be told to
+ * share identical expressions and so build a DAG instead of a tree.
+ *
+ * The errors are only collected. It is up to the caller to report them, which
+ * is done with reportDiagnostics().
+ *
+ * The bison parser and the FastParser also pass every statement to
+ * addStatement() as soon as it has been parsed. A derived class may override
+ * it to process a program while the rest of it is still being parsed.
+ */
+class ParseContext {
+  public:
+    /**
+     * \brief Syntax error found by a parser.
+     */
+    struct Diagnostic {
+        /**
+         * Source offset at which the error was found.
+         */
+        unsigned int offset;
+
+        /**
+         * Error message.
+         */
+        std::string message;
+    };
+
+  public:
+    /**
+     * Creates an empty context.
+     */
+    ParseContext(void);
+
+    /**
+     * Destroys this context, together with the AST in its arena.
+     */
+    virtual ~ParseContext(void);
+
+    /**
+     * Sets the source text being parsed. The text must outlive the context,
+     * as its NewlineIndex is only built when first needed.
+     *
+     * @param data
+     *        Source text.
+     * @param size
+     *        Size of the source text (in bytes).
+     */
+    void setSource(const char* data, size_t size);
+
+    /**
+     * Adds the next piece of the source text being parsed, instead of setting
+     * all of it with setSource(), for when the text is not available all at
+     * once. The piece is indexed right away, and need not outlive the call.
+     *
+     * @param data
+     *        Piece of the source text.
+     * @param size
+     *        Size of the piece (in bytes).
+     */
+    void appendSource(const char* data, size_t size);
+
+    /**
+     * Gets the NewlineIndex of the source text, building it if necessary.
+     *
+     * @returns Newline index.
+     */
+    const NewlineIndex& getNewlineIndex(void) const;
+
+    /**
+     * Gets the arena in which the nodes of the AST are allocated.
+     *
+     * @returns Node arena.
+     */
+    AST::NodeArena* getArena(void);
+
+    /**
+     * Gets the factory through which the parsers create expression nodes in
+     * the arena of this context. Sharing is off unless turned on by the
+     * caller before the parse.
+     *
+     * @returns Expression factory.
+     */
+    AST::ExpressionFactory* getExpressionFactory(void);
+
+    /**
+     * Sets the root of the AST, which must have been allocated in the arena
+     * of this context.
+     *
+     * @param program
+     *        Program node.
+     */
+    void setProgram(AST::NProgram* program);
+
+    /**
+     * Gets the root of the AST.
+     *
+     * @returns Program node, or \c NULL if none has been set. It is valid as
+     *          long as the context.
+     */
+    AST::NProgram* getProgram(void) const;
+
+    /**
+     * Releases the AST and everything else in the arena of this context, e.g.
+     * once it has been converted into an AST::FlatAst whose texts refer into
+     * the source text.
+     */
+    void releaseProgram(void);
+
+    /**
+     * Called when a statement has been parsed, in source order. The statement
+     * is owned by the statement list of the program being built, and there
+     * may still be a syntax error later on. Does nothing by default.
+     *
+     * @param statement
+     *        Statement node.
+     */
+    virtual void addStatement(AST::NStatement* statement);
+
+    /**
+     * Adds a syntax error.
+     *
+     * @param offset
+     *        Source offset of the error.
+     * @param message
+     *        Error message.
+     */
+    void addDiagnostic(unsigned int offset, const std::string& message);
+
+    /**
+     * Checks whether any syntax error has been added.
+     *
+     * @returns \c true if so.
+     */
+    bool hasDiagnostics(void) const;
+
+    /**
+     * Gets the syntax errors, in the order in which they were added.
+     *
+     * @returns Syntax errors.
+     */
+    const std::vector<Diagnostic>& getDiagnostics(void) const;
+
+    /**
+     * Reports every syntax error through the Reporter. Only the messages are
+     * printed, as the parsers have always done.
+     */
+    void reportDiagnostics(void) const;
+
+  private:
+    /**
+     * Hidden copy constructor, as the context owns the AST.
+     */
+    ParseContext(const ParseContext&);
+
+    /**
+     * Hidden assignment operator, as the context owns the AST.
+     */
+    ParseContext& operator=(const ParseContext&);
+
+  private:
+    /**
+     * Source text, or \c NULL if none has been set.
+     */
+    const char* _source;
+
+    /**
+     * Size of the source text (in bytes).
+     */
+    size_t _source_size;
+
+    /**
+     * Newline index of the source text.
+     */
+    mutable NewlineIndex _newlines;
+
+    /**
+     * Whether the newline index is up to date.
+     */
+    mutable bool _has_newlines;
+
+    /**
+     * Arena holding the nodes of the AST.
+     */
+    AST::NodeArena _arena;
+
+    /**
+     * Factory of the expression nodes.
+     */
+    AST::ExpressionFactory _expressions;
+
+    /**
+     * Root of the AST.
+     */
+    AST::NProgram* _program;
+
+    /**
+     * Syntax errors.
+     */
+    std::vector<Diagnostic> _diagnostics;
+};
+
+#endif
@@ -1,6 +1,11 @@
-%pure-parser
+%define api.pure full
+%define api.push-pull both
+%define api.location.type {unsigned int}
 %locations
 %error-verbose
+%parse-param {void* scanner}
+%parse-param {ParseContext* context}
+%lex-param {void* scanner}
 
 %{
 /*
@@ -30,13 +35,68 @@
  */
 
 #include "common.hpp"
+#include <cstring>
+
+/* Locations are source offsets, and a rule is located at its first symbol. */
+#define YYLLOC_DEFAULT(Current, Rhs, N) \
+    (Current) = (N) ? YYRHSLOC(Rhs, 1) : YYRHSLOC(Rhs, 0)
+
+/* The parser stacks start with YYINITDEPTH entries and are doubled whenever
+   they are full. As the parser is compiled as C++, bison does not grow them
+   itself unless the location type is its own, and would stop at YYMAXDEPTH
+   anyway. The stacks are allocated in the arena of the context, so they are
+   released with the AST, and the nesting depth of a program is only limited
+   by the memory. */
+#define yyoverflow(message, states, states_size, values, values_size, \
+                   locations, locations_size, size) \
+    growStacks(context->getArena(), states, states_size, values, \
+               values_size, locations, locations_size, size)
+
+/* Doubles the parser stacks, given the bytes in use of each stack. */
+template <class State, class Value, class Location, class Size>
+static void growStacks(
+    NodeArena* arena,
+    State** states,
+    Size states_size,
+    Value** values,
+    Size values_size,
+    Location** locations,
+    Size locations_size,
+    Size* size)
+{
+    *size *= 2;
+    State* new_states =
+        static_cast<State*>(arena->allocate(*size * sizeof(State)));
+    Value* new_values =
+        static_cast<Value*>(arena->allocate(*size * sizeof(Value)));
+    Location* new_locations =
+        static_cast<Location*>(arena->allocate(*size * sizeof(Location)));
+    memcpy(new_states, *states, states_size);
+    memcpy(new_values, *values, values_size);
+    memcpy(new_locations, *locations, locations_size);
+    *states = new_states;
+    *values = new_values;
+    *locations = new_locations;
+}
 
-/* The top-level root node of the AST. */
-NProgram* g_program = NULL;
-
-/* Forward declarations. */
-extern int yylex(union YYSTYPE* yyval_param, struct YYLTYPE* yylloc_param);
-void yyerror(const char*);
+/* Forward declarations. The scanner is the flex scanner (yyscan_t) or a
+   FastLexer, depending on which yylex() is linked. */
+extern int yylex(union YYSTYPE* yyval_param, unsigned int* yylloc_param,
+                 void* scanner);
+void yyerror(unsigned int*, void*, ParseContext*, const char*);
+
+/* Creates a node for a token text, referring to the text if it is stable
+   and copying it into the arena otherwise. */
+template <class T>
+static T* makeTextNode(
+    const TokenText& text,
+    unsigned int offset,
+    NodeArena* arena)
+{
+    const char* data = text.data;
+    if (!text.stable) data = arena->copyText(text.data, text.length);
+    return new (arena) T(TextSpan(data, text.length), offset);
+}
 %}
 
 
@@ -49,19 +109,18 @@ void yyerror(const char*);
     NStatementList* statement_list;
     NStatement* statement;
     NExpression* expr;
-    NNumber* number;
     NVariable* variable;
-    char* token_string;
+    TokenText token_text;
 }
 
 /* Defines the terminal tokens, and their data type with respect to the union
    structure. The tokens must match those used in the scanner.l flex file.
  */
-%token <token_string> T_IDENTIFIER T_NUMBER
+%token <token_text> T_IDENTIFIER T_NUMBER
 %token T_PRINT T_EQUAL T_LPAREN T_RPAREN T_SEMICOLON T_PLUS T_MINUS T_MUL T_DIV
 
 /* For reporting errors */
-%token <token_string> T_UNKNOWN
+%token <token_text> T_UNKNOWN
 
 /* Defines the data type of the non-terminal tokens (again, with respect to the
    union structure)
@@ -73,7 +132,6 @@ void yyerror(const char*);
 %type <statement> print
 %type <expr> expr
 %type <variable> variable
-%type <number> number
 
 /* Sets the operator precedence (this also defines the tokens for the
    operators)
@@ -93,66 +151,86 @@ void yyerror(const char*);
 /* Rules */
 
 program : statement_list {
-    g_program = $$ = new NProgram($1, @$.first_line, @$.first_column);
+    $$ = new (context->getArena()) NProgram($1, @$);
+    context->setProgram($$);
  };
 
 statement_list:
 statement {
-    $$ = new NStatementList(@$.first_line, @$.first_column);
+    NodeArena* arena = context->getArena();
+    $$ = arena->track(new (arena) NStatementList(@$));
     (*$$) << $1;
+    context->addStatement($1);
 }
-| statement_list statement { (*$1) << $2; };
+| statement_list statement {
+    (*$1) << $2;
+    context->addStatement($2);
+};
 
 statement:
 assignment { $<statement>$ = $1; }
 | print { $<statement>$ = $1; };
 
 assignment : variable T_EQUAL expr T_SEMICOLON {
-    $$ = new NAssignment($1, $3, @$.first_line, @$.first_column);
+    $$ = new (context->getArena()) NAssignment($1, $3, @$);
+    context->getExpressionFactory()->assign($1->getName());
 };
 
 print : T_PRINT expr T_SEMICOLON {
-    $$ = new NPrint($2, @$.first_line, @$.first_column);
+    $$ = new (context->getArena()) NPrint($2, @$);
 };
 
+/* The variables which are read are created apart from those which are
+   assigned to, as only the former are expressions which may be shared */
 expr:
-variable { $<variable>$ = $1; }
-| number { $<number>$ = $1; }
+T_IDENTIFIER {
+    $$ = context->getExpressionFactory()->createVariable(
+        TextSpan($1.data, $1.length), @$, !$1.stable);
+}
+| T_NUMBER {
+    $$ = context->getExpressionFactory()->createNumber(
+        TextSpan($1.data, $1.length), @$, !$1.stable);
+}
 | expr T_PLUS expr {
-    $$ = new NExpressionBinary($1, PLUS, $3,
-                               @$.first_line, @$.first_column);
+    $$ = context->getExpressionFactory()->createBinary($1, PLUS, $3, @$);
 }
 | expr T_MINUS expr {
-    $$ = new NExpressionBinary($1, MINUS, $3,
-                               @$.first_line, @$.first_column);
+    $$ = context->getExpressionFactory()->createBinary($1, MINUS, $3, @$);
 }
 | expr T_MUL expr {
-    $$ = new NExpressionBinary($1, MUL, $3,
-                               @$.first_line, @$.first_column);
+    $$ = context->getExpressionFactory()->createBinary($1, MUL, $3, @$);
 }
 | expr T_DIV expr {
-    $$ = new NExpressionBinary($1, DIV, $3,
-                               @$.first_line, @$.first_column);
+    $$ = context->getExpressionFactory()->createBinary($1, DIV, $3, @$);
 }
 | T_MINUS expr %prec UNARY {
-    $$ = new NExpressionUnary(MINUS, $2,
-                              @$.first_line, @$.first_column);
+    $$ = context->getExpressionFactory()->createUnary(MINUS, $2, @$);
 }
 | T_LPAREN expr T_RPAREN { $$ = $2; };
 
-variable: T_IDENTIFIER { $$ = new NVariable($1, @$.first_line, @$.first_column); };
-
-number : T_NUMBER { $$ = new NNumber($1, @$.first_line, @$.first_column); };
+variable: T_IDENTIFIER {
+    $$ = makeTextNode<NVariable>($1, @$, context->getArena());
+};
 
 %%
 
 /**
- * Report error.
+ * Records an error in the parse context.
  *
+ * @param location
+ *        Source offset of the lookahead token.
+ * @param scanner
+ *        Scanner (unused).
+ * @param context
+ *        Parse context.
  * @param str
  *        Error message.
  */
-void yyerror(const char* str) {
-    Reporter& out = *Reporter::getInstance();
-    out << out.beginError() << str << out.endl();
+void yyerror(
+    YYLTYPE* location,
+    void* scanner,
+    ParseContext* context,
+    const char* str)
+{
+    context->addDiagnostic(*location, str);
 }
@@ -0,0 +1,76 @@
+#include "push_parser.hpp"
+#include "fast_lexer.hpp"
+#include "common.hpp" // Must be included before "parser.tab.h"
+#include "parser.tab.h"
+#include <climits>
+#include <cstring>
+
+PushParser::PushParser(ParseContext* context)
+        : _context(context), _state(yypstate_new()), _offset(0),
+          _failed(false)
+{}
+
+PushParser::~PushParser(void) {
+    yypstate_delete(_state);
+}
+
+bool PushParser::push(const char* data, size_t size) {
+    if (_failed) return false;
+    if (size > UINT_MAX - _offset - _pending.size()) {
+        _context->addDiagnostic(_offset, "source text is too large");
+        _failed = true;
+        return false;
+    }
+    _context->appendSource(data, size);
+
+    // Only the new piece can have a semicolon, as the pending text is always
+    // parsed up to the last one. Searching just the piece keeps a statement
+    // which arrives in many small pieces from being searched over and over
+    size_t searched = _pending.size();
+    _pending.append(data, size);
+    const char* semicolon =
+        static_cast<const char*>(memrchr(data, ';', size));
+    if (!semicolon) return true;
+    return parsePending(searched + (semicolon - data) + 1);
+}
+
+bool PushParser::finish(void) {
+    if (_failed) return false;
+    if (!parsePending(_pending.size())) return false;
+
+    YYLTYPE location = _offset;
+    int status = yypush_parse(_state, 0, NULL, &location, NULL, _context);
+    _failed = status != 0;
+    return !_failed;
+}
+
+bool PushParser::parsePending(size_t size) {
+    FastScanner scanner;
+    TokenBuffer tokens;
+    if (!scanner.scan(_pending.data(), size, &tokens)) {
+        _context->addDiagnostic(_offset, "statement is too large");
+        _failed = true;
+        return false;
+    }
+
+    // The text is copied by the parser when an identifier or number is
+    // reduced, which happens at the latest when the next token is pushed. As
+    // the prefix ends with a semicolon, that is always before it is removed
+    FastLexer lexer(&tokens, false);
+    lexer.setOrigin(_offset);
+    YYSTYPE value;
+    YYLTYPE location;
+    int token;
+    while ((token = yylex(&value, &location, &lexer)) != 0) {
+        int status = yypush_parse(_state, token, &value, &location, NULL,
+                                  _context);
+        if (status != YYPUSH_MORE) {
+            _failed = true;
+            return false;
+        }
+    }
+
+    _offset += size;
+    _pending.erase(0, size);
+    return true;
+}
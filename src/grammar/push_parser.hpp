@@ -0,0 +1,141 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CEE_GRAMMAR_PUSH_PARSER__H
+#define CEE_GRAMMAR_PUSH_PARSER__H
+
+/**
+ * @file
+ * @brief Defines a parser which is fed the source text piece by piece.
+ */
+
+#include "parse_context.hpp"
+#include <cstddef>
+#include <string>
+
+struct yypstate;
+
+/**
+ * \brief Parser which is fed the source text piece by piece.
+ *
+ * The PushParser class drives the bison parser in push mode, so the source
+ * text can be parsed while it is still arriving (e.g. from a socket) instead
+ * of the parser blocking until all of it has been read. Each piece is kept
+ * until a semicolon has been seen, as a token never continues past one. All
+ * text up to the last semicolon is then scanned with the FastScanner and its
+ * tokens are pushed to the parser, which passes every completed statement to
+ * ParseContext::addStatement(). Every piece is also added to the
+ * NewlineIndex of the context with ParseContext::appendSource(), so the
+ * source offsets of the nodes can still be turned into lines and columns.
+ *
+ * The pieces are not kept once they have been parsed, so the text of the
+ * identifier and number nodes is copied into the arena of the context.
+ */
+class PushParser {
+  public:
+    /**
+     * Creates a parser.
+     *
+     * @param context
+     *        Context receiving the AST, statements and syntax errors.
+     */
+    PushParser(ParseContext* context);
+
+    /**
+     * Destroys this parser.
+     */
+    ~PushParser(void);
+
+    /**
+     * Parses the next piece of the source text, which may end anywhere.
+     *
+     * @param data
+     *        Piece of the source text.
+     * @param size
+     *        Size of the piece (in bytes).
+     * @returns \c false if a syntax error has been found, or if the source
+     *          text has grown larger than the range of the offsets (4 GB),
+     *          after which the rest of the input is ignored.
+     */
+    bool push(const char* data, size_t size);
+
+    /**
+     * Parses what is left of the source text at its end. On success, the root
+     * of the AST is set in the context.
+     *
+     * @returns \c true if the input has no syntax error.
+     */
+    bool finish(void);
+
+  private:
+    /**
+     * Scans a prefix of the pending text and pushes its tokens to the parser.
+     * The prefix is then removed from the pending text.
+     *
+     * @param size
+     *        Size of the prefix (in bytes).
+     * @returns \c false if a syntax error has been found.
+     */
+    bool parsePending(size_t size);
+
+    /**
+     * Hidden copy constructor.
+     */
+    PushParser(const PushParser&);
+
+    /**
+     * Hidden assignment operator.
+     */
+    PushParser& operator=(const PushParser&);
+
+  private:
+    /**
+     * Context of the parse.
+     */
+    ParseContext* _context;
+
+    /**
+     * State of the bison parser.
+     */
+    yypstate* _state;
+
+    /**
+     * Text which has been received but not yet parsed.
+     */
+    std::string _pending;
+
+    /**
+     * Offset of the first character of the pending text.
+     */
+    unsigned int _offset;
+
+    /**
+     * Whether a syntax error has been found.
+     */
+    bool _failed;
+};
+
+#endif
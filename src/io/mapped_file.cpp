@@ -0,0 +1,76 @@
+#include "mapped_file.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using std::ios_base;
+using std::string;
+
+MappedFile::MappedFile(void) : _mapping(NULL), _size(0) {}
+
+MappedFile::~MappedFile(void) {
+    close();
+}
+
+void MappedFile::open(const string& file) throw (ios_base::failure) {
+    close();
+    int fd = ::open(file.c_str(), O_RDONLY);
+    if (fd < 0) throw ios_base::failure("Failed to open " + file);
+    try {
+        load(fd);
+    }
+    catch (ios_base::failure) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+}
+
+void MappedFile::openStandardInput(void) throw (ios_base::failure) {
+    close();
+    load(STDIN_FILENO);
+}
+
+void MappedFile::close(void) {
+    if (_mapping) munmap(_mapping, _size);
+    _mapping = NULL;
+    _size = 0;
+    _buffer.clear();
+}
+
+const char* MappedFile::getData(void) const {
+    if (_mapping) return static_cast<const char*>(_mapping);
+    return _buffer.empty() ? "" : &_buffer[0];
+}
+
+size_t MappedFile::getSize(void) const {
+    return _size;
+}
+
+void MappedFile::load(int fd) throw (ios_base::failure) {
+    // Regular files are mapped, unless some of the input has already been
+    // read
+    struct stat info;
+    off_t position = lseek(fd, 0, SEEK_CUR);
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && position == 0) {
+        _size = info.st_size;
+        if (_size == 0) return;
+        void* mapping = mmap(NULL, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            madvise(mapping, _size, MADV_SEQUENTIAL);
+            _mapping = mapping;
+            return;
+        }
+        _size = 0;
+    }
+
+    // Anything else is read until end of input
+    char buf[65536];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) != 0) {
+        if (n < 0) throw ios_base::failure("Failed to read input");
+        _buffer.insert(_buffer.end(), buf, buf + n);
+    }
+    _size = _buffer.size();
+}
@@ -0,0 +1,141 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CEE_MAPPED_FILE__H
+#define CEE_MAPPED_FILE__H
+
+/**
+ * @file
+ * @brief Defines the classes for mapping file input into memory.
+ */
+
+#include <cstddef>
+#include <ios>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Class for mapping file input into memory.
+ *
+ * The MappedFile class makes the entire content of a file available as one
+ * read-only buffer without copying it, using <code>mmap()</code>. Input which
+ * cannot be mapped (e.g. a pipe on the standard input) is read into a buffer
+ * instead. Either way the data stays valid until the file is closed, so
+ * tokens and AST nodes can refer directly into it.
+ */
+class MappedFile {
+  public:
+    /**
+     * Creates a mapped file with no content.
+     */
+    MappedFile(void);
+
+    /**
+     * Destroys this mapped file. If a file is open, it will be closed first.
+     */
+    ~MappedFile(void);
+
+    /**
+     * Opens and maps a specific file. If a file is already open, that file
+     * will be closed first.
+     *
+     * @param file
+     *        File path.
+     * @throws std::ios_base::failure
+     *         When the operation fails.
+     */
+    void open(const std::string& file) throw (std::ios_base::failure);
+
+    /**
+     * Maps the standard input. If a file is already open, that file will be
+     * closed first.
+     *
+     * @throws std::ios_base::failure
+     *         When the operation fails.
+     */
+    void openStandardInput(void) throw (std::ios_base::failure);
+
+    /**
+     * Unmaps the open file. If no file is open, this has no effect.
+     */
+    void close(void);
+
+    /**
+     * Gets the content of the file.
+     *
+     * @returns Pointer to the first byte.
+     */
+    const char* getData(void) const;
+
+    /**
+     * Gets the size of the file.
+     *
+     * @returns Size (in bytes).
+     */
+    size_t getSize(void) const;
+
+  private:
+    /**
+     * Maps or reads the content of a file descriptor.
+     *
+     * @param fd
+     *        File descriptor.
+     * @throws std::ios_base::failure
+     *         When the operation fails.
+     */
+    void load(int fd) throw (std::ios_base::failure);
+
+    /**
+     * Copies a mapped file. This is hidden as the mapping cannot be shared.
+     */
+    MappedFile(const MappedFile&);
+
+    /**
+     * Assigns a mapped file to another. This is hidden as the mapping cannot
+     * be shared.
+     *
+     * @returns This instance.
+     */
+    MappedFile& operator=(const MappedFile&);
+
+  private:
+    /**
+     * Start of the mapping, or \c NULL if the content is in _buffer.
+     */
+    void* _mapping;
+
+    /**
+     * Size of the content.
+     */
+    size_t _size;
+
+    /**
+     * Content which could not be mapped.
+     */
+    std::vector<char> _buffer;
+};
+
+#endif
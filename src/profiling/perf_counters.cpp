@@ -0,0 +1,144 @@
+#include "perf_counters.hpp"
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+/**
+ * Opens a single user-space counter for the calling thread.
+ *
+ * @param type
+ *        Event type (PERF_TYPE_*).
+ * @param config
+ *        Event configuration.
+ * @returns File descriptor, or -1 if the event could not be opened.
+ */
+static int openCounter(unsigned int type, unsigned long long config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED
+                     | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    long fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    return fd < 0 ? -1 : static_cast<int>(fd);
+}
+
+/**
+ * Builds the configuration of a hardware cache event.
+ *
+ * @param cache
+ *        Cache (PERF_COUNT_HW_CACHE_*).
+ * @param op
+ *        Operation (PERF_COUNT_HW_CACHE_OP_*).
+ * @param result
+ *        Result (PERF_COUNT_HW_CACHE_RESULT_*).
+ * @returns Event configuration.
+ */
+static unsigned long long cacheConfig(
+    unsigned int cache,
+    unsigned int op,
+    unsigned int result)
+{
+    return cache | (op << 8) | (result << 16);
+}
+#endif
+
+PerfCounters::PerfCounters(void) {
+    for (int i = 0; i < NUM_EVENTS; i++) _fds[i] = -1;
+    clear();
+
+#ifdef __linux__
+    _fds[CYCLES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    _fds[INSTRUCTIONS] =
+        openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    _fds[BRANCH_MISSES] =
+        openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    _fds[L1I_MISSES] =
+        openCounter(PERF_TYPE_HW_CACHE,
+                    cacheConfig(PERF_COUNT_HW_CACHE_L1I,
+                                PERF_COUNT_HW_CACHE_OP_READ,
+                                PERF_COUNT_HW_CACHE_RESULT_MISS));
+    _fds[DTLB_MISSES] =
+        openCounter(PERF_TYPE_HW_CACHE,
+                    cacheConfig(PERF_COUNT_HW_CACHE_DTLB,
+                                PERF_COUNT_HW_CACHE_OP_READ,
+                                PERF_COUNT_HW_CACHE_RESULT_MISS));
+#endif
+}
+
+PerfCounters::~PerfCounters(void) {
+#ifdef __linux__
+    for (int i = 0; i < NUM_EVENTS; i++) {
+        if (_fds[i] >= 0) close(_fds[i]);
+    }
+#endif
+}
+
+bool PerfCounters::isAvailable(Event event) const {
+    return _fds[event] >= 0;
+}
+
+bool PerfCounters::isAnyAvailable(void) const {
+    for (int i = 0; i < NUM_EVENTS; i++) {
+        if (_fds[i] >= 0) return true;
+    }
+    return false;
+}
+
+void PerfCounters::start(void) {
+#ifdef __linux__
+    for (int i = 0; i < NUM_EVENTS; i++) {
+        if (_fds[i] < 0) continue;
+        ioctl(_fds[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(_fds[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+void PerfCounters::stop(void) {
+#ifdef __linux__
+    for (int i = 0; i < NUM_EVENTS; i++) {
+        if (_fds[i] >= 0) ioctl(_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+    }
+
+    for (int i = 0; i < NUM_EVENTS; i++) {
+        if (_fds[i] < 0) continue;
+
+        // Layout given by the read format: value, time enabled, time running
+        unsigned long long data[3];
+        if (read(_fds[i], data, sizeof(data)) != sizeof(data)) continue;
+        if (data[2] == 0) continue;
+        double scale = static_cast<double>(data[1]) / data[2];
+        _values[i] += static_cast<long long>(data[0] * scale);
+    }
+#endif
+}
+
+void PerfCounters::clear(void) {
+    for (int i = 0; i < NUM_EVENTS; i++) _values[i] = 0;
+}
+
+long long PerfCounters::getValue(Event event) const {
+    return isAvailable(event) ? _values[event] : -1;
+}
+
+const char* PerfCounters::getEventName(Event event) {
+    switch (event) {
+        case CYCLES:        return "cycles";
+        case INSTRUCTIONS:  return "instructions";
+        case BRANCH_MISSES: return "branch-misses";
+        case L1I_MISSES:    return "L1-icache-load-misses";
+        case DTLB_MISSES:   return "dTLB-load-misses";
+        default:            return "unknown";
+    }
+}
@@ -0,0 +1,178 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CEE_PROFILING_PERF_COUNTERS__H
+#define CEE_PROFILING_PERF_COUNTERS__H
+
+/**
+ * @file
+ * @brief Defines the classes for reading hardware performance counters.
+ */
+
+/**
+ * \brief Hardware performance counters.
+ *
+ * The PerfCounters class reads a fixed set of hardware events through the
+ * Linux <code>perf_event_open</code> system call. Counting covers user space
+ * only and is restricted to the regions enclosed by start() and stop(), so a
+ * benchmark can measure e.g. VM dispatch separately from program loading.
+ *
+ * Each event is opened on its own. An event which is not supported by the CPU,
+ * the kernel or the sandbox (see <code>/proc/sys/kernel/perf_event_paranoid
+ * </code>) is simply marked as unavailable, and on other systems than Linux
+ * no event is ever available. Callers are expected to check isAvailable()
+ * before using a value, and to fall back to wall time when nothing could be
+ * opened.
+ */
+class PerfCounters {
+  public:
+    /**
+     * Defines the events that are counted.
+     */
+    enum Event {
+        /**
+         * CPU cycles.
+         */
+        CYCLES,
+
+        /**
+         * Retired (native) instructions.
+         */
+        INSTRUCTIONS,
+
+        /**
+         * Mispredicted branches.
+         */
+        BRANCH_MISSES,
+
+        /**
+         * Level 1 instruction cache read misses.
+         */
+        L1I_MISSES,
+
+        /**
+         * Data TLB read misses.
+         */
+        DTLB_MISSES,
+
+        /**
+         * Number of events (not an event).
+         */
+        NUM_EVENTS
+    };
+
+  public:
+    /**
+     * Creates a set of counters and opens all events that are available. The
+     * counters are disabled until start() is invoked.
+     */
+    PerfCounters(void);
+
+    /**
+     * Closes all counters.
+     */
+    ~PerfCounters(void);
+
+    /**
+     * Checks whether an event could be opened.
+     *
+     * @param event
+     *        Event.
+     * @returns \c true if the event is counted.
+     */
+    bool isAvailable(Event event) const;
+
+    /**
+     * Checks whether at least one event could be opened.
+     *
+     * @returns \c true if any event is counted.
+     */
+    bool isAnyAvailable(void) const;
+
+    /**
+     * Resets and enables all available counters.
+     */
+    void start(void);
+
+    /**
+     * Disables all available counters and adds their values to the
+     * accumulated totals.
+     */
+    void stop(void);
+
+    /**
+     * Clears the accumulated totals.
+     */
+    void clear(void);
+
+    /**
+     * Gets the accumulated value of an event over all start()/stop() regions
+     * since construction or the last clear(). If the kernel had to multiplex
+     * the counters, the value is scaled by the time the event was enabled
+     * versus the time it was actually running.
+     *
+     * @param event
+     *        Event.
+     * @returns Event count, or -1 if the event is not available.
+     */
+    long long getValue(Event event) const;
+
+    /**
+     * Gets the printable name of an event, using the same names as the
+     * <code>perf</code> tool.
+     *
+     * @param event
+     *        Event.
+     * @returns Event name.
+     */
+    static const char* getEventName(Event event);
+
+  private:
+    /**
+     * Copying is not allowed as the instance owns file descriptors.
+     */
+    PerfCounters(const PerfCounters&);
+
+    /**
+     * Assignment is not allowed as the instance owns file descriptors.
+     *
+     * @returns This instance.
+     */
+    PerfCounters& operator=(const PerfCounters&);
+
+  private:
+    /**
+     * File descriptor per event, or -1 if the event is not available.
+     */
+    int _fds[NUM_EVENTS];
+
+    /**
+     * Accumulated value per event.
+     */
+    long long _values[NUM_EVENTS];
+};
+
+#endif
@@ -0,0 +1,230 @@
+#include "concurrent_symbol_table.hpp"
+#include <cstddef>
+#include <new>
+
+using std::string;
+
+ConcurrentSymbolTable::ConcurrentSymbolTable(void)
+  : shards(new Shard[NUM_SHARDS]),
+    segments(NUM_SEGMENTS, static_cast<Record*>(NULL)),
+    num_records(0)
+{
+  for (unsigned int i = 0; i < NUM_SHARDS; i++) {
+    pthread_mutex_init(&shards[i].lock, NULL);
+    shards[i].table = NULL;
+    shards[i].count = 0;
+  }
+}
+
+ConcurrentSymbolTable::~ConcurrentSymbolTable(void) {
+  clear();
+  for (unsigned int i = 0; i < NUM_SHARDS; i++) {
+    pthread_mutex_destroy(&shards[i].lock);
+  }
+  delete[] shards;
+}
+
+ConcurrentSymbolTable::Record* ConcurrentSymbolTable::lookUp(
+  const TextSpan& name) const
+{
+  int symbol = getSymbol(name);
+  return symbol < 0 ? NULL : getRecord(symbol);
+}
+
+ConcurrentSymbolTable::Record* ConcurrentSymbolTable::lookUp(
+  const string& name) const
+{
+  return lookUp(TextSpan(name));
+}
+
+int ConcurrentSymbolTable::getSymbol(const TextSpan& name) const {
+  uint32_t hash = static_cast<uint32_t>(name.hash());
+  const Shard& shard = shards[hash >> (32 - SHARD_BITS)];
+  return find(__atomic_load_n(&shard.table, __ATOMIC_ACQUIRE), name, hash);
+}
+
+bool ConcurrentSymbolTable::insert(const TextSpan& name, unsigned int offset)
+{
+  bool inserted;
+  add(name, offset, &inserted);
+  return inserted;
+}
+
+bool ConcurrentSymbolTable::insert(const string& name, unsigned int offset) {
+  return insert(TextSpan(name), offset);
+}
+
+int ConcurrentSymbolTable::intern(const TextSpan& name, unsigned int offset) {
+  bool inserted;
+  return add(name, offset, &inserted);
+}
+
+size_t ConcurrentSymbolTable::getNumRecords(void) const {
+  return __atomic_load_n(&num_records, __ATOMIC_ACQUIRE);
+}
+
+ConcurrentSymbolTable::Record* ConcurrentSymbolTable::getRecord(size_t i)
+  const
+{
+  size_t index;
+  unsigned int segment = locate(i, &index);
+  return __atomic_load_n(&segments[segment], __ATOMIC_ACQUIRE) + index;
+}
+
+void ConcurrentSymbolTable::clear(void) {
+  for (size_t i = 0; i < num_records; i++) {
+    getRecord(i)->~Record();
+  }
+  for (unsigned int i = 0; i < NUM_SEGMENTS; i++) {
+    operator delete(segments[i]);
+    segments[i] = NULL;
+  }
+  num_records = 0;
+
+  for (unsigned int i = 0; i < NUM_SHARDS; i++) {
+    Shard& shard = shards[i];
+    delete shard.table;
+    shard.table = NULL;
+    for (size_t j = 0; j < shard.retired.size(); j++) {
+      delete shard.retired[j];
+    }
+    shard.retired.clear();
+    shard.count = 0;
+    shard.names.release();
+  }
+}
+
+size_t ConcurrentSymbolTable::findSlot(
+  const Table* table,
+  const TextSpan& name,
+  uint32_t hash,
+  uint64_t* value) const
+{
+  for (size_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+    uint64_t slot = __atomic_load_n(&table->slots[i], __ATOMIC_ACQUIRE);
+    uint32_t record = static_cast<uint32_t>(slot);
+    if (record == 0
+        || (static_cast<uint32_t>(slot >> 32) == hash
+            && getRecord(record - 1)->getName() == name))
+    {
+      *value = slot;
+      return i;
+    }
+  }
+}
+
+int ConcurrentSymbolTable::find(
+  const Table* table,
+  const TextSpan& name,
+  uint32_t hash) const
+{
+  if (!table) return -1;
+
+  // The slot is not read again, as a free slot may meanwhile be taken by
+  // another name
+  uint64_t slot;
+  findSlot(table, name, hash, &slot);
+  return static_cast<int>(static_cast<uint32_t>(slot)) - 1;
+}
+
+int ConcurrentSymbolTable::add(
+  const TextSpan& name,
+  unsigned int offset,
+  bool* inserted)
+{
+  uint32_t hash = static_cast<uint32_t>(name.hash());
+  Shard& shard = shards[hash >> (32 - SHARD_BITS)];
+  *inserted = false;
+
+  // Most names are already known, which is found out without the lock
+  int symbol =
+    find(__atomic_load_n(&shard.table, __ATOMIC_ACQUIRE), name, hash);
+  if (symbol >= 0) return symbol;
+
+  pthread_mutex_lock(&shard.lock);
+
+  // Another thread may have inserted the name in the meantime
+  symbol = find(shard.table, name, hash);
+  if (symbol < 0) {
+    if (!shard.table || 2 * (shard.count + 1) > shard.table->mask + 1) {
+      grow(&shard);
+    }
+    uint64_t slot;
+    size_t i = findSlot(shard.table, name, hash, &slot);
+
+    // The record is complete before the slot which refers to it is published
+    size_t id = __sync_fetch_and_add(&num_records, 1);
+    TextSpan copy(shard.names.copyText(name.data(), name.length()),
+                  name.length());
+    new (allocateRecord(id)) Record(copy, offset, static_cast<int>(id));
+    __atomic_store_n(&shard.table->slots[i],
+                     (static_cast<uint64_t>(hash) << 32) | (id + 1),
+                     __ATOMIC_RELEASE);
+    shard.count++;
+    symbol = static_cast<int>(id);
+    *inserted = true;
+  }
+
+  pthread_mutex_unlock(&shard.lock);
+  return symbol;
+}
+
+void ConcurrentSymbolTable::grow(Shard* shard) {
+  Table* old_table = shard->table;
+  Table* table = new Table;
+  size_t size = old_table ? 2 * (old_table->mask + 1) : 16;
+  table->mask = size - 1;
+  table->slots.resize(size, 0);
+  if (old_table) {
+    for (size_t i = 0; i <= old_table->mask; i++) {
+      uint64_t slot = old_table->slots[i];
+      if (static_cast<uint32_t>(slot) == 0) continue;
+      size_t j = static_cast<uint32_t>(slot >> 32) & table->mask;
+      while (table->slots[j] != 0) j = (j + 1) & table->mask;
+      table->slots[j] = slot;
+    }
+
+    // Threads looking up a name may still be reading the old table
+    shard->retired.push_back(old_table);
+  }
+  __atomic_store_n(&shard->table, table, __ATOMIC_RELEASE);
+}
+
+ConcurrentSymbolTable::Record* ConcurrentSymbolTable::allocateRecord(size_t i)
+{
+  size_t index;
+  unsigned int segment = locate(i, &index);
+  Record* records = __atomic_load_n(&segments[segment], __ATOMIC_ACQUIRE);
+  if (!records) {
+    // Threads of different shards may need the segment at the same time, of
+    // which only one gets to install its allocation
+    size_t size = SEGMENT_SIZE << segment;
+    Record* fresh = static_cast<Record*>(operator new(size * sizeof(Record)));
+    if (__sync_bool_compare_and_swap(&segments[segment],
+                                     static_cast<Record*>(NULL), fresh))
+    {
+      records = fresh;
+    }
+    else {
+      operator delete(fresh);
+      records = __atomic_load_n(&segments[segment], __ATOMIC_ACQUIRE);
+    }
+  }
+  return records + index;
+}
+
+unsigned int ConcurrentSymbolTable::locate(size_t i, size_t* index) {
+  // Segment s holds the records from SEGMENT_SIZE * (2^s - 1) onwards
+  unsigned long long block = i / SEGMENT_SIZE + 1;
+  unsigned int segment = 8 * sizeof(block) - 1 - __builtin_clzll(block);
+  *index = i - SEGMENT_SIZE * ((static_cast<size_t>(1) << segment) - 1);
+  return segment;
+}
+
+const unsigned int ConcurrentSymbolTable::SHARD_BITS = 8;
+
+const unsigned int ConcurrentSymbolTable::NUM_SHARDS = 1 << SHARD_BITS;
+
+const size_t ConcurrentSymbolTable::SEGMENT_SIZE = 1024;
+
+const unsigned int ConcurrentSymbolTable::NUM_SEGMENTS = 22;
@@ -0,0 +1,342 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CEE_SYMTAB_CONCURRENT_SYMBOL_TABLE__H
+#define CEE_SYMTAB_CONCURRENT_SYMBOL_TABLE__H
+
+/**
+ * @file
+ * @brief Defines a symbol table which may be shared between threads.
+ */
+
+#include "../ast/node_arena.hpp"
+#include "../ast/text_span.hpp"
+#include "symbol_table.hpp"
+#include <pthread.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Symbol table which may be shared between threads.
+ *
+ * The ConcurrentSymbolTable has the insert() and lookUp() contract of the
+ * SymbolTable, with the same records and dense symbol ids, but any number of
+ * threads may insert and look up names at the same time. Threads which
+ * compile different sources, or different chunks of one source, can thus
+ * share one table of identifiers, so that every thread sees the same symbol
+ * id and memory index for a name.
+ *
+ * The names are spread by their hash over a number of shards, each of which
+ * is an open-addressing hash table like that of the SymbolTable, with its own
+ * lock and its own arena for the names. Only inserting a new name takes the
+ * lock of its shard; looking up a name takes no lock at all, as the slots of a
+ * shard are published atomically and a table which has been outgrown is kept
+ * until the symbol table is cleared. The records lie in segments which never
+ * move, so a record stays where it is while other threads insert.
+ */
+class ConcurrentSymbolTable {
+public:
+  /**
+   * Record of an identifier, which is that of the SymbolTable.
+   */
+  typedef SymbolTable::Record Record;
+
+public:
+  /**
+   * Creates a symbol table.
+   */
+  ConcurrentSymbolTable(void);
+
+  /**
+   * Destroys this symbol table, and all records that it contains.
+   */
+  ~ConcurrentSymbolTable(void);
+
+  /**
+   * Gets the record with a given identifier name. If no such record is found,
+   * \c NULL is returned. This may be called while other threads insert, and
+   * takes no lock.
+   *
+   * @param name
+   *        Identifier name.
+   * @returns Record with matching name, valid until the table is cleared.
+   */
+  Record* lookUp(const TextSpan& name) const;
+
+  /**
+   * \copydoc lookUp(const TextSpan&) const
+   */
+  Record* lookUp(const std::string& name) const;
+
+  /**
+   * Gets the symbol id of the identifier with a given name. This may be called
+   * while other threads insert, and takes no lock.
+   *
+   * @param name
+   *        Identifier name.
+   * @returns Symbol id, or -1 if no record has the name.
+   */
+  int getSymbol(const TextSpan& name) const;
+
+  /**
+   * Adds an identifier with a given name to this symbol table. If an
+   * identifier with an identical name has already been inserted, no change is
+   * made and false is returned. Its memory index is its symbol id, and the
+   * ids are handed out in the order in which the names are inserted, which
+   * is not predictable when several threads insert.
+   *
+   * @param name
+   *        Identifier name, which is copied.
+   * @param offset
+   *        Source offset where the identifer was declared.
+   * @returns \c true if the identifier was inserted.
+   */
+  bool insert(const TextSpan& name, unsigned int offset);
+
+  /**
+   * \copydoc insert(const TextSpan&, unsigned int)
+   */
+  bool insert(const std::string& name, unsigned int offset);
+
+  /**
+   * Gets the symbol id of an identifier, inserting it first if it is not in
+   * the symbol table. This is insert() and getSymbol() in one step, which no
+   * other thread can come between.
+   *
+   * @param name
+   *        Identifier name, which is copied if it is inserted.
+   * @param offset
+   *        Source offset where the identifer was declared, which is only used
+   *        if it is inserted.
+   * @returns Symbol id.
+   */
+  int intern(const TextSpan& name, unsigned int offset);
+
+  /**
+   * Gets the number of records in the symbol table. While other threads
+   * insert, some of the records may not be complete yet.
+   *
+   * @returns Number of records.
+   */
+  size_t getNumRecords(void) const;
+
+  /**
+   * Gets a record of the symbol table. A record whose symbol id was returned
+   * to this thread, or which was found by it, may be fetched at any time;
+   * other records only once no thread inserts.
+   *
+   * @param i
+   *        Record index, less than getNumRecords().
+   * @returns Record, valid until the table is cleared.
+   */
+  Record* getRecord(size_t i) const;
+
+  /**
+   * Clears the entire symbol table and destroys all records. No other thread
+   * may use the table meanwhile.
+   */
+  void clear(void);
+
+public:
+  /**
+   * Number of bits of the hash of a name which select its shard.
+   */
+  static const unsigned int SHARD_BITS;
+
+  /**
+   * Number of shards.
+   */
+  static const unsigned int NUM_SHARDS;
+
+  /**
+   * Number of records of the first segment. Every further segment is twice
+   * as large as the one before.
+   */
+  static const size_t SEGMENT_SIZE;
+
+  /**
+   * Number of segments, which covers every symbol id that fits in an
+   * <code>int</code>.
+   */
+  static const unsigned int NUM_SEGMENTS;
+
+private:
+  /**
+   * \brief Hash table of a shard.
+   *
+   * Each slot holds the (truncated) hash of a name in its upper 32 bits and
+   * the symbol id plus one in its lower 32 bits, or 0 if it is free. A slot is
+   * read and written as a whole, atomically.
+   */
+  struct Table {
+    /**
+     * Number of slots minus one, where the number of slots is a power of 2.
+     */
+    size_t mask;
+
+    /**
+     * Slots.
+     */
+    std::vector<uint64_t> slots;
+  };
+
+  /**
+   * \brief Part of the symbol table with the names of some hashes.
+   */
+  struct Shard {
+    /**
+     * Lock which is held while a name is inserted.
+     */
+    pthread_mutex_t lock;
+
+    /**
+     * Current hash table, or \c NULL. It is replaced atomically when it
+     * grows, and is kept at most half full.
+     */
+    Table* table;
+
+    /**
+     * Hash tables which have been outgrown, but may still be read by threads
+     * looking up a name.
+     */
+    std::vector<Table*> retired;
+
+    /**
+     * Number of names in the shard.
+     */
+    size_t count;
+
+    /**
+     * Arena in which the names are kept.
+     */
+    AST::NodeArena names;
+  };
+
+private:
+  /**
+   * Finds the slot of a name in a hash table, which is either the slot of its
+   * record or the free slot where its record belongs.
+   *
+   * @param table
+   *        Hash table.
+   * @param name
+   *        Identifier name.
+   * @param hash
+   *        Hash of the name.
+   * @param value
+   *        Destination of the content of the slot, as it was when it was
+   *        found.
+   * @returns Slot index.
+   */
+  size_t findSlot(const Table* table,
+                  const TextSpan& name,
+                  uint32_t hash,
+                  uint64_t* value) const;
+
+  /**
+   * Finds the symbol id of a name in a hash table.
+   *
+   * @param table
+   *        Hash table, or \c NULL.
+   * @param name
+   *        Identifier name.
+   * @param hash
+   *        Hash of the name.
+   * @returns Symbol id, or -1 if no record has the name.
+   */
+  int find(const Table* table, const TextSpan& name, uint32_t hash) const;
+
+  /**
+   * Inserts a name unless it is already in the symbol table.
+   *
+   * @param name
+   *        Identifier name.
+   * @param offset
+   *        Source offset where the identifer was declared.
+   * @param inserted
+   *        Set to whether the name was inserted.
+   * @returns Symbol id.
+   */
+  int add(const TextSpan& name, unsigned int offset, bool* inserted);
+
+  /**
+   * Doubles the number of slots of a shard, and publishes the new hash table.
+   * The lock of the shard must be held.
+   *
+   * @param shard
+   *        Shard.
+   */
+  void grow(Shard* shard);
+
+  /**
+   * Gets the memory of a record, allocating its segment if needed.
+   *
+   * @param i
+   *        Record index.
+   * @returns Memory of the record.
+   */
+  Record* allocateRecord(size_t i);
+
+  /**
+   * Gets the segment of a record and the index of the record within it.
+   *
+   * @param i
+   *        Record index.
+   * @param index
+   *        Destination of the index within the segment.
+   * @returns Segment index.
+   */
+  static unsigned int locate(size_t i, size_t* index);
+
+  /**
+   * Hidden copy constructor.
+   */
+  ConcurrentSymbolTable(const ConcurrentSymbolTable&);
+
+  /**
+   * Hidden assignment operator.
+   */
+  ConcurrentSymbolTable& operator=(const ConcurrentSymbolTable&);
+
+private:
+  /**
+   * Shards.
+   */
+  Shard* shards;
+
+  /**
+   * Segments of records, each of which is \c NULL until it is needed.
+   */
+  std::vector<Record*> segments;
+
+  /**
+   * Number of symbol ids handed out.
+   */
+  size_t num_records;
+};
+
+#endif
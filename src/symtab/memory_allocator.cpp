@@ -0,0 +1,158 @@
+#include "memory_allocator.hpp"
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+
+using namespace AST;
+
+int MemoryAllocator::allocate(NProgram* node, SymbolTable* symtab) {
+  begin(symtab);
+  traverse(node);
+  return assign();
+}
+
+int MemoryAllocator::allocate(const FlatAst& ast, SymbolTable* symtab) {
+  begin(symtab);
+
+  // The nodes are in post-order, so every use in the expression of an
+  // assignment comes before the variable is declared
+  for (unsigned int i = 0; i < ast.getNumNodes(); i++) {
+    switch (ast.getKind(i)) {
+      case FlatAst::VARIABLE:
+        use(resolve(ast.getSymbol(i), ast.getText(i)));
+        break;
+
+      case FlatAst::ASSIGNMENT:
+        declare(resolve(ast.getSymbol(i), ast.getText(i)));
+        endStatement();
+        break;
+
+      case FlatAst::PRINT:
+        endStatement();
+        break;
+
+      default:
+        break;
+    }
+  }
+  return assign();
+}
+
+void MemoryAllocator::preVisit(NAssignment* node) throw(NodeError) {
+  right_side_mode = false;
+}
+
+void MemoryAllocator::betweenChildren(NAssignment* node) throw(NodeError) {
+  right_side_mode = true;
+}
+
+void MemoryAllocator::postVisit(NAssignment* node) throw(NodeError) {
+  NVariable* variable = node->getVariable();
+  declare(resolve(variable->getSymbol(), variable->getName()));
+  endStatement();
+}
+
+void MemoryAllocator::postVisit(NPrint* node) throw(NodeError) {
+  endStatement();
+}
+
+void MemoryAllocator::visit(NVariable* node) throw(NodeError) {
+  if (!right_side_mode) return;
+  use(resolve(node->getSymbol(), node->getName()));
+}
+
+void MemoryAllocator::begin(SymbolTable* symtab) {
+  symbol_table = symtab;
+  first_statement.assign(symtab->getNumRecords(), 0);
+  last_statement.assign(symtab->getNumRecords(), 0);
+  num_accesses.assign(symtab->getNumRecords(), 0);
+  statement = 0;
+  right_side_mode = true;
+}
+
+void MemoryAllocator::declare(int symbol) {
+  if (symbol < 0) return;
+  while (static_cast<size_t>(symbol) >= first_statement.size()) {
+    // The symbol table has grown since begin()
+    first_statement.push_back(0);
+    last_statement.push_back(0);
+    num_accesses.push_back(0);
+  }
+  first_statement[symbol] = statement;
+  last_statement[symbol] = statement;
+  num_accesses[symbol]++;
+}
+
+void MemoryAllocator::use(int symbol) {
+  if (symbol < 0) return;
+  last_statement[symbol] = statement;
+  num_accesses[symbol]++;
+}
+
+void MemoryAllocator::endStatement(void) {
+  statement++;
+}
+
+int MemoryAllocator::assign(void) {
+  typedef std::pair<unsigned int, int> LiveRangeEnd;
+  std::priority_queue<int, std::vector<int>, std::greater<int> > free;
+  std::priority_queue<LiveRangeEnd, std::vector<LiveRangeEnd>,
+                      std::greater<LiveRangeEnd> > live;
+  int num_locations = 0;
+
+  // The records come in declaration order, i.e. in the order in which the
+  // live ranges start
+  for (size_t i = 0; i < symbol_table->getNumRecords(); i++) {
+    // A location is free once its variable has been read for the last time,
+    // which may be in the very statement that declares this variable
+    while (!live.empty() && live.top().first <= first_statement[i]) {
+      free.push(live.top().second);
+      live.pop();
+    }
+
+    int location;
+    if (free.empty()) {
+      location = num_locations++;
+    }
+    else {
+      location = free.top();
+      free.pop();
+    }
+    symbol_table->getRecord(i)->setMemoryIndex(location);
+    live.push(std::make_pair(last_statement[i], location));
+  }
+  order(num_locations);
+  return num_locations;
+}
+
+int MemoryAllocator::resolve(int symbol, const TextSpan& name) const {
+  return symbol < 0 ? symbol_table->getSymbol(name) : symbol;
+}
+
+void MemoryAllocator::order(int num_locations) {
+  typedef std::pair<unsigned long long, int> Location;
+  std::vector<Location> locations(num_locations);
+  for (int i = 0; i < num_locations; i++) {
+    locations[i] = std::make_pair(0ULL, i);
+  }
+  for (size_t i = 0; i < symbol_table->getNumRecords(); i++) {
+    locations[symbol_table->getRecord(i)->getMemoryIndex()].first +=
+      num_accesses[i];
+  }
+
+  // The accesses are complemented, so that the most accessed come first and
+  // ties are broken by location
+  for (int i = 0; i < num_locations; i++) {
+    locations[i].first = ~locations[i].first;
+  }
+  std::sort(locations.begin(), locations.end());
+  std::vector<int> new_index(num_locations);
+  for (int i = 0; i < num_locations; i++) {
+    new_index[locations[i].second] = i;
+  }
+  for (size_t i = 0; i < symbol_table->getNumRecords(); i++) {
+    SymbolTable::Record* record = symbol_table->getRecord(i);
+    record->setMemoryIndex(new_index[record->getMemoryIndex()]);
+  }
+}
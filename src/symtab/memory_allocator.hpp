@@ -0,0 +1,250 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CEE_SYMTAB_MEMORY_ALLOCATOR__H
+#define CEE_SYMTAB_MEMORY_ALLOCATOR__H
+
+/**
+ * @file
+ * @brief Defines the classes and functions for sharing memory locations
+ *        between variables.
+ */
+
+#include "../ast/ast.hpp"
+#include "../ast/flat_ast.hpp"
+#include "../ast/static_visitor.hpp"
+#include "symbol_table.hpp"
+#include <vector>
+
+/**
+ * \brief Assigns memory locations to variables by their live ranges.
+ *
+ * The SymbolTable gives every variable a memory location of its own, so the
+ * memory of a program grows with its number of variables. The MemoryAllocator
+ * instead computes the live range of every variable, from the statement which
+ * declares it to the last statement which reads it, and lets variables whose
+ * live ranges do not overlap share a location. In the statement in which a
+ * variable is last read, its location may already be taken by the variable
+ * which the statement declares, as the expression is evaluated before the
+ * value is stored.
+ *
+ * As a variable is declared once and the program has no jumps, every live
+ * range is a single interval of statements, and the interference graph of the
+ * variables is an interval graph. Such a graph is colored with the fewest
+ * colors by visiting the variables in the order in which their live ranges
+ * start, and giving each the lowest location which is free at that point.
+ * This is done in one scan over the records, which come in declaration order.
+ *
+ * The locations are then numbered by how often the code accesses them, the
+ * most accessed first. Every load and store pushes the memory index with the
+ * shortest CONST instruction which holds it, and indices 0 and 1 take one byte
+ * and indices up to 127 two, so the variables which are accessed most get the
+ * shortest code. They also end up next to each other in memory.
+ *
+ * The symbol table must have been built from the program, and the variables
+ * of the program resolved to their symbol ids. Alternatively, the pass which
+ * builds the symbol table adds the accesses one at a time as it resolves them
+ * (see begin()), and the locations are assigned once it is done.
+ */
+class MemoryAllocator : public AST::StaticVisitor<MemoryAllocator> {
+public:
+  using AST::StaticVisitor<MemoryAllocator>::preVisit;
+  using AST::StaticVisitor<MemoryAllocator>::betweenChildren;
+  using AST::StaticVisitor<MemoryAllocator>::postVisit;
+  using AST::StaticVisitor<MemoryAllocator>::visit;
+
+  /**
+   * Assigns memory locations to the variables of a program, which are set as
+   * the memory indices of their records.
+   *
+   * @param node
+   *        Program node.
+   * @param symtab
+   *        Symbol table of the program.
+   * @returns Number of memory locations.
+   */
+  int allocate(AST::NProgram* node, SymbolTable* symtab);
+
+  /**
+   * Assigns memory locations to the variables of the flat representation of
+   * a program, in one linear pass over its nodes. Otherwise the same as
+   * allocate(AST::NProgram*, SymbolTable*).
+   *
+   * @param ast
+   *        Flat AST.
+   * @param symtab
+   *        Symbol table of the program.
+   * @returns Number of memory locations.
+   */
+  int allocate(const AST::FlatAst& ast, SymbolTable* symtab);
+
+  /**
+   * Sets the mode to "L" mode.
+   *
+   * @param node
+   *        Assignment node.
+   * @throws NodeError
+   *         Will not be thrown.
+   */
+  void preVisit(AST::NAssignment* node) throw(AST::NodeError);
+
+  /**
+   * Sets the mode back to "R" mode.
+   *
+   * @param node
+   *        Assignment node.
+   * @throws NodeError
+   *         Will not be thrown.
+   */
+  void betweenChildren(AST::NAssignment* node) throw(AST::NodeError);
+
+  /**
+   * Starts the live range of the variable on the left-hand side, and moves
+   * on to the next statement.
+   *
+   * @param node
+   *        Assignment node.
+   * @throws NodeError
+   *         Will not be thrown.
+   */
+  void postVisit(AST::NAssignment* node) throw(AST::NodeError);
+
+  /**
+   * Moves on to the next statement.
+   *
+   * @param node
+   *        Print node.
+   * @throws NodeError
+   *         Will not be thrown.
+   */
+  void postVisit(AST::NPrint* node) throw(AST::NodeError);
+
+  /**
+   * Extends the live range of a variable which is read up to the current
+   * statement.
+   *
+   * @param node
+   *        Variable node.
+   * @throws NodeError
+   *         Will not be thrown.
+   */
+  void visit(AST::NVariable* node) throw(AST::NodeError);
+
+  /**
+   * Starts computing live ranges one variable access at a time, for when the
+   * program is traversed by another pass, such as the CodeGenerator while it
+   * builds the symbol table itself. The symbol table may still grow while
+   * the accesses are added.
+   *
+   * @param symtab
+   *        Symbol table.
+   */
+  void begin(SymbolTable* symtab);
+
+  /**
+   * Starts the live range of a variable in the current statement.
+   *
+   * @param symbol
+   *        Symbol id, or -1 if the variable has not been resolved.
+   */
+  void declare(int symbol);
+
+  /**
+   * Extends the live range of a variable up to the current statement.
+   *
+   * @param symbol
+   *        Symbol id, or -1 if the variable has not been resolved.
+   */
+  void use(int symbol);
+
+  /**
+   * Moves on to the next statement.
+   */
+  void endStatement(void);
+
+  /**
+   * Assigns the memory locations from the live ranges, and sets them as the
+   * memory indices of the records.
+   *
+   * @returns Number of memory locations.
+   */
+  int assign(void);
+
+private:
+  /**
+   * Finds the symbol id of a variable which may not have been resolved.
+   *
+   * @param symbol
+   *        Symbol id, or -1 if the variable has not been resolved.
+   * @param name
+   *        Variable name.
+   * @returns Symbol id, or -1 if the variable is not in the symbol table.
+   */
+  int resolve(int symbol, const TextSpan& name) const;
+
+  /**
+   * Numbers the memory locations by their number of accesses, the most
+   * accessed first. Locations with equal numbers of accesses keep their
+   * order.
+   *
+   * @param num_locations
+   *        Number of memory locations.
+   */
+  void order(int num_locations);
+
+  /**
+   * Symbol table of the program.
+   */
+  SymbolTable* symbol_table;
+
+  /**
+   * Statement which declares each variable, by symbol id.
+   */
+  std::vector<unsigned int> first_statement;
+
+  /**
+   * Last statement which reads each variable, or which declares it if it is
+   * never read, by symbol id.
+   */
+  std::vector<unsigned int> last_statement;
+
+  /**
+   * Number of loads and stores of each variable, by symbol id.
+   */
+  std::vector<unsigned int> num_accesses;
+
+  /**
+   * Index of the current statement.
+   */
+  unsigned int statement;
+
+  /**
+   * Flag for controlling "L" and "R" mode in assignment nodes.
+   */
+  bool right_side_mode;
+};
+
+#endif
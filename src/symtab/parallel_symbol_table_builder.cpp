@@ -0,0 +1,170 @@
+#include "parallel_symbol_table_builder.hpp"
+#include "symbol_table_builder.hpp"
+#include "../io/reporter.hpp"
+#include <pthread.h>
+#include <unistd.h>
+
+using namespace AST;
+
+ParallelSymbolTableBuilder::ParallelSymbolTableBuilder(
+  unsigned int num_threads)
+  : num_threads(num_threads),
+    statements(NULL),
+    next_part(0)
+{
+  if (this->num_threads == 0) {
+    long num_processors = sysconf(_SC_NPROCESSORS_ONLN);
+    this->num_threads = num_processors > 0 ? num_processors : 1;
+  }
+}
+
+bool ParallelSymbolTableBuilder::build(NProgram* node,
+                                       SymbolTable* symtab,
+                                       const NewlineIndex* newlines) {
+  shared.clear();
+  statements = &node->getStatementList()->getStatements();
+  size_t num_statements = statements->size();
+  parts.assign((num_statements + STATEMENTS_PER_PART - 1)
+               / STATEMENTS_PER_PART, Part());
+  for (size_t i = 0; i < parts.size(); i++) {
+    parts[i].begin = i * STATEMENTS_PER_PART;
+    parts[i].end = std::min(parts[i].begin + STATEMENTS_PER_PART,
+                            num_statements);
+  }
+  run();
+
+  bool result = true;
+  try {
+    renumber(symtab, newlines);
+  }
+  catch (NodeError& ex) {
+    Reporter& out = *Reporter::getInstance();
+    out << out.beginError() << ex.what() << out.endl();
+    result = false;
+  }
+  std::vector<Part>().swap(parts);
+  statements = NULL;
+  return result;
+}
+
+const ConcurrentSymbolTable& ParallelSymbolTableBuilder::getSharedTable(void)
+  const
+{
+  return shared;
+}
+
+unsigned int ParallelSymbolTableBuilder::getNumThreads(void) const {
+  return num_threads;
+}
+
+void ParallelSymbolTableBuilder::run(void) {
+  next_part = 0;
+
+  // The calling thread is one of the workers
+  size_t num_workers = num_threads;
+  if (num_workers > parts.size()) num_workers = parts.size();
+  std::vector<pthread_t> threads;
+  for (size_t i = 1; i < num_workers; i++) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, runWorker, this) != 0) break;
+    threads.push_back(thread);
+  }
+  work();
+  for (size_t i = 0; i < threads.size(); i++) {
+    pthread_join(threads[i], NULL);
+  }
+}
+
+void* ParallelSymbolTableBuilder::runWorker(void* builder) {
+  static_cast<ParallelSymbolTableBuilder*>(builder)->work();
+  return NULL;
+}
+
+void ParallelSymbolTableBuilder::work(void) {
+  for (;;) {
+    size_t i = __sync_fetch_and_add(&next_part, 1);
+    if (i >= parts.size()) return;
+    Part& part = parts[i];
+    Resolver resolver(&shared, &part);
+    for (size_t j = part.begin; j < part.end; j++) {
+      resolver.resolve((*statements)[j]);
+    }
+  }
+}
+
+void ParallelSymbolTableBuilder::renumber(SymbolTable* symtab,
+                                          const NewlineIndex* newlines)
+  throw(NodeError)
+{
+  // The SymbolTableBuilder declares the variables and words the errors, so
+  // that both builders agree on them
+  SymbolTableBuilder builder;
+  builder.begin(symtab, newlines);
+  std::vector<int> symbols(shared.getNumRecords(), -1);
+  for (size_t i = 0; i < parts.size(); i++) {
+    const std::vector<Reference>& references = parts[i].references;
+    for (size_t j = 0; j < references.size(); j++) {
+      const Reference& reference = references[j];
+      NVariable* node = reference.node;
+      int& symbol = symbols[reference.symbol];
+      if (reference.is_declaration) {
+        // A redefinition is thrown from here
+        symbol = builder.declare(node->getName(), node->getOffset());
+      }
+      else if (symbol < 0) {
+        // The variable has not been declared yet, which this throws
+        builder.use(node->getName(), node->getOffset());
+      }
+      node->setSymbol(symbol);
+    }
+  }
+}
+
+ParallelSymbolTableBuilder::Resolver::Resolver(ConcurrentSymbolTable* shared,
+                                               Part* part)
+  : shared(shared),
+    part(part),
+    right_side_mode(true)
+{}
+
+void ParallelSymbolTableBuilder::Resolver::resolve(NStatement* node) {
+  right_side_mode = true;
+  traverse(node);
+}
+
+void ParallelSymbolTableBuilder::Resolver::preVisit(NAssignment* node)
+  throw(NodeError)
+{
+  right_side_mode = false;
+}
+
+void ParallelSymbolTableBuilder::Resolver::betweenChildren(NAssignment* node)
+  throw(NodeError)
+{
+  right_side_mode = true;
+}
+
+void ParallelSymbolTableBuilder::Resolver::postVisit(NAssignment* node)
+  throw(NodeError)
+{
+  NVariable* variable = node->getVariable();
+  Reference reference;
+  reference.node = variable;
+  reference.symbol = shared->intern(variable->getName(),
+                                    variable->getOffset());
+  reference.is_declaration = true;
+  part->references.push_back(reference);
+}
+
+void ParallelSymbolTableBuilder::Resolver::visit(NVariable* node)
+  throw(NodeError)
+{
+  if (!right_side_mode) return;
+  Reference reference;
+  reference.node = node;
+  reference.symbol = shared->intern(node->getName(), node->getOffset());
+  reference.is_declaration = false;
+  part->references.push_back(reference);
+}
+
+const size_t ParallelSymbolTableBuilder::STATEMENTS_PER_PART = 4096;
@@ -0,0 +1,304 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CEE_SYMTAB_PARALLEL_SYMBOL_TABLE_BUILDER__H
+#define CEE_SYMTAB_PARALLEL_SYMBOL_TABLE_BUILDER__H
+
+/**
+ * @file
+ * @brief Defines a symbol table builder which resolves names on several
+ *        threads.
+ */
+
+#include "../ast/ast.hpp"
+#include "../ast/static_visitor.hpp"
+#include "../grammar/newline_index.hpp"
+#include "concurrent_symbol_table.hpp"
+#include "symbol_table.hpp"
+#include <cstddef>
+#include <vector>
+
+/**
+ * \brief Symbol table builder which resolves names on several threads.
+ *
+ * The ParallelSymbolTableBuilder builds the same symbol table as the
+ * SymbolTableBuilder, with the same symbol ids and the same errors, but looks
+ * up the names on a pool of threads. The statements are cut into parts, and
+ * each thread takes parts and interns every variable of them in one
+ * ConcurrentSymbolTable, which all threads share. The ids of the shared table
+ * depend on the order in which the threads get to the names, so they are
+ * then renumbered in one sequential pass over the parts in statement order.
+ * That pass checks the declarations and uses by the ids alone, and only
+ * hashes a name again to insert a declaration into the symbol table.
+ */
+class ParallelSymbolTableBuilder {
+public:
+  /**
+   * Creates a symbol table builder.
+   *
+   * @param num_threads
+   *        Number of threads, or 0 for one per online processor.
+   */
+  ParallelSymbolTableBuilder(unsigned int num_threads = 0);
+
+  /**
+   * Builds a symbol table and checks that no variables are redefined or used
+   * before having been declared, like SymbolTableBuilder::build(). The symbol
+   * ids of the variables are set. If the program is semantically invalid, an
+   * error is reported and \c false is returned.
+   *
+   * @param node
+   *        Program node.
+   * @param symtab
+   *        Symbol table to build upon, which is cleared first.
+   * @param newlines
+   *        Newline index of the source, for locating errors.
+   * @returns \c true if the symbol table was successfully built.
+   */
+  bool build(AST::NProgram* node,
+             SymbolTable* symtab,
+             const NewlineIndex* newlines);
+
+  /**
+   * Gets the table shared by the threads during the last build. Its ids are
+   * not those of the built symbol table.
+   *
+   * @returns Shared symbol table.
+   */
+  const ConcurrentSymbolTable& getSharedTable(void) const;
+
+  /**
+   * Gets the number of threads.
+   *
+   * @returns Number of threads.
+   */
+  unsigned int getNumThreads(void) const;
+
+public:
+  /**
+   * Number of statements of a part.
+   */
+  static const size_t STATEMENTS_PER_PART;
+
+private:
+  /**
+   * \brief Variable of a part, as found by a thread.
+   */
+  struct Reference {
+    /**
+     * Variable node.
+     */
+    AST::NVariable* node;
+
+    /**
+     * Symbol id of the variable in the shared table.
+     */
+    int symbol;
+
+    /**
+     * Whether the variable is declared, rather than used.
+     */
+    bool is_declaration;
+  };
+
+  /**
+   * \brief Range of statements which is resolved by one thread.
+   */
+  struct Part {
+    /**
+     * Index of the first statement.
+     */
+    size_t begin;
+
+    /**
+     * Index past the last statement.
+     */
+    size_t end;
+
+    /**
+     * Variables of the statements, in the order in which the
+     * SymbolTableBuilder visits them.
+     */
+    std::vector<Reference> references;
+  };
+
+  /**
+   * \brief Visitor which interns the variables of a part.
+   */
+  class Resolver : public AST::StaticVisitor<Resolver> {
+  public:
+    using AST::StaticVisitor<Resolver>::preVisit;
+    using AST::StaticVisitor<Resolver>::betweenChildren;
+    using AST::StaticVisitor<Resolver>::postVisit;
+    using AST::StaticVisitor<Resolver>::visit;
+
+    /**
+     * Creates a visitor.
+     *
+     * @param shared
+     *        Shared symbol table.
+     * @param part
+     *        Part whose references are appended.
+     */
+    Resolver(ConcurrentSymbolTable* shared, Part* part);
+
+    /**
+     * Interns the variables of a statement.
+     *
+     * @param node
+     *        Statement node.
+     */
+    void resolve(AST::NStatement* node);
+
+    /**
+     * Sets the mode to "L" mode.
+     *
+     * @param node
+     *        Assignment node.
+     * @throws NodeError
+     *         Will not be thrown.
+     */
+    void preVisit(AST::NAssignment* node) throw(AST::NodeError);
+
+    /**
+     * Sets the mode back to "R" mode.
+     *
+     * @param node
+     *        Assignment node.
+     * @throws NodeError
+     *         Will not be thrown.
+     */
+    void betweenChildren(AST::NAssignment* node) throw(AST::NodeError);
+
+    /**
+     * Interns the variable on the left-hand side.
+     *
+     * @param node
+     *        Assignment node.
+     * @throws NodeError
+     *         Will not be thrown.
+     */
+    void postVisit(AST::NAssignment* node) throw(AST::NodeError);
+
+    /**
+     * Interns a used variable.
+     *
+     * @param node
+     *        Variable node.
+     * @throws NodeError
+     *         Will not be thrown.
+     */
+    void visit(AST::NVariable* node) throw(AST::NodeError);
+
+  private:
+    /**
+     * Shared symbol table.
+     */
+    ConcurrentSymbolTable* shared;
+
+    /**
+     * Part whose references are appended.
+     */
+    Part* part;
+
+    /**
+     * Flag for controlling "L" and "R" mode in assignment nodes.
+     */
+    bool right_side_mode;
+  };
+
+private:
+  /**
+   * Resolves every part, using the pool of threads.
+   */
+  void run(void);
+
+  /**
+   * Entry point of the threads of the pool.
+   *
+   * @param builder
+   *        ParallelSymbolTableBuilder running the parts.
+   * @returns \c NULL.
+   */
+  static void* runWorker(void* builder);
+
+  /**
+   * Takes parts and resolves them until there are no parts left.
+   */
+  void work(void);
+
+  /**
+   * Builds the symbol table from the resolved parts, in statement order, and
+   * sets the symbol ids of the variables.
+   *
+   * @param symtab
+   *        Symbol table to build upon.
+   * @param newlines
+   *        Newline index of the source, for locating errors.
+   * @throws NodeError
+   *         When a variable is redefined or used before having been declared.
+   */
+  void renumber(SymbolTable* symtab, const NewlineIndex* newlines)
+    throw(AST::NodeError);
+
+  /**
+   * Hidden copy constructor.
+   */
+  ParallelSymbolTableBuilder(const ParallelSymbolTableBuilder&);
+
+  /**
+   * Hidden assignment operator.
+   */
+  ParallelSymbolTableBuilder& operator=(const ParallelSymbolTableBuilder&);
+
+private:
+  /**
+   * Number of threads.
+   */
+  unsigned int num_threads;
+
+  /**
+   * Symbol table shared by the threads.
+   */
+  ConcurrentSymbolTable shared;
+
+  /**
+   * Statements of the program being built.
+   */
+  const std::vector<AST::NStatement*>* statements;
+
+  /**
+   * Parts of the statements.
+   */
+  std::vector<Part> parts;
+
+  /**
+   * Index of the next part to be taken by a thread.
+   */
+  volatile size_t next_part;
+};
+
+#endif
@@ -3,69 +3,94 @@
 
 using std::string;
 
-SymbolTable::SymbolTable(void) {}
+SymbolTable::SymbolTable(void) : memory_index_counter(0) {}
 
 SymbolTable::~SymbolTable(void) {
   clear();
 }
 
+SymbolTable::Record* SymbolTable::lookUp(const TextSpan& name) const {
+  int symbol = getSymbol(name);
+  return symbol < 0 ? NULL : getRecord(symbol);
+}
+
 SymbolTable::Record* SymbolTable::lookUp(const string& name) const {
-  try {
-    return symbol_map.at(name);
-  } catch (const std::out_of_range& e) {
-    return NULL;
-  }
+  return lookUp(TextSpan(name));
+}
+
+int SymbolTable::getSymbol(const TextSpan& name) const {
+  if (slots.empty()) return -1;
+  uint32_t hash = static_cast<uint32_t>(name.hash());
+  return static_cast<int>(slots[findSlot(name, hash)].record) - 1;
 }
 
-bool SymbolTable::insert(const string& name, int line, int column) {
-  Record* record = new Record(name, line, column, memory_index_counter++);
-  // Will return true if the element was inserted.
-  return symbol_map.insert(std::make_pair(name, record)).second;
+bool SymbolTable::insert(const TextSpan& name, unsigned int offset) {
+  // Keep the table at most half full, so that probe sequences stay short
+  if (2 * (records.size() + 1) > slots.size()) grow();
+
+  uint32_t hash = static_cast<uint32_t>(name.hash());
+  Slot& slot = slots[findSlot(name, hash)];
+  if (slot.record != 0) return false;
+
+  // The name is only copied once it is known to be new
+  TextSpan copy(names.copyText(name.data(), name.length()), name.length());
+  records.push_back(Record(copy, offset, memory_index_counter++));
+  slot.hash = hash;
+  slot.record = static_cast<uint32_t>(records.size());
+  return true;
+}
+
+bool SymbolTable::insert(const string& name, unsigned int offset) {
+  return insert(TextSpan(name), offset);
 }
 
 void SymbolTable::clear(void) {
-  // Destroy all records
-  std::map<string, Record*>::const_iterator it;
-  for (it = symbol_map.begin(); it != symbol_map.end(); it++) {
-    delete it->second;
-  }
+  records.clear();
+  slots.clear();
+  names.release();
+  memory_index_counter = 0;
+}
 
-  symbol_map.clear();
+size_t SymbolTable::findSlot(const TextSpan& name, uint32_t hash) const {
+  size_t mask = slots.size() - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    const Slot& slot = slots[i];
+    if (slot.record == 0) return i;
+    if (slot.hash == hash && records[slot.record - 1].getName() == name) {
+      return i;
+    }
+  }
 }
 
-std::list<SymbolTable::Record*> SymbolTable::getRecords(void) const {
-  std::list<Record*> records;
-  std::transform(symbol_map.begin(), symbol_map.end(),
-                 std::back_inserter(records),
-                 [](std::pair<string, Record*> val) {
-                   return val.second;
-                 });
-  return records;
+void SymbolTable::grow(void) {
+  std::vector<Slot> old_slots(slots.empty() ? 16 : 2 * slots.size());
+  old_slots.swap(slots);
+  size_t mask = slots.size() - 1;
+  for (size_t i = 0; i < old_slots.size(); i++) {
+    if (old_slots[i].record == 0) continue;
+    size_t j = old_slots[i].hash & mask;
+    while (slots[j].record != 0) j = (j + 1) & mask;
+    slots[j] = old_slots[i];
+  }
 }
 
 SymbolTable::Record::Record(
-                            const string& name,
-                            int line,
-                            int column,
+                            const TextSpan& name,
+                            unsigned int offset,
                             int memory_index)
   : _name(name),
-    _line(line),
-    _column(column),
+    _offset(offset),
     _memory_index(memory_index)
 {}
 
 SymbolTable::Record::~Record(void) {}
 
-string SymbolTable::Record::getName(void) const {
+TextSpan SymbolTable::Record::getName(void) const {
   return _name;
 }
 
-int SymbolTable::Record::getLine(void) const {
-  return _line;
-}
-
-int SymbolTable::Record::getColumn(void) const {
-  return _column;
+unsigned int SymbolTable::Record::getOffset(void) const {
+  return _offset;
 }
 
 int SymbolTable::Record::getMemoryIndex(void) const {
@@ -32,9 +32,11 @@
  * @brief Defines the classes and functions for managing the symbol table.
  */
 
-#include <list>
+#include "../ast/node_arena.hpp"
+#include "../ast/text_span.hpp"
+#include <stdint.h>
 #include <string>
-#include <map>
+#include <vector>
 
 /**
  * \brief Defines an implementation of a symbol table.
@@ -42,6 +44,17 @@
  * The symbol table contains the variables that are declared and used within the
  * code. The table contains a set of records (see Record), which are generated
  * as the AST is traversed.
+ *
+ * The records are stored by value in a single array, in the order in which
+ * they were inserted, and are found through an open-addressing hash table of
+ * record indices with linear probing. The names are copied into an arena owned
+ * by the table. Looking up a name thus neither allocates nor throws, and
+ * walking over the records needs no container of its own.
+ *
+ * The index of a record is the symbol id of its identifier. The ids are dense,
+ * so once a name has been looked up, its id can be kept (see
+ * AST::NVariable::getSymbol()) and the record fetched with getRecord() without
+ * hashing the name again.
  */
 class SymbolTable {
 public:
@@ -62,35 +75,70 @@ public:
    * Gets the record with a given identifier name. If no such record is found,
    * \c NULL is returned.
    *
+   * The record is stored within the table, so the pointer is only valid until
+   * the next call to insert() or clear().
+   *
    * @param name
    *        Identifier name.
    * @returns Record with matching name.
    */
+  Record* lookUp(const TextSpan& name) const;
+
+  /**
+   * \copydoc lookUp(const TextSpan&) const
+   */
   Record* lookUp(const std::string& name) const;
 
+  /**
+   * Gets the symbol id of the identifier with a given name, which is the
+   * index of its record.
+   *
+   * @param name
+   *        Identifier name.
+   * @returns Symbol id, or -1 if no record has the name.
+   */
+  int getSymbol(const TextSpan& name) const;
+
   /**
    * Adds an identifier with a given name to this symbol table. If an
    * identifier with an identical name has already been inserted, no change is
-   * made and false is returned.
+   * made and false is returned. The symbol id of a new identifier is the
+   * number of records before it was inserted.
    *
    * @param name
-   *        Identifier name.
-   * @param line
-   *        Line number where the identifer was declared.
-   * @param column
-   *        Column number where the identifer was declared.
+   *        Identifier name, which is copied.
+   * @param offset
+   *        Source offset where the identifer was declared.
    * @returns \c true if the identifier was inserted.
    */
-  bool insert(const std::string& name, int line, int column);
+  bool insert(const TextSpan& name, unsigned int offset);
+
+  /**
+   * \copydoc insert(const TextSpan&, unsigned int)
+   */
+  bool insert(const std::string& name, unsigned int offset);
 
   /**
-   * Gets a list of all records in the symbol table. The returned list need
-   * not be any particular order (this method is used for inspection purposes
-   * only).
+   * Gets the number of records in the symbol table.
    *
-   * @returns All records.
+   * @returns Number of records.
    */
-  std::list<Record*> getRecords(void) const;
+  size_t getNumRecords(void) const {
+    return records.size();
+  }
+
+  /**
+   * Gets a record of the symbol table. The records are numbered in the order
+   * in which they were inserted, and the pointer is valid until the next call
+   * to insert() or clear().
+   *
+   * @param i
+   *        Record index, less than getNumRecords().
+   * @returns Record.
+   */
+  Record* getRecord(size_t i) const {
+    return const_cast<Record*>(&records[i]);
+  }
 
   /**
    * Clears the entire symbol table and destroys all records.
@@ -98,15 +146,54 @@ public:
   void clear(void);
 
 private:
-  /* TASK: Add whatever private members and methods you find necessary */
-  std::map<std::string, Record*> symbol_map;
-  unsigned int memory_index_counter = 0;
+  /**
+   * \brief Slot of the hash table.
+   */
+  struct Slot {
+    /**
+     * Hash of the name (truncated), which is compared before the name itself
+     * and keeps the table from having to hash the names when it grows.
+     */
+    uint32_t hash;
+
+    /**
+     * Index of the record plus one, or 0 if the slot is free.
+     */
+    uint32_t record;
+  };
+
+  /**
+   * Finds the slot of a name, which is either the slot of its record or the
+   * free slot where its record belongs.
+   *
+   * @param name
+   *        Identifier name.
+   * @param hash
+   *        Hash of the name.
+   * @returns Slot index.
+   */
+  size_t findSlot(const TextSpan& name, uint32_t hash) const;
+
+  /**
+   * Doubles the number of slots and places all records anew.
+   */
+  void grow(void);
+
+  /**
+   * Hidden copy constructor, as the records refer to names in the arena.
+   */
+  SymbolTable(const SymbolTable&);
+
+  /**
+   * Hidden assignment operator.
+   */
+  SymbolTable& operator=(const SymbolTable&);
 
 public:
   /**
    * \brief Class for representing entries in the symbol table.
    *
-   * The Record class defines the name of the identifier, the line number at
+   * The Record class defines the name of the identifier, the source offset at
    * which it declard, and a new memory index. The latter will be used to
    * specify where to store the value of the identifier at run time.
    */
@@ -116,19 +203,16 @@ public:
      * Creates a record for an identifier.
      *
      * @param name
-     *        Name of the identifier.
-     * @param line
-     *        Line number at which the identifier was declared.
-     * @param column
-     *        Column number at which the identifier was declared.
+     *        Name of the identifier, which must outlive the record.
+     * @param offset
+     *        Source offset at which the identifier was declared.
      * @param memory_index
      *        Memory index at where the value of the identifier will
      *        be stored.
      */
     Record(
-           const std::string& name,
-           int line,
-           int column,
+           const TextSpan& name,
+           unsigned int offset,
            int memory_index);
 
     /**
@@ -139,25 +223,18 @@ public:
     /**
      * Gets the identifier name of this record.
      *
-     * @returns Identifier name.
-     */
-    std::string getName(void) const;
-
-    /**
-     * Gets the line number at which the identifier of this record was
-     * declared
-     *
-     * @returns Line number.
+     * @returns Identifier name, valid as long as the symbol table.
      */
-    int getLine(void) const;
+    TextSpan getName(void) const;
 
     /**
-     * Gets the column number at which the identifier of this record was
-     * declared
+     * Gets the source offset at which the identifier of this record was
+     * declared. The NewlineIndex of the source turns it into a line and
+     * column.
      *
-     * @returns Column number.
+     * @returns Source offset.
      */
-    int getColumn(void) const;
+    unsigned int getOffset(void) const;
 
     /**
      * Gets the memory index of this record.
@@ -180,23 +257,40 @@ public:
     /**
      * Name of the variable.
      */
-    std::string _name;
+    TextSpan _name;
 
     /**
-     * Line number at which the variable was declared.
+     * Source offset at which the variable was declared.
      */
-    int _line;
-
-    /**
-     * Column number at which the variable was declared.
-     */
-    int _column;
+    unsigned int _offset;
 
     /**
      * Memory index assigned to the variable.
      */
     int _memory_index;
   };
+
+private:
+  /**
+   * Records, in the order in which they were inserted.
+   */
+  std::vector<Record> records;
+
+  /**
+   * Hash table, whose size is 0 or a power of 2 and which is kept at most
+   * half full.
+   */
+  std::vector<Slot> slots;
+
+  /**
+   * Arena in which the names are kept.
+   */
+  AST::NodeArena names;
+
+  /**
+   * Memory index to assign to the next record.
+   */
+  unsigned int memory_index_counter;
 };
 
 #endif
@@ -6,12 +6,12 @@
 
 using namespace AST;
 
-bool SymbolTableBuilder::build(NProgram* node, SymbolTable* symtab) {
-  symbol_table = symtab;
-  symbol_table->clear();
-  right_side_mode = true;
+bool SymbolTableBuilder::build(NProgram* node,
+                               SymbolTable* symtab,
+                               const NewlineIndex* newlines) {
+  begin(symtab, newlines);
   try {
-    node->accept(this);
+    traverse(node);
     return true;
   }
   catch (NodeError& ex) {
@@ -21,6 +21,44 @@ bool SymbolTableBuilder::build(NProgram* node, SymbolTable* symtab) {
   }
 }
 
+bool SymbolTableBuilder::build(FlatAst* ast,
+                               SymbolTable* symtab,
+                               const NewlineIndex* newlines) {
+  begin(symtab, newlines);
+  try {
+    // The nodes are in post-order, so every use in the expression of an
+    // assignment is checked before the variable is declared
+    for (unsigned int i = 0; i < ast->getNumNodes(); i++) {
+      FlatAst::Kind kind = ast->getKind(i);
+      if (kind == FlatAst::VARIABLE) {
+        ast->setSymbol(i, use(ast->getText(i), ast->getOffset(i)));
+      }
+      else if (kind == FlatAst::ASSIGNMENT) {
+        ast->setSymbol(i, declare(ast->getText(i), ast->getOffset(i)));
+      }
+    }
+    return true;
+  }
+  catch (NodeError& ex) {
+    Reporter& out = *Reporter::getInstance();
+    out << out.beginError() << ex.what() << out.endl();
+    return false;
+  }
+}
+
+void SymbolTableBuilder::begin(SymbolTable* symtab,
+                               const NewlineIndex* newlines) {
+  symbol_table = symtab;
+  this->newlines = newlines;
+  symbol_table->clear();
+  right_side_mode = true;
+}
+
+void SymbolTableBuilder::addStatement(NStatement* node) throw(NodeError) {
+  right_side_mode = true;
+  traverse(node);
+}
+
 void SymbolTableBuilder::preVisit(AST::NAssignment* node) throw(AST::NodeError)
 {
   right_side_mode = false;
@@ -32,32 +70,50 @@ void SymbolTableBuilder::betweenChildren(NAssignment* node) throw(NodeError) {
 
 void SymbolTableBuilder::postVisit(AST::NAssignment* node) throw(AST::NodeError) {
   NVariable* variable = node->getVariable();
-  std::string name = variable->getName();
+  variable->setSymbol(declare(variable->getName(), variable->getOffset()));
+}
+
+void SymbolTableBuilder::visit(NVariable* node) throw(NodeError) {
+  if (!right_side_mode) return;
+  node->setSymbol(use(node->getName(), node->getOffset()));
+}
 
+int SymbolTableBuilder::declare(const TextSpan& name, unsigned int offset)
+  throw(NodeError)
+{
   // Add the identifier to the symbol table
-  bool result = symbol_table->insert(variable->getName(),
-                                     variable->getLine(),
-                                     variable->getColumn());
+  bool result = symbol_table->insert(name, offset);
   if (!result) {
     SymbolTable::Record* record = symbol_table->lookUp(name);
     std::stringstream ss;
     ss << "Redefinition of variable at "
-       << node->getLine() << ":" << node->getColumn() << "; "
-       << "\"" << variable->getName() << "\" was already declared at "
-       << record->getLine() << ":" << record->getColumn();
+       << locate(offset) << "; "
+       << "\"" << name << "\" was already declared at "
+       << locate(record->getOffset());
     throw NodeError(ss.str());
   }
+  return static_cast<int>(symbol_table->getNumRecords()) - 1;
 }
 
-void SymbolTableBuilder::visit(NVariable* node) throw(NodeError) {
-  if (!right_side_mode) return;
-
+int SymbolTableBuilder::use(const TextSpan& name, unsigned int offset)
+  throw(NodeError)
+{
   // Check that the identifier has already been declared
-  if (!symbol_table->lookUp(node->getName())) {
+  int symbol = symbol_table->getSymbol(name);
+  if (symbol < 0) {
     std::stringstream ss;
     ss << "Invalid use of variable at "
-       << node->getLine() << ":" << node->getColumn() << "; "
-       << "\"" << node->getName() << "\" has not yet been declared";
+       << locate(offset) << "; "
+       << "\"" << name << "\" has not yet been declared";
     throw NodeError(ss.str());
   }
+  return symbol;
+}
+
+std::string SymbolTableBuilder::locate(unsigned int offset) const {
+  int line, column;
+  newlines->lookUp(offset, &line, &column);
+  std::stringstream ss;
+  ss << line << ":" << column;
+  return ss.str();
 }
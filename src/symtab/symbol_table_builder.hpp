@@ -33,7 +33,11 @@
  */
 
 #include "../ast/ast.hpp"
+#include "../ast/flat_ast.hpp"
+#include "../ast/static_visitor.hpp"
+#include "../grammar/newline_index.hpp"
 #include "symbol_table.hpp"
+#include <string>
 
 /**
  * \brief Class for building the symbol table.
@@ -41,10 +45,19 @@
  * The SymbolTableBuilder implements a visitor which will traverse the entire
  * AST and build a symbol table. The visitor will also check that each variable
  * has been declared before use, and produce an error if invalid use is
- * detected.
+ * detected. The visitor is a StaticVisitor, so the traversal makes no virtual
+ * calls.
+ *
+ * Every variable is resolved to its symbol id on the way, which is the only
+ * time its name is looked up. The later passes find the record by the id.
  */
-class SymbolTableBuilder : public AST::DefaultVisitor {
+class SymbolTableBuilder : public AST::StaticVisitor<SymbolTableBuilder> {
 public:
+  using AST::StaticVisitor<SymbolTableBuilder>::preVisit;
+  using AST::StaticVisitor<SymbolTableBuilder>::betweenChildren;
+  using AST::StaticVisitor<SymbolTableBuilder>::postVisit;
+  using AST::StaticVisitor<SymbolTableBuilder>::visit;
+
   /**
    * Builds a symbol table and checks that no variables are redefined or
    * used before having been declared. If the program is semantically
@@ -58,9 +71,84 @@ public:
    *        Program node.
    * @param symtab
    *        Symbol table to build upon.
+   * @param newlines
+   *        Newline index of the source, for locating errors.
+   * @returns \c true if the symbol table was successfully built.
+   */
+  bool build(AST::NProgram* node,
+             SymbolTable* symtab,
+             const NewlineIndex* newlines);
+
+  /**
+   * Builds a symbol table from the flat representation of a program, in one
+   * linear pass over its nodes, and sets the symbol ids of its variables.
+   * Otherwise the same as
+   * build(AST::NProgram*, SymbolTable*, const NewlineIndex*).
+   *
+   * @param ast
+   *        Flat AST.
+   * @param symtab
+   *        Symbol table to build upon.
+   * @param newlines
+   *        Newline index of the source, for locating errors.
    * @returns \c true if the symbol table was successfully built.
    */
-  bool build(AST::NProgram* node, SymbolTable* symtab);
+  bool build(AST::FlatAst* ast,
+             SymbolTable* symtab,
+             const NewlineIndex* newlines);
+
+  /**
+   * Starts building a symbol table one statement at a time, for when the
+   * statements become available one by one. The given table is cleared.
+   *
+   * @param symtab
+   *        Symbol table to build upon.
+   * @param newlines
+   *        Newline index of the source, for locating errors. It may still
+   *        grow while the statements are added.
+   */
+  void begin(SymbolTable* symtab, const NewlineIndex* newlines);
+
+  /**
+   * Adds the declarations of the next statement of the program to the symbol
+   * table given to begin(), and checks its variable uses.
+   *
+   * @param node
+   *        Statement node.
+   * @throws NodeError
+   *         When a variable is redefined or used before having been declared.
+   */
+  void addStatement(AST::NStatement* node) throw(AST::NodeError);
+
+  /**
+   * Adds a variable to the symbol table given to begin(). Together with
+   * use(), this lets another pass, such as the CodeGenerator, build the symbol
+   * table as it traverses the program itself.
+   *
+   * @param name
+   *        Variable name.
+   * @param offset
+   *        Source offset of the declaration.
+   * @returns Symbol id of the variable.
+   * @throws NodeError
+   *         When the variable has already been declared.
+   */
+  int declare(const TextSpan& name, unsigned int offset)
+    throw(AST::NodeError);
+
+  /**
+   * Checks that a variable has been declared before it is used, in the
+   * symbol table given to begin().
+   *
+   * @param name
+   *        Variable name.
+   * @param offset
+   *        Source offset of the use.
+   * @returns Symbol id of the variable.
+   * @throws NodeError
+   *         When the variable has not been declared.
+   */
+  int use(const TextSpan& name, unsigned int offset) throw(AST::NodeError);
 
 
   /**
@@ -71,7 +159,7 @@ public:
    * @throws NodeError
    *         Will not be thrown.
    */
-  virtual void preVisit(AST::NAssignment* node) throw(AST::NodeError);
+  void preVisit(AST::NAssignment* node) throw(AST::NodeError);
 
   /**
    * Sets the mode back to "R" mode.
@@ -81,31 +169,41 @@ public:
    * @throws NodeError
    *         Will not be thrown.
    */
-  virtual void betweenChildren(AST::NAssignment* node) throw(AST::NodeError);
+  void betweenChildren(AST::NAssignment* node) throw(AST::NodeError);
 
   /**
-   * Adds the identifier on the left-hand side to the symbol table.
+   * Adds the identifier on the left-hand side to the symbol table, and sets
+   * its symbol id.
    *
    * @param node
    *        Assignment node.
    * @throws NodeError
    *         When a variable is redefined.
    */
-  virtual void postVisit(AST::NAssignment* node) throw(AST::NodeError);
+  void postVisit(AST::NAssignment* node) throw(AST::NodeError);
 
   /**
-   * Visits the variable node and checks whether the variable has been
-   * declared before use.
+   * Visits the variable node, checks whether the variable has been declared
+   * before use and sets its symbol id.
    *
    * @param node
    *        Variable node.
    * @throws NodeError
    *         When the variable is not available in the symbol table.
    */
-  virtual void visit(AST::NVariable* node) throw(AST::NodeError);
+  void visit(AST::NVariable* node) throw(AST::NodeError);
 
 
 private:
+  /**
+   * Formats the line and column of a source offset.
+   *
+   * @param offset
+   *        Source offset.
+   * @returns Location as "line:column".
+   */
+  std::string locate(unsigned int offset) const;
+
   /**
    * Contains the symbol table.
    */
@@ -117,6 +215,11 @@ private:
    * <code>a = a;</code>.
    */
   bool right_side_mode;
+
+  /**
+   * Newline index of the source.
+   */
+  const NewlineIndex* newlines;
 };
 
 #endif
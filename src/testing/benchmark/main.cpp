@@ -0,0 +1,728 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * USE: For benchmarking the scanners, the AST traversal and the virtual
+ * machine. The selected region is run a number of times and the wall time is
+ * reported, optionally together with hardware performance counters normalized
+ * per processed unit (executed bytecode instruction, scanned token or visited
+ * node). The traversal region visits the AST once through the virtual
+ * IVisitor interface and once with a StaticVisitor, so the two can be
+ * compared. The symbol table region interns the identifiers of the input
+ * into a SymbolTable, and then with "--threads N" threads into one shared
+ * ConcurrentSymbolTable (the counters only cover the former). The AST
+ * region parses the input with the FastParser into a tree and then into a
+ * DAG of shared expressions, and also reports the heap memory each AST uses.
+ */
+
+#include "../../grammar/common.hpp" // Must be included before "parser.tab.h"
+#include "../../grammar/parser.tab.h"
+#include "../../grammar/lex.yy.h"
+#include "../../ast/ast.hpp"
+#include "../../ast/static_visitor.hpp"
+#include "../../decoder/decoder.hpp"
+#include "../../grammar/fast_parser.hpp"
+#include "../../grammar/fast_scanner.hpp"
+#include "../../grammar/parse_context.hpp"
+#include "../../io/file_reader.hpp"
+#include "../../io/reporter.hpp"
+#include "../../profiling/perf_counters.hpp"
+#include "../../symtab/concurrent_symbol_table.hpp"
+#include "../../symtab/symbol_table.hpp"
+#include "../../vm/virtual_machine.hpp"
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <ios>
+#include <iostream>
+#include <iterator>
+#include <malloc.h>
+#include <sstream>
+#include <pthread.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace AST;
+using std::fixed;
+using std::ios_base;
+using std::setprecision;
+using std::string;
+using std::stringstream;
+using std::vector;
+
+/**
+ * Implements a decoder which counts the instructions of a program. As the
+ * instruction set has no jumps, this is also the number of instructions the
+ * virtual machine executes when the program runs to completion.
+ */
+class InstructionCounter : private Decoder {
+  public:
+    InstructionCounter(void) : _count(0) {}
+
+    long long count(const std::vector<char>& program) {
+        _count = 0;
+        invoke(program);
+        return _count;
+    }
+
+  protected:
+    virtual bool prepareEnvironment(void) { return true; }
+    virtual bool processMagicNumber(int number) { return true; }
+    virtual bool processMemorySize(int value) { return true; }
+    virtual bool processInstLOAD(void) { return tick(); }
+    virtual bool processInstSTORE(void) { return tick(); }
+    virtual bool processInstCONST_1B(char value) { return tick(); }
+    virtual bool processInstCONST_2B(short value) { return tick(); }
+    virtual bool processInstCONST_4B(int value) { return tick(); }
+    virtual bool processInstCONST_0(void) { return tick(); }
+    virtual bool processInstCONST_1(void) { return tick(); }
+    virtual bool processInstADD(void) { return tick(); }
+    virtual bool processInstSUB(void) { return tick(); }
+    virtual bool processInstMUL(void) { return tick(); }
+    virtual bool processInstDIV(void) { return tick(); }
+    virtual bool processInstSWAP(void) { return tick(); }
+    virtual bool processInstPRINT(void) { return tick(); }
+    virtual bool processInstUnknown(char inst) { return false; }
+
+  private:
+    bool tick(void) {
+        _count++;
+        return true;
+    }
+
+  private:
+    long long _count;
+};
+
+/**
+ * Implements a visitor which counts the nodes of an AST through the virtual
+ * IVisitor interface, as the visitors did before the StaticVisitor.
+ */
+class DynamicNodeCounter : public DefaultVisitor {
+  public:
+    DynamicNodeCounter(void) : _count(0) {}
+
+    long long count(NProgram* program) {
+        _count = 0;
+        program->accept(this);
+        return _count;
+    }
+
+    virtual void visit(NProgram* node) throw(NodeError) { tick(); }
+    virtual void visit(NStatementList* node) throw(NodeError) { tick(); }
+    virtual void visit(NAssignment* node) throw(NodeError) { tick(); }
+    virtual void visit(NPrint* node) throw(NodeError) { tick(); }
+    virtual void visit(NExpressionUnary* node) throw(NodeError) { tick(); }
+    virtual void visit(NExpressionBinary* node) throw(NodeError) { tick(); }
+    virtual void visit(NNumber* node) throw(NodeError) { tick(); }
+    virtual void visit(NVariable* node) throw(NodeError) { tick(); }
+
+  private:
+    void tick(void) {
+        _count++;
+    }
+
+  private:
+    long long _count;
+};
+
+/**
+ * Implements a visitor which counts the nodes of an AST with a StaticVisitor.
+ */
+class StaticNodeCounter : public StaticVisitor<StaticNodeCounter> {
+  public:
+    StaticNodeCounter(void) : _count(0) {}
+
+    long long count(NProgram* program) {
+        _count = 0;
+        traverse(program);
+        return _count;
+    }
+
+    void visit(NProgram* node) throw(NodeError) { tick(); }
+    void visit(NStatementList* node) throw(NodeError) { tick(); }
+    void visit(NAssignment* node) throw(NodeError) { tick(); }
+    void visit(NPrint* node) throw(NodeError) { tick(); }
+    void visit(NExpressionUnary* node) throw(NodeError) { tick(); }
+    void visit(NExpressionBinary* node) throw(NodeError) { tick(); }
+    void visit(NNumber* node) throw(NodeError) { tick(); }
+    void visit(NVariable* node) throw(NodeError) { tick(); }
+
+  private:
+    void tick(void) {
+        _count++;
+    }
+
+  private:
+    long long _count;
+};
+
+/**
+ * Part of the identifiers which a thread interns into a shared
+ * ConcurrentSymbolTable.
+ */
+struct InternTask {
+    ConcurrentSymbolTable* symtab;
+    const vector<TextSpan>* names;
+    size_t begin;
+    size_t end;
+};
+
+/**
+ * Gets a monotonic timestamp.
+ *
+ * @returns Time in seconds.
+ */
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Formats a ratio, or "n/a" if it cannot be computed.
+ *
+ * @param numerator
+ *        Numerator (negative if unavailable).
+ * @param denominator
+ *        Denominator.
+ * @returns Formatted ratio.
+ */
+static string ratio(long long numerator, long long denominator) {
+    if (numerator < 0 || denominator <= 0) return "n/a";
+    stringstream ss;
+    ss << fixed << setprecision(4)
+       << static_cast<double>(numerator) / denominator;
+    return ss.str();
+}
+
+/**
+ * Prints the measurements of a region.
+ *
+ * @param region
+ *        Name of the measured region.
+ * @param unit
+ *        Name of the unit of work processed by the region.
+ * @param runs
+ *        Number of times the region was run.
+ * @param units_per_run
+ *        Number of units processed per run.
+ * @param wall_time
+ *        Total wall time (in seconds).
+ * @param counters
+ *        Counters covering all runs, or \c NULL if they were not requested.
+ */
+static void report(
+    const string& region,
+    const string& unit,
+    int runs,
+    long long units_per_run,
+    double wall_time,
+    const PerfCounters* counters)
+{
+    Reporter& out = *Reporter::getInstance();
+    long long total_units = units_per_run * runs;
+
+    stringstream ss;
+    ss << fixed << setprecision(3) << wall_time * 1000 / runs;
+    out << out.endl()
+        << out.beginInfo() << "REGION: " << region << out.endl()
+        << "  runs: " << runs << out.endl()
+        << "  " << unit << "s per run: " << units_per_run << out.endl()
+        << "  wall time per run (ms): " << ss.str() << out.endl()
+        << "  ns per " << unit << ": "
+        << ratio(static_cast<long long>(wall_time * 1e9), total_units)
+        << out.endl();
+
+    if (!counters) return;
+    if (!counters->isAnyAvailable()) {
+        out << "  hardware counters: not available "
+            << "(perf_event_open failed; check perf_event_paranoid)"
+            << out.endl();
+        return;
+    }
+
+    for (int i = 0; i < PerfCounters::NUM_EVENTS; i++) {
+        PerfCounters::Event event = static_cast<PerfCounters::Event>(i);
+        out << "  " << PerfCounters::getEventName(event) << ": ";
+        if (counters->isAvailable(event)) {
+            out << counters->getValue(event) << " ("
+                << ratio(counters->getValue(event), total_units)
+                << " per " << unit << ")";
+        }
+        else {
+            out << "n/a";
+        }
+        out << out.endl();
+    }
+    out << "  IPC: "
+        << ratio(counters->getValue(PerfCounters::INSTRUCTIONS),
+                 counters->getValue(PerfCounters::CYCLES))
+        << out.endl();
+}
+
+/**
+ * Benchmarks the virtual machine on a compiled program.
+ *
+ * @param program_file
+ *        Program file.
+ * @param runs
+ *        Number of runs.
+ * @param counters
+ *        Counters to use, or \c NULL.
+ * @returns Exit status.
+ */
+static int benchmarkVM(
+    const string& program_file,
+    int runs,
+    PerfCounters* counters)
+{
+    Reporter& out = *Reporter::getInstance();
+
+    FileReader reader;
+    vector<char> program;
+    try {
+        reader.open(program_file);
+        reader >> program;
+    }
+    catch (ios_base::failure) {
+        out << out.beginError() << "Failed to read input file" << out.endl();
+        return 1;
+    }
+
+    InstructionCounter instruction_counter;
+    long long num_instructions = instruction_counter.count(program);
+
+    VirtualMachine vm;
+    double wall_time = 0;
+    for (int i = 0; i < runs; i++) {
+        double start = now();
+        if (counters) counters->start();
+        vm.execute(program);
+        if (counters) counters->stop();
+        wall_time += now() - start;
+    }
+
+    report("vm", "bytecode instruction", runs, num_instructions, wall_time,
+           counters);
+    return 0;
+}
+
+/**
+ * Reads the entire standard input.
+ *
+ * @returns Input.
+ */
+static string readStandardInput(void) {
+    std::cin >> std::noskipws;
+    return string((std::istream_iterator<char>(std::cin)),
+                  std::istream_iterator<char>());
+}
+
+/**
+ * Benchmarks the flex scanner on the standard input.
+ *
+ * @param runs
+ *        Number of runs.
+ * @param counters
+ *        Counters to use, or \c NULL.
+ * @returns Exit status.
+ */
+static int benchmarkScanner(int runs, PerfCounters* counters) {
+    string input = readStandardInput();
+
+    yyscan_t scanner;
+    if (yylex_init(&scanner) != 0) {
+        Reporter& out = *Reporter::getInstance();
+        out << out.beginError() << "Failed to create scanner" << out.endl();
+        return 1;
+    }
+
+    // Each run scans a new buffer, which starts again at offset 0
+    YYSTYPE value;
+    YYLTYPE location;
+    long long num_tokens = 0;
+    double wall_time = 0;
+    for (int i = 0; i < runs; i++) {
+        YY_BUFFER_STATE buffer =
+            yy_scan_bytes(input.data(), input.size(), scanner);
+        yyset_extra(0, scanner);
+        num_tokens = 0;
+
+        double start = now();
+        if (counters) counters->start();
+        while (yylex(&value, &location, scanner) != 0) num_tokens++;
+        if (counters) counters->stop();
+        wall_time += now() - start;
+
+        yy_delete_buffer(buffer, scanner);
+    }
+    yylex_destroy(scanner);
+
+    report("scanner", "token", runs, num_tokens, wall_time, counters);
+    return 0;
+}
+
+/**
+ * Benchmarks the hand-written scanner on the standard input. Like the flex
+ * scanner, it is not asked for line and column numbers.
+ *
+ * @param runs
+ *        Number of runs.
+ * @param counters
+ *        Counters to use, or \c NULL.
+ * @returns Exit status.
+ */
+static int benchmarkFastScanner(int runs, PerfCounters* counters) {
+    string input = readStandardInput();
+
+    FastScanner scanner;
+    TokenBuffer tokens;
+    double wall_time = 0;
+    for (int i = 0; i < runs; i++) {
+        double start = now();
+        if (counters) counters->start();
+        scanner.scan(input.data(), input.size(), &tokens);
+        if (counters) counters->stop();
+        wall_time += now() - start;
+    }
+
+    report("fast scanner", "token", runs, tokens.getNumTokens(), wall_time,
+           counters);
+    return 0;
+}
+
+/**
+ * Benchmarks the traversal of the AST of the standard input, first through
+ * the virtual IVisitor interface and then with a StaticVisitor. The input is
+ * parsed once with the FastParser, outside of the measured regions.
+ *
+ * @param runs
+ *        Number of runs.
+ * @param counters
+ *        Counters to use, or \c NULL.
+ * @returns Exit status.
+ */
+static int benchmarkTraversal(int runs, PerfCounters* counters) {
+    Reporter& out = *Reporter::getInstance();
+    string input = readStandardInput();
+
+    FastScanner scanner;
+    TokenBuffer tokens;
+    ParseContext context;
+    context.setSource(input.data(), input.size());
+    FastParser parser;
+    if (!scanner.scan(input.data(), input.size(), &tokens)
+        || !parser.parse(tokens, &context))
+    {
+        context.reportDiagnostics();
+        out << out.beginError() << "Failed to parse input" << out.endl();
+        return 1;
+    }
+    NProgram* program = context.getProgram();
+
+    DynamicNodeCounter dynamic_counter;
+    long long num_nodes = 0;
+    double wall_time = 0;
+    for (int i = 0; i < runs; i++) {
+        double start = now();
+        if (counters) counters->start();
+        num_nodes = dynamic_counter.count(program);
+        if (counters) counters->stop();
+        wall_time += now() - start;
+    }
+    report("dynamic traversal", "node", runs, num_nodes, wall_time, counters);
+
+    if (counters) counters->clear();
+    StaticNodeCounter static_counter;
+    wall_time = 0;
+    for (int i = 0; i < runs; i++) {
+        double start = now();
+        if (counters) counters->start();
+        num_nodes = static_counter.count(program);
+        if (counters) counters->stop();
+        wall_time += now() - start;
+    }
+    report("static traversal", "node", runs, num_nodes, wall_time, counters);
+    return 0;
+}
+
+/**
+ * Gets the number of bytes currently allocated on the heap, including the
+ * blocks which were mapped separately.
+ *
+ * @returns Number of bytes.
+ */
+static long long heapInUse(void) {
+    struct mallinfo2 info = mallinfo2();
+    return static_cast<long long>(info.uordblks + info.hblkhd);
+}
+
+/**
+ * Benchmarks parsing the standard input with the FastParser, first into a
+ * tree and then into a DAG in which identical expressions are shared. The
+ * input is scanned once, outside of the measured regions. The heap memory of
+ * an AST is what the last run has allocated, and includes the tables in
+ * which the shared expressions are looked up.
+ *
+ * @param runs
+ *        Number of runs.
+ * @param counters
+ *        Counters to use, or \c NULL.
+ * @returns Exit status.
+ */
+static int benchmarkAst(int runs, PerfCounters* counters) {
+    Reporter& out = *Reporter::getInstance();
+    string input = readStandardInput();
+
+    FastScanner scanner;
+    TokenBuffer tokens;
+    if (!scanner.scan(input.data(), input.size(), &tokens)) {
+        out << out.beginError() << "Failed to scan input" << out.endl();
+        return 1;
+    }
+
+    FastParser parser;
+    for (int sharing = 0; sharing < 2; sharing++) {
+        if (counters) counters->clear();
+        long long memory = 0;
+        double wall_time = 0;
+        for (int i = 0; i < runs; i++) {
+            long long heap = heapInUse();
+            ParseContext* context = new ParseContext();
+            context->setSource(input.data(), input.size());
+            context->getExpressionFactory()->setSharing(sharing != 0);
+
+            double start = now();
+            if (counters) counters->start();
+            bool parsed = parser.parse(tokens, context);
+            if (counters) counters->stop();
+            wall_time += now() - start;
+
+            memory = heapInUse() - heap;
+            if (!parsed) {
+                context->reportDiagnostics();
+                out << out.beginError() << "Failed to parse input"
+                    << out.endl();
+                delete context;
+                return 1;
+            }
+            delete context;
+        }
+        report(sharing ? "dag parse" : "tree parse", "token", runs,
+               tokens.getNumTokens(), wall_time, counters);
+        stringstream ss;
+        ss << fixed << setprecision(1) << memory / (1024.0 * 1024.0);
+        out << "  AST heap memory (MB): " << ss.str() << out.endl();
+    }
+    return 0;
+}
+
+/**
+ * Interns the identifiers of an InternTask.
+ *
+ * @param task
+ *        Task.
+ * @returns \c NULL.
+ */
+static void* runInternTask(void* task) {
+    InternTask* t = static_cast<InternTask*>(task);
+    for (size_t i = t->begin; i < t->end; i++) {
+        t->symtab->intern((*t->names)[i], 0);
+    }
+    return NULL;
+}
+
+/**
+ * Benchmarks interning the identifiers of the standard input, first into a
+ * SymbolTable and then into a ConcurrentSymbolTable shared by a number of
+ * threads, each of which takes an equal share of the identifiers in source
+ * order. The input is scanned once with the FastScanner, outside of the
+ * measured regions.
+ *
+ * @param runs
+ *        Number of runs.
+ * @param num_threads
+ *        Number of threads.
+ * @param counters
+ *        Counters to use, or \c NULL.
+ * @returns Exit status.
+ */
+static int benchmarkSymbolTable(
+    int runs,
+    unsigned int num_threads,
+    PerfCounters* counters)
+{
+    Reporter& out = *Reporter::getInstance();
+    string input = readStandardInput();
+
+    FastScanner scanner;
+    TokenBuffer tokens;
+    if (!scanner.scan(input.data(), input.size(), &tokens)) {
+        out << out.beginError() << "Failed to scan input" << out.endl();
+        return 1;
+    }
+    vector<TextSpan> names;
+    for (unsigned int i = 0; i < tokens.getNumTokens(); i++) {
+        if (tokens.getKind(i) == TokenBuffer::IDENTIFIER) {
+            names.push_back(TextSpan(tokens.getTextPointer(i),
+                                     tokens.getLength(i)));
+        }
+    }
+
+    SymbolTable symtab;
+    double wall_time = 0;
+    for (int i = 0; i < runs; i++) {
+        symtab.clear();
+        double start = now();
+        if (counters) counters->start();
+        for (size_t j = 0; j < names.size(); j++) {
+            if (symtab.getSymbol(names[j]) < 0) symtab.insert(names[j], 0);
+        }
+        if (counters) counters->stop();
+        wall_time += now() - start;
+    }
+    report("symbol table", "identifier", runs, names.size(), wall_time,
+           counters);
+
+    // The calling thread takes the first share
+    ConcurrentSymbolTable shared;
+    vector<InternTask> tasks(num_threads);
+    for (unsigned int i = 0; i < num_threads; i++) {
+        tasks[i].symtab = &shared;
+        tasks[i].names = &names;
+        tasks[i].begin = names.size() * i / num_threads;
+        tasks[i].end = names.size() * (i + 1) / num_threads;
+    }
+    wall_time = 0;
+    for (int i = 0; i < runs; i++) {
+        shared.clear();
+        double start = now();
+        vector<pthread_t> threads;
+        for (unsigned int j = 1; j < num_threads; j++) {
+            pthread_t thread;
+            if (pthread_create(&thread, NULL, runInternTask, &tasks[j]) != 0) {
+                out << out.beginError() << "Failed to create thread"
+                    << out.endl();
+                return 1;
+            }
+            threads.push_back(thread);
+        }
+        runInternTask(&tasks[0]);
+        for (size_t j = 0; j < threads.size(); j++) {
+            pthread_join(threads[j], NULL);
+        }
+        wall_time += now() - start;
+    }
+    if (shared.getNumRecords() != symtab.getNumRecords()) {
+        out << out.beginError() << "Concurrent symbol table has "
+            << shared.getNumRecords() << " records instead of "
+            << symtab.getNumRecords() << out.endl();
+        return 1;
+    }
+    stringstream region;
+    region << "concurrent symbol table (" << num_threads << " threads)";
+    report(region.str(), "identifier", runs, names.size(), wall_time, NULL);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    Reporter& out = *Reporter::getInstance();
+
+    // Parse command-line
+    bool use_counters = false;
+    string region;
+    string program_file;
+    int runs = 1;
+    long num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (num_threads < 1) num_threads = 1;
+    for (int i = 1; i < argc; i++) {
+        string option(argv[i]);
+        if (option == "-h" || option == "--help") {
+            out << "Usage: " << argv[0] << " [-h] [--help] [--counters]"
+                << " [--runs N] [--threads N] (--vm PROGRAM_FILE"
+                << " | --scanner < INPUT_FILE | --fast-scanner < INPUT_FILE"
+                << " | --traversal < INPUT_FILE | --ast < INPUT_FILE"
+                << " | --symbol-table < INPUT_FILE)" << out.endl();
+            return 0;
+        }
+        else if (option == "--counters") {
+            use_counters = true;
+        }
+        else if (option == "--runs" && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        }
+        else if (option == "--threads" && i + 1 < argc) {
+            num_threads = atoi(argv[++i]);
+        }
+        else if (option == "--vm" && i + 1 < argc && region.empty()) {
+            region = option;
+            program_file = argv[++i];
+        }
+        else if ((option == "--scanner" || option == "--fast-scanner"
+                  || option == "--traversal" || option == "--ast"
+                  || option == "--symbol-table")
+                 && region.empty())
+        {
+            region = option;
+        }
+        else {
+            out << out.beginError() << "Invalid option. Use \"-h\" for help."
+                << out.endl();
+            return 1;
+        }
+    }
+    if (region.empty() || runs < 1 || num_threads < 1) {
+        out << out.beginError() << "Invalid option. Use \"-h\" for help."
+            << out.endl();
+        return 1;
+    }
+
+    PerfCounters* counters = use_counters ? new PerfCounters() : NULL;
+    int status;
+    if (region == "--vm") {
+        status = benchmarkVM(program_file, runs, counters);
+    }
+    else if (region == "--scanner") {
+        status = benchmarkScanner(runs, counters);
+    }
+    else if (region == "--fast-scanner") {
+        status = benchmarkFastScanner(runs, counters);
+    }
+    else if (region == "--traversal") {
+        status = benchmarkTraversal(runs, counters);
+    }
+    else if (region == "--ast") {
+        status = benchmarkAst(runs, counters);
+    }
+    else {
+        status = benchmarkSymbolTable(runs, num_threads, counters);
+    }
+    delete counters;
+
+    return status;
+}
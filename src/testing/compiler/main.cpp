@@ -25,20 +25,56 @@
 
 /*
  * USE: For testing the compiler. It reads a program file from the standard
- * input, and compiles the code.
+ * input, and compiles the code. The input is mapped into memory and scanned
+ * with the FastScanner, and the AST refers directly into it. The tokens are
+ * parsed by bison, or with "--frontend=fast" by the hand-written FastParser.
+ * With "--frontend=parallel", the input is instead cut into chunks which are
+ * scanned and parsed on "-j" threads (by default one per processor), which
+ * then also look up the variables of the pointer-based AST in a shared symbol
+ * table if there are several. With
+ * "--frontend=push", the input is read piece by piece and pushed to the bison
+ * parser, and every statement is checked and compiled as soon as it has been
+ * parsed. The symbol table is built, the declarations are checked and the code
+ * is generated in one traversal of the AST. With "--ast=flat", the parser or
+ * the cache produces a FlatAst instead, and the symbol table is built and the
+ * code is generated in one linear pass each. Only bison builds the
+ * pointer-based AST first, which is released once it has been converted. With
+ * "--ast=dag", identical expressions are shared as they are parsed, unless
+ * "-g" is given, as a shared expression has only one source location. With
+ * "--cache", the AST and symbol table of the input are loaded from a cache
+ * directory if the same input has been compiled before, and are stored there
+ * otherwise, unless expressions were shared. With "-g", a line table mapping
+ * the code back to the source lines is also written. Variables whose live
+ * ranges do not overlap share a memory location.
+ *
+ * The fixture "shared_expression_lines.i" repeats an expression on several
+ * lines. Compiled with "--ast=dag --cache=DIR" and then with "--cache=DIR -g",
+ * it must give the same line table as without the cache.
  *
  * @author Gabriel Hjort Blindell <ghb@kth.se>
  */
 
 #include "../../ast/ast.hpp"
+#include "../../ast/flat_ast.hpp"
+#include "../../cache/parse_cache.hpp"
 #include "../../generator/code_generator.hpp"
+#include "../../grammar/fast_lexer.hpp"
+#include "../../grammar/fast_parser.hpp"
+#include "../../grammar/parallel_parser.hpp"
+#include "../../grammar/push_parser.hpp"
 #include "../../io/file_writer.hpp"
+#include "../../io/mapped_file.hpp"
 #include "../../io/reporter.hpp"
+#include "../../symtab/memory_allocator.hpp"
+#include "../../symtab/parallel_symbol_table_builder.hpp"
 #include "../../symtab/symbol_table_builder.hpp"
 #include "../../grammar/common.hpp" // Must be included before "parser.tab.h"
 #include "../../grammar/parser.tab.h"
+#include <cerrno>
+#include <cstdlib>
 #include <ios>
 #include <string>
+#include <unistd.h>
 #include <vector>
 
 using namespace AST;
@@ -47,76 +83,273 @@ using std::string;
 using std::stringstream;
 using std::vector;
 
-// Declare the function which will invoke the parser to read the input and build
-// the AST
-extern int yyparse(void);
+/**
+ * Implements a parse context which builds the symbol table and generates the
+ * code of every statement as soon as it has been parsed, in one traversal of
+ * the statement. Semantic errors are kept until the parse is done, as a syntax
+ * error is to be reported first.
+ */
+class CompilingContext : public ParseContext {
+  public:
+    CompilingContext(LineTable* lines) {
+        // The newline index grows as the input is pushed to the parser
+        _generator.beginCompiling(&_symtab, &getNewlineIndex(), lines);
+    }
+
+    virtual void addStatement(NStatement* statement) {
+        if (!_error.empty()) return;
+        try {
+            _generator.addStatement(statement);
+        }
+        catch (NodeError& ex) {
+            _error = ex.what();
+        }
+    }
+
+    const string& getError(void) const {
+        return _error;
+    }
 
-// Declare the global variable which will hold the output from the parser once
-// it has finished parsing
-extern NProgram* g_program;
+    void finish(vector<char>* code) {
+        _generator.finish(code);
+    }
+
+  private:
+    SymbolTable _symtab;
+    CodeGenerator _generator;
+    string _error;
+};
 
 int main(int argc, char** argv) {
     Reporter& out = *Reporter::getInstance();
 
-    // Check command-line
-    if (argc > 3) {
-        out << out.beginError() << "Too many arguments. Use \"-h\" for help."
-            << out.endl();
+    // Parse command-line
+    string output_file = "program.o";
+    string line_table_file;
+    string frontend = "bison";
+    string representation = "tree";
+    string cache_directory;
+    int num_threads = 0;
+    for (int i = 1; i < argc; i++) {
+        string option(argv[i]);
+        if (option == "-h" || option == "--help") {
+            out << "Usage: " << argv[0] << " [-h] [--help] [-o OUTPUT_FILE]"
+                << " [-g LINE_TABLE_FILE] [--frontend=bison|fast|parallel|push]"
+                << " [--ast=tree|flat|dag] [--cache=DIRECTORY] [-j THREADS]"
+                << " < INPUT_FILE"
+                << out.endl();
+            return 0;
+        }
+        else if (option == "-o" && i + 1 < argc) {
+            output_file = string(argv[++i]);
+        }
+        else if (option == "-g" && i + 1 < argc) {
+            line_table_file = string(argv[++i]);
+        }
+        else if (option == "--frontend=bison"
+                 || option == "--frontend=fast"
+                 || option == "--frontend=parallel"
+                 || option == "--frontend=push")
+        {
+            frontend = option.substr(option.find('=') + 1);
+        }
+        else if (option == "--ast=tree"
+                 || option == "--ast=flat"
+                 || option == "--ast=dag")
+        {
+            representation = option.substr(option.find('=') + 1);
+        }
+        else if (option.compare(0, 8, "--cache=") == 0
+                 && option.size() > 8)
+        {
+            cache_directory = option.substr(8);
+        }
+        else if (option == "-j" && i + 1 < argc) {
+            num_threads = atoi(argv[++i]);
+            if (num_threads <= 0) {
+                out << out.beginError() << "Invalid number of threads"
+                    << out.endl();
+                return 1;
+            }
+        }
+        else {
+            out << out.beginError() << "Invalid option. Use \"-h\" for help."
+                << out.endl();
+            return 1;
+        }
+    }
+
+    if (frontend == "push" && representation == "flat") {
+        out << out.beginError() << "The push frontend compiles every statement"
+            << " as it is parsed, and cannot use the flat AST" << out.endl();
+        return 1;
+    }
+    if (frontend == "push" && !cache_directory.empty()) {
+        out << out.beginError() << "The push frontend compiles every statement"
+            << " as it is parsed, and cannot use the cache" << out.endl();
         return 1;
     }
 
-    // Parse command-line
-    bool default_output_file = true;
-    string output_file;
-    if (argc > 1) {
-        bool has_error = false;
-        string option(argv[1]);
-        if (option[0] == '-') {
-            if (option == "-h" || option == "--help") {
-                out << "Usage: " << argv[0] << " [-h] [--help] [-o OUTPUT_FILE]"
-                    << " < INPUT_FILE" << out.endl();
-                return 0;
+    vector<char> code;
+    LineTable lines;
+    LineTable* line_table = line_table_file.empty() ? NULL : &lines;
+
+    // A shared expression has the location of its first use only, which
+    // would be wrong in the line table of every other use
+    bool sharing = representation == "dag" && !line_table;
+    if (frontend == "push") {
+        // Compile the input while it is read (CTRL-d indicates end of input)
+        CompilingContext context(line_table);
+        context.getExpressionFactory()->setSharing(sharing);
+        PushParser parser(&context);
+        char buffer[65536];
+        for (;;) {
+            ssize_t size = read(STDIN_FILENO, buffer, sizeof(buffer));
+            if (size < 0 && errno == EINTR) continue;
+            if (size < 0) {
+                out << out.beginError() << "Failed to read input"
+                    << out.endl();
+                return 1;
             }
-            else if (option == "-o") {
-                if (argc == 3) {
-                    output_file = string(argv[2]);
-                    default_output_file = false;
-                }
-                else {
-                    has_error = true;
-                }
+            if (size == 0 || !parser.push(buffer, size)) break;
+        }
+        bool parsed = parser.finish();
+        context.reportDiagnostics();
+        if (!parsed) return 0;
+        if (!context.getError().empty()) {
+            out << out.beginError() << context.getError() << out.endl();
+            return 0;
+        }
+        context.finish(&code);
+    }
+    else {
+        // Read input and build AST (CTRL-d indicates end of input). The input
+        // must be kept open for as long as the AST is used
+        MappedFile input;
+        try {
+            input.openStandardInput();
+        }
+        catch (ios_base::failure) {
+            out << out.beginError() << "Failed to read input" << out.endl();
+            return 1;
+        }
+        ParseContext context;
+        context.setSource(input.getData(), input.getSize());
+        context.getExpressionFactory()->setSharing(sharing);
+
+        // A cached AST and symbol table replace parsing and building the
+        // symbol table
+        bool flat = representation == "flat";
+        FlatAst flat_ast;
+        ParseCache cache(cache_directory);
+        uint64_t key = 0;
+        SymbolTable symtab;
+        bool cached = false;
+        if (!cache_directory.empty()) {
+            key = ParseCache::hashSource(input.getData(), input.getSize());
+            cached = flat
+                ? cache.load(key, input.getSize(), &context, &flat_ast,
+                             &symtab)
+                : cache.load(key, input.getSize(), &context, &symtab);
+        }
+
+        bool parsed = true;
+        if (cached) {
+            // Nothing to parse
+        }
+        else if (frontend == "parallel") {
+            ParallelParser parser(num_threads);
+            parsed = flat
+                ? parser.parse(input.getData(), input.getSize(), &flat_ast,
+                               &context)
+                : parser.parse(input.getData(), input.getSize(), &context);
+        }
+        else {
+            FastScanner scanner;
+            TokenBuffer tokens;
+            if (!scanner.scan(input.getData(), input.getSize(), &tokens)) {
+                out << out.beginError() << "Input is too large" << out.endl();
+                return 1;
+            }
+            if (frontend == "fast") {
+                FastParser parser;
+                parsed = flat ? parser.parse(tokens, &flat_ast, &context)
+                              : parser.parse(tokens, &context);
             }
             else {
-                has_error = true;
+                FastLexer lexer(&tokens);
+                parsed = yyparse(&lexer, &context) == 0;
+
+                // Bison only builds the pointer-based AST, which is not
+                // needed once it has been converted
+                if (parsed && flat) {
+                    flat_ast.build(context.getProgram());
+                    context.releaseProgram();
+                }
+            }
+        }
+        context.reportDiagnostics();
+        if (!parsed) return 0;
+        NProgram* program = context.getProgram();
+
+        // Build symbol table and check variable declarations, unless it was
+        // cached, share memory locations between the variables and generate
+        // code. The parallel frontend builds the symbol table on its threads,
+        // which only pays off with more than one
+        const NewlineIndex& newlines = context.getNewlineIndex();
+        bool resolved = cached;
+        ParallelSymbolTableBuilder parallel_builder(num_threads);
+        if (!cached && !flat && frontend == "parallel"
+            && parallel_builder.getNumThreads() > 1)
+        {
+            if (!parallel_builder.build(program, &symtab, &newlines)) {
+                return 0;
             }
+            resolved = true;
+        }
+        SymbolTableBuilder symtab_builder;
+        MemoryAllocator allocator;
+        CodeGenerator generator;
+        bool result;
+        if (flat) {
+            result = resolved
+                || symtab_builder.build(&flat_ast, &symtab, &newlines);
+            if (!result) return 0;
+            allocator.allocate(flat_ast, &symtab);
+            result = generator.generate(flat_ast, &symtab, &newlines, &code,
+                                        line_table);
+        }
+        else if (resolved) {
+            // The variables are resolved already
+            allocator.allocate(program, &symtab);
+            result = generator.generate(program, &symtab, &newlines, &code,
+                                        line_table);
         }
         else {
-            has_error = true;
+            result = generator.compile(program, &symtab, &newlines, &code,
+                                       line_table);
         }
+        if (!result) return 0;
 
-        if (has_error) {
-            out << out.beginError() << "Invalid option. Use \"-h\" for help."
-                << out.endl();
-            return 1;
+        // Only programs which compile are cached. A shared expression has the
+        // location of its first use only, which a later compile with "-g"
+        // would put in its line table, so a DAG is not cached
+        if (!cache_directory.empty() && !cached && !sharing) {
+            try {
+                if (flat) {
+                    cache.store(key, input.getSize(), flat_ast, symtab);
+                }
+                else {
+                    cache.store(key, input.getSize(), program, symtab);
+                }
+            }
+            catch (ios_base::failure) {
+                // The code is still written
+                out << out.beginError() << "Failed to write to the cache"
+                    << out.endl();
+            }
         }
     }
-    if (default_output_file) output_file = "program.o";
-
-    // Read input and build AST (CTRL-d indicates end of input)
-    yyparse();
-    if (!g_program) return 0;
-
-    // Build symbol table and check variable declarations
-    SymbolTable symtab;
-    SymbolTableBuilder symtab_builder;
-    bool result = symtab_builder.build(g_program, &symtab);
-    if (!result) return 0;
-
-    // Generate code
-    CodeGenerator generator;
-    vector<char> code;
-    result = generator.generate(g_program, &symtab, &code);
-    if (!result) return 0;
 
     // Write to file
     FileWriter writer;
@@ -136,8 +369,19 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    // Clean up
-    delete g_program;
+    // Write line table
+    if (!line_table_file.empty()) {
+        FileWriter line_writer;
+        try {
+            line_writer.open(line_table_file);
+            line_writer << lines.toString();
+        }
+        catch (ios_base::failure) {
+            out << out.beginError() << "Failed to write line table file"
+                << out.endl();
+            return 1;
+        }
+    }
 
     return 0;
 }
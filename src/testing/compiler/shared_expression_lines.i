@@ -0,0 +1,2 @@
+a = 1; b = a + 2; c = a +
+ 2; print a + 2;
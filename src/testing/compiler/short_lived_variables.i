@@ -0,0 +1,11 @@
+width = 12;
+height = 5;
+area = width * height;
+print area;
+half = area / 2;
+depth = 3;
+volume = half * depth;
+unused = volume + 1;
+print volume - height;
+total = volume + width;
+print total;
@@ -0,0 +1,256 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * USE: For testing the concurrent symbol table. A number of threads intern
+ * overlapping sets of names into one ConcurrentSymbolTable, each in its own
+ * order, and look the names up again while the other threads still insert.
+ * Afterwards, every name must have exactly one symbol id, the ids must be
+ * dense, and every thread must have seen the same id for a name as the table
+ * holds. "OK" is printed if so, and the first inconsistency otherwise. The
+ * number of threads, names and rounds can be given on the command line.
+ */
+
+#include "../../io/reporter.hpp"
+#include "../../symtab/concurrent_symbol_table.hpp"
+#include <cstdlib>
+#include <pthread.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::stringstream;
+using std::vector;
+
+/**
+ * Names interned by a thread, and what it saw of them.
+ */
+struct InternTask {
+    /**
+     * Shared symbol table.
+     */
+    ConcurrentSymbolTable* symtab;
+
+    /**
+     * All names.
+     */
+    const vector<string>* names;
+
+    /**
+     * Index of the thread, which determines the names and their order.
+     */
+    unsigned int index;
+
+    /**
+     * Number of threads.
+     */
+    unsigned int num_threads;
+
+    /**
+     * Symbol id returned for each name, or -1 if the thread did not intern
+     * it.
+     */
+    vector<int> symbols;
+
+    /**
+     * Number of lookups which did not find a name just interned by the
+     * thread, or found it under another id.
+     */
+    size_t num_mismatches;
+};
+
+/**
+ * Interns every name except those whose index modulo the number of threads
+ * plus one is the index of the thread, so that each name is interned by all
+ * threads but at most one. Even threads go forwards and odd threads go
+ * backwards. After each insertion, an earlier name of the thread is looked
+ * up again.
+ *
+ * @param task
+ *        InternTask.
+ * @returns \c NULL.
+ */
+static void* runInternTask(void* task) {
+    InternTask& t = *static_cast<InternTask*>(task);
+    size_t num_names = t.names->size();
+    t.symbols.assign(num_names, -1);
+    t.num_mismatches = 0;
+    size_t previous = num_names;
+    for (size_t k = 0; k < num_names; k++) {
+        size_t i = t.index % 2 == 0 ? k : num_names - 1 - k;
+        if (t.num_threads > 1 && i % (t.num_threads + 1) == t.index) {
+            continue;
+        }
+        const string& name = (*t.names)[i];
+        t.symbols[i] = t.symtab->intern(TextSpan(name), i);
+        if (previous < num_names) {
+            const string& earlier = (*t.names)[previous];
+            if (t.symtab->getSymbol(TextSpan(earlier)) != t.symbols[previous]) {
+                t.num_mismatches++;
+            }
+        }
+        previous = i;
+    }
+    return NULL;
+}
+
+/**
+ * Checks the symbol table after all threads have interned their names.
+ *
+ * @param symtab
+ *        Symbol table.
+ * @param tasks
+ *        Finished tasks.
+ * @param error
+ *        Destination of a description of the first inconsistency.
+ * @returns \c true if the symbol table is consistent.
+ */
+static bool check(
+    const ConcurrentSymbolTable& symtab,
+    const vector<InternTask>& tasks,
+    string* error)
+{
+    const vector<string>& names = *tasks[0].names;
+    stringstream ss;
+
+    // Every name is interned by some thread, so the ids are exactly 0 to the
+    // number of names
+    if (symtab.getNumRecords() != names.size()) {
+        ss << symtab.getNumRecords() << " records for " << names.size()
+           << " names";
+        *error = ss.str();
+        return false;
+    }
+    vector<bool> used(names.size(), false);
+    for (size_t i = 0; i < names.size(); i++) {
+        int symbol = symtab.getSymbol(TextSpan(names[i]));
+        if (symbol < 0 || static_cast<size_t>(symbol) >= names.size()) {
+            ss << "\"" << names[i] << "\" has symbol id " << symbol;
+            *error = ss.str();
+            return false;
+        }
+        if (used[symbol]) {
+            ss << "Symbol id " << symbol << " is used twice";
+            *error = ss.str();
+            return false;
+        }
+        used[symbol] = true;
+
+        const ConcurrentSymbolTable::Record* record =
+            symtab.getRecord(symbol);
+        if (record->getName() != TextSpan(names[i])
+            || record->getMemoryIndex() != symbol)
+        {
+            ss << "Record " << symbol << " does not belong to \""
+               << names[i] << "\"";
+            *error = ss.str();
+            return false;
+        }
+
+        for (size_t j = 0; j < tasks.size(); j++) {
+            int seen = tasks[j].symbols[i];
+            if (seen >= 0 && seen != symbol) {
+                ss << "Thread " << j << " got symbol id " << seen
+                   << " for \"" << names[i] << "\" instead of " << symbol;
+                *error = ss.str();
+                return false;
+            }
+        }
+    }
+    for (size_t j = 0; j < tasks.size(); j++) {
+        if (tasks[j].num_mismatches > 0) {
+            ss << "Thread " << j << " looked up " << tasks[j].num_mismatches
+               << " name(s) under the wrong symbol id";
+            *error = ss.str();
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    Reporter& out = *Reporter::getInstance();
+
+    // Parse command-line
+    if (argc > 4) {
+        out << "Usage: " << argv[0] << " [THREADS [NAMES [ROUNDS]]]"
+            << out.endl();
+        return 1;
+    }
+    int num_threads = argc > 1 ? atoi(argv[1]) : 8;
+    int num_names = argc > 2 ? atoi(argv[2]) : 100000;
+    int num_rounds = argc > 3 ? atoi(argv[3]) : 10;
+    if (num_threads <= 0 || num_names <= 0 || num_rounds <= 0) {
+        out << out.beginError() << "Invalid argument" << out.endl();
+        return 1;
+    }
+
+    // Names of different lengths, which share prefixes
+    vector<string> names;
+    for (int i = 0; i < num_names; i++) {
+        stringstream ss;
+        ss << "v" << i << string(i % 7, 'x');
+        names.push_back(ss.str());
+    }
+
+    // The table is cleared between the rounds, which must not disturb it
+    ConcurrentSymbolTable symtab;
+    vector<InternTask> tasks(num_threads);
+    for (int round = 0; round < num_rounds; round++) {
+        symtab.clear();
+        for (int i = 0; i < num_threads; i++) {
+            tasks[i].symtab = &symtab;
+            tasks[i].names = &names;
+            tasks[i].index = i;
+            tasks[i].num_threads = num_threads;
+        }
+
+        // The calling thread runs the first task
+        vector<pthread_t> threads;
+        for (int i = 1; i < num_threads; i++) {
+            pthread_t thread;
+            if (pthread_create(&thread, NULL, runInternTask, &tasks[i]) != 0) {
+                out << out.beginError() << "Failed to create thread"
+                    << out.endl();
+                return 1;
+            }
+            threads.push_back(thread);
+        }
+        runInternTask(&tasks[0]);
+        for (size_t i = 0; i < threads.size(); i++) {
+            pthread_join(threads[i], NULL);
+        }
+
+        string error;
+        if (!check(symtab, tasks, &error)) {
+            out << out.beginError() << "Round " << round + 1 << ": " << error
+                << out.endl();
+            return 1;
+        }
+    }
+    out << "OK" << out.endl();
+    return 0;
+}
@@ -26,31 +26,34 @@
 /*
  * USE: For testing the parser. It reads from the standard input and passes it
  * to the parser, which will convert the input into an AST. The AST will then
- * be printed to the standard output using a pretty-printing visitor.
+ * be printed to the standard output using a pretty-printing visitor. With
+ * "--frontend=fast", the hand-written scanner and parser are used instead of
+ * flex and bison. "--frontend=parallel" uses them through the ParallelParser,
+ * with chunks made as small as possible so that every statement is parsed
+ * separately.
  */
 
 #include "../../grammar/common.hpp" // Must be included before "parser.tab.h"
 #include "../../grammar/parser.tab.h"
+#include "../../grammar/lex.yy.h"
+#include "../../grammar/fast_parser.hpp"
+#include "../../grammar/parallel_parser.hpp"
+#include "../../io/mapped_file.hpp"
+#include <ios>
 #include <sstream>
 
+using std::ios_base;
 using std::string;
 using std::stringstream;
 
-// Declare the function which will invoke the parser to read the input and build
-// the AST
-extern int yyparse(void);
-
-// Declare the global variable which will hold the output from the parser once
-// it has finished parsing
-extern NProgram* g_program;
-
 /**
  * Implements a visitor which will traverse the entire AST and print it to
  * standard out in a "pretty-looking" fashion.
  */
 class AstPrettyPrinter : public DefaultVisitor {
   public:
-    AstPrettyPrinter(void) : _level(0), _out(*Reporter::getInstance()) {}
+    AstPrettyPrinter(const NewlineIndex& newlines)
+        : _level(0), _newlines(newlines), _out(*Reporter::getInstance()) {}
 
     void print(Node* node) {
         node->accept(this);
@@ -174,8 +177,10 @@ class AstPrettyPrinter : public DefaultVisitor {
     }
 
     string location(Node* node) {
+        int line, column;
+        _newlines.lookUp(node->getOffset(), &line, &column);
         stringstream ss;
-        ss << node->getLine() << ":" << node->getColumn();
+        ss << line << ":" << column;
         return ss.str();
     }
 
@@ -194,30 +199,81 @@ class AstPrettyPrinter : public DefaultVisitor {
 
   private:
     int _level;
+    const NewlineIndex& _newlines;
     Reporter& _out;
 };
 
 const string AstPrettyPrinter::INDENT("  ");
 
 int main(int argc, char** argv) {
+    Reporter& out = *Reporter::getInstance();
+
     // Check command-line
-    if (argc > 1) {
-        Reporter& out = *Reporter::getInstance();
-        out << out.beginError() << "This program takes no arguments. Try "
-            << argv[0] << " < " << argv[1] << " instead." << out.endl();
-        return 1;
+    string frontend = "bison";
+    for (int i = 1; i < argc; i++) {
+        string option(argv[i]);
+        if (option == "-h" || option == "--help") {
+            out << "Usage: " << argv[0] << " [-h] [--help]"
+                << " [--frontend=bison|fast|parallel] < INPUT_FILE"
+                << out.endl();
+            return 0;
+        }
+        else if (option == "--frontend=bison"
+                 || option == "--frontend=fast"
+                 || option == "--frontend=parallel")
+        {
+            frontend = option.substr(option.find('=') + 1);
+        }
+        else {
+            out << out.beginError() << "Invalid option. Try " << argv[0]
+                << " < " << argv[i] << " instead." << out.endl();
+            return 1;
+        }
     }
 
-    // Read input and produce AST (CTRL-d indicates end of input)
-    yyparse();
-    if (!g_program) return 0;
+    // Read input and produce AST (CTRL-d indicates end of input). Nothing is
+    // printed for input with a syntax error
+    ParseContext context;
+    bool parsed;
+    MappedFile input;
+    TokenBuffer tokens;
+    try {
+        input.openStandardInput();
+    }
+    catch (ios_base::failure) {
+        out << out.beginError() << "Failed to read input" << out.endl();
+        return 1;
+    }
+    context.setSource(input.getData(), input.getSize());
+    if (frontend == "fast") {
+        FastScanner scanner;
+        scanner.scan(input.getData(), input.getSize(), &tokens);
+        FastParser parser;
+        parsed = parser.parse(tokens, &context);
+    }
+    else if (frontend == "parallel") {
+        ParallelParser parser(0, 1);
+        parsed = parser.parse(input.getData(), input.getSize(), &context);
+    }
+    else {
+        yyscan_t scanner;
+        if (yylex_init(&scanner) != 0) {
+            out << out.beginError() << "Failed to create scanner"
+                << out.endl();
+            return 1;
+        }
+        YY_BUFFER_STATE buffer =
+            yy_scan_bytes(input.getData(), input.getSize(), scanner);
+        parsed = yyparse(scanner, &context) == 0;
+        yy_delete_buffer(buffer, scanner);
+        yylex_destroy(scanner);
+    }
+    context.reportDiagnostics();
+    if (!parsed) return 0;
 
     // Print AST
-    AstPrettyPrinter printer;
-    printer.print(g_program);
-
-    // Clean up
-    delete g_program;
+    AstPrettyPrinter printer(context.getNewlineIndex());
+    printer.print(context.getProgram());
 
     return 0;
 }
@@ -32,14 +32,15 @@
 #include "../../grammar/common.hpp" // Must be included before "parser.tab.h"
 #include "../../grammar/parser.tab.h"
 #include "../../grammar/lex.yy.h"
+#include "../../grammar/newline_index.hpp"
+#include "../../io/mapped_file.hpp"
 #include "../../io/reporter.hpp"
+#include <ios>
 #include <string>
 
+using std::ios_base;
 using std::string;
 
-YYSTYPE yylval;
-YYLTYPE yylloc;
-
 int main(int argc, char** argv) {
     Reporter& out = *Reporter::getInstance();
 
@@ -50,13 +51,37 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    // Read input (CTRL-d indicates end of input)
+    // Read input (CTRL-d indicates end of input). The scanner only gives the
+    // source offset of a token, which is located with a newline index
+    MappedFile input;
+    try {
+        input.openStandardInput();
+    }
+    catch (ios_base::failure) {
+        out << out.beginError() << "Failed to read input" << out.endl();
+        return 1;
+    }
+    NewlineIndex newlines;
+    newlines.build(input.getData(), input.getSize());
+
+    yyscan_t scanner;
+    if (yylex_init(&scanner) != 0) {
+        out << out.beginError() << "Failed to create scanner" << out.endl();
+        return 1;
+    }
+    yy_scan_bytes(input.getData(), input.getSize(), scanner);
+
+    YYSTYPE yylval;
+    YYLTYPE yylloc;
     int token;
-    while ((token = yylex(&yylval, &yylloc)) != 0) {
+    while ((token = yylex(&yylval, &yylloc, scanner)) != 0) {
         switch (token) {
             case T_IDENTIFIER: {
-                string value(yylval.token_string);
-                if (value == "quit" || value == "exit") return 0;
+                string value(yylval.token_text.data, yylval.token_text.length);
+                if (value == "quit" || value == "exit") {
+                    yylex_destroy(scanner);
+                    return 0;
+                }
 
                 out << out.beginInfo() << "T_IDENTIFIER("
                     << value << ")" << out.endl();
@@ -64,7 +89,8 @@ int main(int argc, char** argv) {
             }
 
             case T_NUMBER: {
-                out << out.beginInfo() << "T_NUMBER(" << yylval.token_string
+                out << out.beginInfo() << "T_NUMBER("
+                    << string(yylval.token_text.data, yylval.token_text.length)
                     << ")" << out.endl();
                 break;
             }
@@ -115,10 +141,11 @@ int main(int argc, char** argv) {
             }
                 
             case T_UNKNOWN: {
+                int line, column;
+                newlines.lookUp(yylloc, &line, &column);
                 out << out.beginError() << "Unknown input \""
-                    << yylval.token_string << "\" at "
-                    << yylloc.first_line << ":" << yylloc.first_column
-                    << out.endl();
+                    << string(yylval.token_text.data, yylval.token_text.length)
+                    << "\" at " << line << ":" << column << out.endl();
                 break;
             }
 
@@ -128,6 +155,7 @@ int main(int argc, char** argv) {
             }
         }
     }
+    yylex_destroy(scanner);
 
     return 0;
 }
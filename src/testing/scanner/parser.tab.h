@@ -86,7 +86,7 @@ typedef union YYSTYPE
 /* Line 1676 of yacc.c  */
 #line 25 "grammar/parser.y"
 
-    char* token_string;
+    TokenText token_text;
 
 
 
@@ -100,18 +100,8 @@ typedef union YYSTYPE
 
 
 
-#if ! defined YYLTYPE && ! defined YYLTYPE_IS_DECLARED
-typedef struct YYLTYPE
-{
-  int first_line;
-  int first_column;
-  int last_line;
-  int last_column;
-} YYLTYPE;
-# define yyltype YYLTYPE /* obsolescent; will be withdrawn */
-# define YYLTYPE_IS_DECLARED 1
-# define YYLTYPE_IS_TRIVIAL 1
-#endif
+/* Location type.  */
+typedef unsigned int YYLTYPE;
 
 
 
@@ -0,0 +1,5 @@
+a = 1 $ 2;
+
+  print # x;
+	b@ = 3 ?
+?
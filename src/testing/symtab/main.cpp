@@ -34,21 +34,15 @@
 #include "../../symtab/symbol_table_builder.hpp"
 #include "../../grammar/common.hpp" // Must be included before "parser.tab.h"
 #include "../../grammar/parser.tab.h"
-#include <list>
+#include "../../grammar/lex.yy.h"
+#include "../../io/mapped_file.hpp"
+#include <ios>
 #include <string>
 
-using std::list;
+using std::ios_base;
 using std::string;
 using std::stringstream;
 
-// Declare the function which will invoke the parser to read the input and build
-// the AST
-extern int yyparse(void);
-
-// Declare the global variable which will hold the output from the parser once
-// it has finished parsing
-extern NProgram* g_program;
-
 int main(int argc, char** argv) {
     Reporter& out = *Reporter::getInstance();
 
@@ -60,8 +54,29 @@ int main(int argc, char** argv) {
     }
 
     // Read input and build AST (CTRL-d indicates end of input)
-    yyparse();
-    if (!g_program) return 0;
+    MappedFile input;
+    try {
+        input.openStandardInput();
+    }
+    catch (ios_base::failure) {
+        out << out.beginError() << "Failed to read input" << out.endl();
+        return 1;
+    }
+    yyscan_t scanner;
+    if (yylex_init(&scanner) != 0) {
+        out << out.beginError() << "Failed to create scanner" << out.endl();
+        return 1;
+    }
+    ParseContext context;
+    context.setSource(input.getData(), input.getSize());
+    YY_BUFFER_STATE buffer =
+        yy_scan_bytes(input.getData(), input.getSize(), scanner);
+    bool parsed = yyparse(scanner, &context) == 0;
+    yy_delete_buffer(buffer, scanner);
+    yylex_destroy(scanner);
+    context.reportDiagnostics();
+    NProgram* program = context.getProgram();
+    if (!parsed || !program) return 0;
 
     out << out.endl();
 
@@ -69,26 +84,23 @@ int main(int argc, char** argv) {
     out << out.beginInfo() << "Building symbol table...";
     SymbolTable symtab;
     SymbolTableBuilder symtab_builder;
-    bool result = symtab_builder.build(g_program, &symtab);
+    const NewlineIndex& newlines = context.getNewlineIndex();
+    bool result = symtab_builder.build(program, &symtab, &newlines);
     if (!result) return 0;
     out << "OK" << out.endl();
 
     // List all symbols
     out << out.endl();
-    list<SymbolTable::Record*> records = symtab.getRecords();
-    list<SymbolTable::Record*>::iterator it;
-    out << "SYMBOL TABLE RECORDS (in no particular order):" << out.endl();
-    for (it = records.begin(); it != records.end(); it++) {
-        SymbolTable::Record* record = *it;
+    out << "SYMBOL TABLE RECORDS (in order of declaration):" << out.endl();
+    for (size_t i = 0; i < symtab.getNumRecords(); i++) {
+        SymbolTable::Record* record = symtab.getRecord(i);
+        int line, column;
+        newlines.lookUp(record->getOffset(), &line, &column);
         out << " * Variable: " << record->getName() << ", "
-            << "Defined at: " << record->getLine() << ":" << record->getColumn()
-            << ", "
+            << "Defined at: " << line << ":" << column << ", "
             << "Memory index: " << record->getMemoryIndex()
             << out.endl();
     }
 
-    // Clean up
-    delete g_program;
-
     return 0;
 }
@@ -0,0 +1,180 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * USE: For reading execution traces. It accepts a trace file written by the
+ * virtual machine ("--trace") and prints one line per traced instruction. If
+ * the traced program file is also given, the instructions are printed with
+ * their constants as by the decoder.
+ */
+
+#include "../../decoder/disassembler.hpp"
+#include "../../generator/code_listing.hpp"
+#include "../../io/file_reader.hpp"
+#include "../../io/reporter.hpp"
+#include "../../vm/tracing_virtual_machine.hpp"
+#include <ios>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::ios_base;
+using std::string;
+using std::stringstream;
+using std::vector;
+
+/**
+ * Reads a big-endian \c int from a buffer.
+ *
+ * @param data
+ *        Buffer.
+ * @param offset
+ *        Offset of the first byte.
+ * @returns Value.
+ */
+static int readInt(const vector<char>& data, int offset) {
+    return (static_cast<unsigned char>(data[offset])     << 24)
+         | (static_cast<unsigned char>(data[offset + 1]) << 16)
+         | (static_cast<unsigned char>(data[offset + 2]) <<  8)
+         |  static_cast<unsigned char>(data[offset + 3]);
+}
+
+/**
+ * Reads an entire file.
+ *
+ * @param file
+ *        File path.
+ * @param dest
+ *        Destination vector.
+ * @returns \c true if the file was read.
+ */
+static bool readFile(const string& file, vector<char>* dest) {
+    FileReader reader;
+    try {
+        reader.open(file);
+        reader >> *dest;
+    }
+    catch (ios_base::failure) {
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    Reporter& out = *Reporter::getInstance();
+
+    // Parse command-line
+    vector<string> files;
+    for (int i = 1; i < argc; i++) {
+        string argument = argv[i];
+        if (argument == "-h" || argument == "--help") {
+            out << "Usage: " << argv[0] << " [-h] [--help] TRACE_FILE"
+                << " [PROGRAM_FILE]" << out.endl();
+            return 0;
+        }
+        else if (argument[0] == '-') {
+            out << out.beginError() << "Invalid option. Use \"-h\" for help."
+                << out.endl();
+            return 1;
+        }
+        files.push_back(argument);
+    }
+    if (files.empty()) {
+        out << out.beginError() << "Too few arguments. Use \"-h\" for help."
+            << out.endl();
+        return 1;
+    }
+    if (files.size() > 2) {
+        out << out.beginError() << "Too many arguments. Use \"-h\" for help."
+            << out.endl();
+        return 1;
+    }
+
+    // Read trace file
+    vector<char> trace;
+    if (!readFile(files[0], &trace)) {
+        out << out.beginError() << "Failed to read trace file" << out.endl();
+        return 1;
+    }
+    const int header_size = TracingVirtualMachine::HEADER_SIZE;
+    const int record_size = TracingVirtualMachine::RECORD_SIZE;
+    if (static_cast<int>(trace.size()) < header_size
+        || readInt(trace, 0) != TracingVirtualMachine::MAGIC_NUMBER)
+    {
+        out << out.beginError() << "Not a trace file" << out.endl();
+        return 1;
+    }
+    int num_records = readInt(trace, 4);
+    int num_dropped = readInt(trace, 8);
+    if (num_records < 0
+        || (static_cast<int>(trace.size()) - header_size) / record_size
+           < num_records)
+    {
+        out << out.beginError() << "Truncated trace file" << out.endl();
+        return 1;
+    }
+
+    // Disassemble program file
+    Disassembler disassembler;
+    if (files.size() > 1) {
+        vector<char> program;
+        if (!readFile(files[1], &program)) {
+            out << out.beginError() << "Failed to read program file"
+                << out.endl();
+            return 1;
+        }
+        disassembler.disassemble(program);
+    }
+
+    // Print trace
+    out << out.beginInfo() << "TRACE: " << num_records << " instruction(s)";
+    if (num_dropped > 0) out << ", " << num_dropped << " earlier not kept";
+    out << out.endl();
+    for (int i = 0; i < num_records; i++) {
+        int offset = header_size + i * record_size;
+        int pc = readInt(trace, offset);
+        char inst = trace[offset + 4];
+        int top = readInt(trace, offset + 5);
+
+        string text = disassembler.getInstruction(pc);
+        if (text.empty()) {
+            const char* name = CodeListing::getInstructionName(
+                static_cast<CodeListing::Instruction>(inst));
+            text = name ? name : "?";
+        }
+        stringstream ss;
+        ss.width(10);
+        ss << num_dropped + i;
+        ss << "  pc ";
+        ss.width(6);
+        ss << pc << ": ";
+        ss.setf(ios_base::left, ios_base::adjustfield);
+        ss.width(20);
+        ss << text << " top " << top;
+        out << out.beginInfo() << ss.str() << out.endl();
+    }
+
+    return 0;
+}
@@ -25,12 +25,27 @@
 
 /*
  * USE: For testing the virtual machine. It reads a given compiled program file,
- * and executes it.
+ * and executes it. With "--stats", execution statistics are printed as JSON
+ * once the program has terminated. With "--profile", the execution is sampled
+ * and written as folded stacks, attributed to source lines if the line table
+ * produced by the compiler is given. With "--ngrams", any number of programs
+ * are executed and a report of their opcode sequences is written. With
+ * "--trace", the most recently executed instructions are dumped to a binary
+ * trace file on errors, on SIGUSR1/SIGINT/SIGTERM, on fatal signals such as
+ * SIGFPE and SIGSEGV (but not SIGKILL or a stack overflow), and at the end of
+ * the program; "--trace-size" is the minimum number of instructions kept. See
+ * the trace test driver for reading it.
  */
 
 #include "../../io/file_reader.hpp"
+#include "../../io/file_writer.hpp"
 #include "../../io/reporter.hpp"
+#include "../../vm/ngram_virtual_machine.hpp"
+#include "../../vm/profiling_virtual_machine.hpp"
+#include "../../vm/statistics_virtual_machine.hpp"
+#include "../../vm/tracing_virtual_machine.hpp"
 #include "../../vm/virtual_machine.hpp"
+#include <cstdlib>
 #include <ios>
 #include <string>
 #include <vector>
@@ -39,61 +54,190 @@ using std::ios_base;
 using std::string;
 using std::vector;
 
-int main(int argc, char** argv) {
-    Reporter& out = *Reporter::getInstance();
+/**
+ * Reads an entire file.
+ *
+ * @param file
+ *        File path.
+ * @param dest
+ *        Destination vector.
+ * @returns \c true if the file was read.
+ */
+static bool readFile(const string& file, vector<char>* dest) {
+    FileReader reader;
+    try {
+        reader.open(file);
+        reader >> *dest;
+    }
+    catch (ios_base::failure) {
+        return false;
+    }
+    return true;
+}
 
-    // Check command-line
-    if (argc > 2) {
-        out << out.beginError() << "Too many arguments. Use \"-h\" for help."
-            << out.endl();
-        return 1;
+/**
+ * Writes a string to a file.
+ *
+ * @param file
+ *        File path.
+ * @param data
+ *        Data to write.
+ * @returns \c true if the file was written.
+ */
+static bool writeFile(const string& file, const string& data) {
+    FileWriter writer;
+    try {
+        writer.open(file);
+        writer << data;
     }
-    else if (argc < 2) {
-        out << out.beginError() << "Too few arguments. Use \"-h\" for help."
-            << out.endl();
-        return 1;
+    catch (ios_base::failure) {
+        return false;
     }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    Reporter& out = *Reporter::getInstance();
 
     // Parse command-line
-    string program_file;
-    if (argv[1][0] == '-') {
-        string argument = argv[1];
+    bool collect_stats = false;
+    string profile_file;
+    string line_table_file;
+    int sample_interval = 0;
+    string ngram_file;
+    string trace_file;
+    int trace_size = 0;
+    vector<string> program_files;
+    for (int i = 1; i < argc; i++) {
+        string argument = argv[i];
         if (argument == "-h" || argument == "--help") {
-            out << "Usage: " << argv[0] << " [-h] [--help] INPUT_FILE"
-                << out.endl();
+            out << "Usage: " << argv[0] << " [-h] [--help] [--stats]"
+                << " [--profile FOLDED_FILE [--lines LINE_TABLE_FILE]"
+                << " [--sample-interval N]] [--trace TRACE_FILE"
+                << " [--trace-size N]] INPUT_FILE" << out.endl()
+                << "       " << argv[0] << " --ngrams REPORT_FILE"
+                << " INPUT_FILE..." << out.endl();
             return 0;
         }
-        else {
+        else if (argument == "--stats") {
+            collect_stats = true;
+        }
+        else if (argument == "--profile" && i + 1 < argc) {
+            profile_file = argv[++i];
+        }
+        else if (argument == "--lines" && i + 1 < argc) {
+            line_table_file = argv[++i];
+        }
+        else if (argument == "--sample-interval" && i + 1 < argc) {
+            sample_interval = atoi(argv[++i]);
+        }
+        else if (argument == "--ngrams" && i + 1 < argc) {
+            ngram_file = argv[++i];
+        }
+        else if (argument == "--trace" && i + 1 < argc) {
+            trace_file = argv[++i];
+        }
+        else if (argument == "--trace-size" && i + 1 < argc) {
+            trace_size = atoi(argv[++i]);
+        }
+        else if (argument[0] == '-') {
             out << out.beginError() << "Invalid option. Use \"-h\" for help."
                 << out.endl();
             return 1;
         }
+        else {
+            program_files.push_back(argument);
+        }
     }
-    else {
-        program_file = argv[1];
+    if (program_files.empty()) {
+        out << out.beginError() << "Too few arguments. Use \"-h\" for help."
+            << out.endl();
+        return 1;
     }
-
-    // Read program file
-    FileReader reader;
-    try {
-        reader.open(program_file);
+    if (program_files.size() > 1 && ngram_file.empty()) {
+        out << out.beginError() << "Too many arguments. Use \"-h\" for "
+            << "help." << out.endl();
+        return 1;
     }
-    catch (ios_base::failure) {
-        out << out.beginError() << "Failed to open input file" << out.endl();
+    if (collect_stats + !profile_file.empty() + !ngram_file.empty()
+        + !trace_file.empty() > 1)
+    {
+        out << out.beginError() << "\"--stats\", \"--profile\", "
+            << "\"--ngrams\" and \"--trace\" cannot be combined" << out.endl();
         return 1;
     }
-    vector<char> program;
-    try {
-        reader >> program;
+
+    // Profile opcode sequences over all programs
+    if (!ngram_file.empty()) {
+        NGramVirtualMachine vm;
+        for (unsigned int i = 0; i < program_files.size(); i++) {
+            vector<char> program;
+            if (!readFile(program_files[i], &program)) {
+                out << out.beginError() << "Failed to read input file \""
+                    << program_files[i] << "\"" << out.endl();
+                return 1;
+            }
+            vm.execute(program);
+        }
+        if (!writeFile(ngram_file, vm.toReport(50))) {
+            out << out.beginError() << "Failed to write n-gram report file"
+                << out.endl();
+            return 1;
+        }
+        return 0;
     }
-    catch (ios_base::failure) {
+
+    // Read program file
+    const string& program_file = program_files[0];
+    vector<char> program;
+    if (!readFile(program_file, &program)) {
         out << out.beginError() << "Failed to read input file" << out.endl();
         return 1;
     }
 
+    // Read line table file
+    LineTable lines;
+    if (!line_table_file.empty()) {
+        vector<char> data;
+        if (!readFile(line_table_file, &data)) {
+            out << out.beginError() << "Failed to read line table file"
+                << out.endl();
+            return 1;
+        }
+        if (!lines.parse(data)) {
+            out << out.beginError() << "Malformed line table file"
+                << out.endl();
+            return 1;
+        }
+    }
+
     // Run virtual machine
-    VirtualMachine vm;
-    vm.execute(program);
+    if (!profile_file.empty()) {
+        ProfilingVirtualMachine vm;
+        if (sample_interval > 0) vm.setInstructionInterval(sample_interval);
+        vm.execute(program);
+
+        const LineTable* table = line_table_file.empty() ? NULL : &lines;
+        if (!writeFile(profile_file, vm.toFoldedStacks(program_file, table))) {
+            out << out.beginError() << "Failed to write profile file"
+                << out.endl();
+            return 1;
+        }
+    }
+    else if (!trace_file.empty()) {
+        TracingVirtualMachine vm(trace_size > 0 ? trace_size : 4096);
+        vm.setTraceFile(trace_file);
+        vm.execute(program);
+    }
+    else if (collect_stats) {
+        StatisticsVirtualMachine vm;
+        vm.execute(program);
+        out << vm.toJson() << out.endl();
+    }
+    else {
+        VirtualMachine vm;
+        vm.execute(program);
+    }
 
     return 0;
 }
@@ -0,0 +1,70 @@
+#include "instrumented_virtual_machine.hpp"
+
+InstrumentedVirtualMachine::InstrumentedVirtualMachine(void) {}
+
+InstrumentedVirtualMachine::~InstrumentedVirtualMachine(void) {}
+
+bool InstrumentedVirtualMachine::processInstLOAD(void) {
+    return beforeInstruction(CodeListing::LOAD)
+        && VirtualMachine::processInstLOAD();
+}
+
+bool InstrumentedVirtualMachine::processInstSTORE(void) {
+    return beforeInstruction(CodeListing::STORE)
+        && VirtualMachine::processInstSTORE();
+}
+
+bool InstrumentedVirtualMachine::processInstCONST_1B(char value) {
+    return beforeInstruction(CodeListing::CONST_1B)
+        && VirtualMachine::processInstCONST_1B(value);
+}
+
+bool InstrumentedVirtualMachine::processInstCONST_2B(short value) {
+    return beforeInstruction(CodeListing::CONST_2B)
+        && VirtualMachine::processInstCONST_2B(value);
+}
+
+bool InstrumentedVirtualMachine::processInstCONST_4B(int value) {
+    return beforeInstruction(CodeListing::CONST_4B)
+        && VirtualMachine::processInstCONST_4B(value);
+}
+
+bool InstrumentedVirtualMachine::processInstCONST_0(void) {
+    return beforeInstruction(CodeListing::CONST_0)
+        && VirtualMachine::processInstCONST_0();
+}
+
+bool InstrumentedVirtualMachine::processInstCONST_1(void) {
+    return beforeInstruction(CodeListing::CONST_1)
+        && VirtualMachine::processInstCONST_1();
+}
+
+bool InstrumentedVirtualMachine::processInstADD(void) {
+    return beforeInstruction(CodeListing::ADD)
+        && VirtualMachine::processInstADD();
+}
+
+bool InstrumentedVirtualMachine::processInstSUB(void) {
+    return beforeInstruction(CodeListing::SUB)
+        && VirtualMachine::processInstSUB();
+}
+
+bool InstrumentedVirtualMachine::processInstMUL(void) {
+    return beforeInstruction(CodeListing::MUL)
+        && VirtualMachine::processInstMUL();
+}
+
+bool InstrumentedVirtualMachine::processInstDIV(void) {
+    return beforeInstruction(CodeListing::DIV)
+        && VirtualMachine::processInstDIV();
+}
+
+bool InstrumentedVirtualMachine::processInstSWAP(void) {
+    return beforeInstruction(CodeListing::SWAP)
+        && VirtualMachine::processInstSWAP();
+}
+
+bool InstrumentedVirtualMachine::processInstPRINT(void) {
+    return beforeInstruction(CodeListing::PRINT)
+        && VirtualMachine::processInstPRINT();
+}
@@ -0,0 +1,136 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CEE_VM_INSTRUMENTED_VIRTUAL_MACHINE__H
+#define CEE_VM_INSTRUMENTED_VIRTUAL_MACHINE__H
+
+/**
+ * @file
+ * @brief Defines a virtual machine with a per-instruction hook.
+ */
+
+#include "virtual_machine.hpp"
+
+/**
+ * \brief Virtual machine with a per-instruction hook.
+ *
+ * The InstrumentedVirtualMachine class invokes beforeInstruction() before
+ * every known instruction is executed, which gives deriving classes (such as
+ * profilers and tracers) a single place to observe the execution without
+ * overriding every instruction hook. A plain VirtualMachine does not have the
+ * extra call.
+ */
+class InstrumentedVirtualMachine : public VirtualMachine {
+  public:
+    /**
+     * \copydoc VirtualMachine::VirtualMachine(void)
+     */
+    InstrumentedVirtualMachine(void);
+
+    /**
+     * \copydoc VirtualMachine::~VirtualMachine(void)
+     */
+    virtual ~InstrumentedVirtualMachine(void);
+
+  protected:
+    /**
+     * Hook that is invoked before an instruction is executed. The program
+     * counter (see getPC()) refers to the instruction, and the stack has not
+     * yet been changed by it.
+     *
+     * @param inst
+     *        Instruction about to be executed.
+     * @returns \c true if the execution should continue.
+     */
+    virtual bool beforeInstruction(CodeListing::Instruction inst) = 0;
+
+    /**
+     * \copydoc VirtualMachine::processInstLOAD(void)
+     */
+    virtual bool processInstLOAD(void);
+
+    /**
+     * \copydoc VirtualMachine::processInstSTORE(void)
+     */
+    virtual bool processInstSTORE(void);
+
+    /**
+     * \copydoc VirtualMachine::processInstCONST_1B(char)
+     */
+    virtual bool processInstCONST_1B(char value);
+
+    /**
+     * \copydoc VirtualMachine::processInstCONST_2B(short)
+     */
+    virtual bool processInstCONST_2B(short value);
+
+    /**
+     * \copydoc VirtualMachine::processInstCONST_4B(int)
+     */
+    virtual bool processInstCONST_4B(int value);
+
+    /**
+     * \copydoc VirtualMachine::processInstCONST_0(void)
+     */
+    virtual bool processInstCONST_0(void);
+
+    /**
+     * \copydoc VirtualMachine::processInstCONST_1(void)
+     */
+    virtual bool processInstCONST_1(void);
+
+    /**
+     * \copydoc VirtualMachine::processInstADD(void)
+     */
+    virtual bool processInstADD(void);
+
+    /**
+     * \copydoc VirtualMachine::processInstSUB(void)
+     */
+    virtual bool processInstSUB(void);
+
+    /**
+     * \copydoc VirtualMachine::processInstMUL(void)
+     */
+    virtual bool processInstMUL(void);
+
+    /**
+     * \copydoc VirtualMachine::processInstDIV(void)
+     */
+    virtual bool processInstDIV(void);
+
+    /**
+     * \copydoc VirtualMachine::processInstSWAP(void)
+     */
+    virtual bool processInstSWAP(void);
+
+    /**
+     * \copydoc VirtualMachine::processInstPRINT(void)
+     */
+    virtual bool processInstPRINT(void);
+};
+
+#endif
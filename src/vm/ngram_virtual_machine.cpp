@@ -0,0 +1,227 @@
+#include "ngram_virtual_machine.hpp"
+#include <algorithm>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+using std::fixed;
+using std::setprecision;
+using std::setw;
+using std::string;
+using std::stringstream;
+using std::vector;
+
+/**
+ * Gets a monotonic timestamp.
+ *
+ * @returns Time in seconds.
+ */
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Gets the mnemonic of an opcode.
+ *
+ * @param opcode
+ *        Opcode.
+ * @returns Mnemonic.
+ */
+static string opcodeName(int opcode) {
+    const char* name = CodeListing::getInstructionName(
+        static_cast<CodeListing::Instruction>(opcode));
+    if (name) return name;
+    stringstream ss;
+    ss << "0x" << std::hex << opcode;
+    return ss.str();
+}
+
+/**
+ * Formats a share as a percentage.
+ *
+ * @param part
+ *        Part.
+ * @param total
+ *        Total.
+ * @returns Percentage.
+ */
+static string percentage(unsigned long long part, unsigned long long total) {
+    stringstream ss;
+    ss << fixed << setprecision(2)
+       << (total > 0 ? 100.0 * part / total : 0.0) << "%";
+    return ss.str();
+}
+
+/**
+ * \brief Fusion candidate in the report.
+ */
+struct Candidate {
+    /**
+     * Opcode sequence.
+     */
+    string sequence;
+
+    /**
+     * Number of times the sequence was executed.
+     */
+    unsigned long long count;
+
+    /**
+     * Number of dispatches saved by fusing the sequence.
+     */
+    unsigned long long saved;
+};
+
+/**
+ * Orders candidates by descending number of saved dispatches.
+ *
+ * @param lhs
+ *        Candidate.
+ * @param rhs
+ *        Candidate.
+ * @returns \c true if \c lhs ranks before \c rhs.
+ */
+static bool ranksBefore(const Candidate& lhs, const Candidate& rhs) {
+    if (lhs.saved != rhs.saved) return lhs.saved > rhs.saved;
+    return lhs.sequence < rhs.sequence;
+}
+
+NGramVirtualMachine::NGramVirtualMachine(void)
+        : _history_length(0), _num_programs(0), _execution_time(0)
+{
+    for (int i = 0; i < NUM_OPCODES; i++) {
+        _unigrams[i] = 0;
+        for (int j = 0; j < NUM_OPCODES; j++) {
+            _bigrams[i][j] = 0;
+            for (int k = 0; k < NUM_OPCODES; k++) _trigrams[i][j][k] = 0;
+        }
+    }
+}
+
+NGramVirtualMachine::~NGramVirtualMachine(void) {}
+
+void NGramVirtualMachine::execute(const vector<char>& program) {
+    _history_length = 0;
+    double start = now();
+    InstrumentedVirtualMachine::execute(program);
+    _execution_time += now() - start;
+    _num_programs++;
+}
+
+unsigned long long NGramVirtualMachine::getCount(
+    CodeListing::Instruction inst) const
+{
+    return _unigrams[inst];
+}
+
+unsigned long long NGramVirtualMachine::getCount(
+    CodeListing::Instruction first,
+    CodeListing::Instruction second) const
+{
+    return _bigrams[first][second];
+}
+
+unsigned long long NGramVirtualMachine::getCount(
+    CodeListing::Instruction first,
+    CodeListing::Instruction second,
+    CodeListing::Instruction third) const
+{
+    return _trigrams[first][second][third];
+}
+
+string NGramVirtualMachine::toReport(unsigned int max_candidates) const {
+    unsigned long long total = 0;
+    for (int i = 0; i < NUM_OPCODES; i++) total += _unigrams[i];
+    double ns_per_inst = total > 0 ? _execution_time * 1e9 / total : 0;
+
+    stringstream ss;
+    ss << "OPCODE N-GRAM REPORT" << std::endl
+       << "Programs: " << _num_programs << std::endl
+       << "Executed instructions: " << total << std::endl
+       << "Mean time per instruction (ns): " << fixed << setprecision(2)
+       << ns_per_inst << std::endl;
+
+    // CONST widths
+    const CodeListing::Instruction consts[] = {
+        CodeListing::CONST_0, CodeListing::CONST_1, CodeListing::CONST_1B,
+        CodeListing::CONST_2B, CodeListing::CONST_4B
+    };
+    const int num_consts = sizeof(consts) / sizeof(consts[0]);
+    unsigned long long total_consts = 0;
+    for (int i = 0; i < num_consts; i++) total_consts += _unigrams[consts[i]];
+    ss << std::endl << "CONST WIDTHS:" << std::endl;
+    for (int i = 0; i < num_consts; i++) {
+        ss << "  " << std::left << setw(10) << opcodeName(consts[i])
+           << std::right << setw(14) << _unigrams[consts[i]] << "  "
+           << percentage(_unigrams[consts[i]], total_consts) << std::endl;
+    }
+
+    // Transitions, grouped by source opcode
+    ss << std::endl << "TRANSITIONS (share of the source opcode):"
+       << std::endl;
+    for (int i = 0; i < NUM_OPCODES; i++) {
+        unsigned long long from_total = 0;
+        for (int j = 0; j < NUM_OPCODES; j++) from_total += _bigrams[i][j];
+        for (int j = 0; j < NUM_OPCODES; j++) {
+            if (_bigrams[i][j] == 0) continue;
+            ss << "  " << std::left << setw(10) << opcodeName(i) << "-> "
+               << setw(10) << opcodeName(j) << std::right << setw(14)
+               << _bigrams[i][j] << "  "
+               << percentage(_bigrams[i][j], from_total) << std::endl;
+        }
+    }
+
+    // Fusion candidates
+    vector<Candidate> candidates;
+    for (int i = 0; i < NUM_OPCODES; i++) {
+        for (int j = 0; j < NUM_OPCODES; j++) {
+            if (_bigrams[i][j] > 0) {
+                Candidate c;
+                c.sequence = opcodeName(i) + " " + opcodeName(j);
+                c.count = _bigrams[i][j];
+                c.saved = c.count;
+                candidates.push_back(c);
+            }
+            for (int k = 0; k < NUM_OPCODES; k++) {
+                if (_trigrams[i][j][k] == 0) continue;
+                Candidate c;
+                c.sequence = opcodeName(i) + " " + opcodeName(j) + " "
+                             + opcodeName(k);
+                c.count = _trigrams[i][j][k];
+                c.saved = 2 * c.count;
+                candidates.push_back(c);
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), ranksBefore);
+    if (candidates.size() > max_candidates) candidates.resize(max_candidates);
+
+    ss << std::endl
+       << "FUSION CANDIDATES (ranked by dispatches saved):" << std::endl
+       << "  " << std::left << setw(30) << "SEQUENCE" << std::right
+       << setw(14) << "COUNT" << setw(18) << "SAVED DISPATCHES"
+       << setw(10) << "SHARE" << setw(18) << "EST. SAVED (ns)" << std::endl;
+    for (unsigned int i = 0; i < candidates.size(); i++) {
+        const Candidate& c = candidates[i];
+        ss << "  " << std::left << setw(30) << c.sequence << std::right
+           << setw(14) << c.count << setw(18) << c.saved
+           << setw(10) << percentage(c.saved, total)
+           << setw(18) << setprecision(0) << c.saved * ns_per_inst
+           << std::endl;
+    }
+    return ss.str();
+}
+
+bool NGramVirtualMachine::beforeInstruction(CodeListing::Instruction inst) {
+    int opcode = inst;
+    _unigrams[opcode]++;
+    if (_history_length >= 1) _bigrams[_history[0]][opcode]++;
+    if (_history_length >= 2) _trigrams[_history[1]][_history[0]][opcode]++;
+
+    _history[1] = _history[0];
+    _history[0] = opcode;
+    if (_history_length < 2) _history_length++;
+    return true;
+}
@@ -0,0 +1,176 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CEE_VM_NGRAM_VIRTUAL_MACHINE__H
+#define CEE_VM_NGRAM_VIRTUAL_MACHINE__H
+
+/**
+ * @file
+ * @brief Defines a virtual machine which profiles opcode sequences.
+ */
+
+#include "instrumented_virtual_machine.hpp"
+#include <string>
+#include <vector>
+
+/**
+ * \brief Virtual machine which profiles opcode sequences.
+ *
+ * The NGramVirtualMachine class counts how often each opcode, each pair of
+ * consecutive opcodes (bigram, which is also the opcode-to-opcode transition
+ * count) and each triple of consecutive opcodes (trigram) is executed. The
+ * counts accumulate over every executed program, so a whole corpus can be
+ * profiled with one instance; sequences never span two programs.
+ *
+ * The report ranks the bigrams and trigrams as candidates for fused
+ * instructions. Fusing a sequence of \e n instructions into one removes
+ * \e n - 1 dispatches per occurrence, so the candidates are ranked by the
+ * number of dispatches that would be saved. The time estimate multiplies this
+ * by the mean time per executed instruction, and is therefore an upper bound.
+ */
+class NGramVirtualMachine : public InstrumentedVirtualMachine {
+  public:
+    /**
+     * \copydoc VirtualMachine::VirtualMachine(void)
+     */
+    NGramVirtualMachine(void);
+
+    /**
+     * \copydoc VirtualMachine::~VirtualMachine(void)
+     */
+    virtual ~NGramVirtualMachine(void);
+
+    /**
+     * Executes a program and adds its opcode sequences to the counts.
+     *
+     * @param program
+     *        Program to execute.
+     */
+    virtual void execute(const std::vector<char>& program);
+
+    /**
+     * Gets the number of times an instruction was executed.
+     *
+     * @param inst
+     *        Instruction.
+     * @returns Count.
+     */
+    unsigned long long getCount(CodeListing::Instruction inst) const;
+
+    /**
+     * Gets the number of times an instruction was directly followed by
+     * another.
+     *
+     * @param first
+     *        First instruction.
+     * @param second
+     *        Second instruction.
+     * @returns Count.
+     */
+    unsigned long long getCount(
+        CodeListing::Instruction first,
+        CodeListing::Instruction second) const;
+
+    /**
+     * Gets the number of times a sequence of three instructions was executed.
+     *
+     * @param first
+     *        First instruction.
+     * @param second
+     *        Second instruction.
+     * @param third
+     *        Third instruction.
+     * @returns Count.
+     */
+    unsigned long long getCount(
+        CodeListing::Instruction first,
+        CodeListing::Instruction second,
+        CodeListing::Instruction third) const;
+
+    /**
+     * Formats the counts as a text report with the CONST width distribution,
+     * the opcode transitions and the fusion candidates.
+     *
+     * @param max_candidates
+     *        Maximum number of fusion candidates to list.
+     * @returns Report.
+     */
+    std::string toReport(unsigned int max_candidates) const;
+
+  protected:
+    /**
+     * Counts the instruction and the sequences it completes.
+     *
+     * @param inst
+     *        Instruction about to be executed.
+     * @returns Always \c true.
+     */
+    virtual bool beforeInstruction(CodeListing::Instruction inst);
+
+  private:
+    /**
+     * Number of counted opcodes. All opcodes of the instruction set are below
+     * this value.
+     */
+    static const int NUM_OPCODES = 16;
+
+    /**
+     * Number of times each opcode was executed.
+     */
+    unsigned long long _unigrams[NUM_OPCODES];
+
+    /**
+     * Number of times each opcode pair was executed.
+     */
+    unsigned long long _bigrams[NUM_OPCODES][NUM_OPCODES];
+
+    /**
+     * Number of times each opcode triple was executed.
+     */
+    unsigned long long _trigrams[NUM_OPCODES][NUM_OPCODES][NUM_OPCODES];
+
+    /**
+     * The two most recently executed opcodes; the most recent is first.
+     */
+    int _history[2];
+
+    /**
+     * Number of valid entries in _history.
+     */
+    int _history_length;
+
+    /**
+     * Number of executed programs.
+     */
+    unsigned int _num_programs;
+
+    /**
+     * Total execution wall time (in seconds).
+     */
+    double _execution_time;
+};
+
+#endif
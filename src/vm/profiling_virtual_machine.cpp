@@ -0,0 +1,120 @@
+#include "profiling_virtual_machine.hpp"
+#include <sstream>
+#include <utility>
+#include <sys/time.h>
+
+using std::make_pair;
+using std::map;
+using std::pair;
+using std::string;
+using std::stringstream;
+using std::vector;
+
+ProfilingVirtualMachine::ProfilingVirtualMachine(void)
+        : _instruction_interval(0), _countdown(0), _timer_interval(1000)
+{}
+
+ProfilingVirtualMachine::~ProfilingVirtualMachine(void) {}
+
+void ProfilingVirtualMachine::setInstructionInterval(unsigned int interval) {
+    _instruction_interval = interval;
+}
+
+void ProfilingVirtualMachine::setTimerInterval(unsigned int microseconds) {
+    _instruction_interval = 0;
+    _timer_interval = microseconds;
+}
+
+void ProfilingVirtualMachine::execute(const vector<char>& program) {
+    _countdown = _instruction_interval;
+    _sample_pending = 0;
+    if (_instruction_interval > 0) {
+        InstrumentedVirtualMachine::execute(program);
+        return;
+    }
+
+    struct sigaction action, old_action;
+    action.sa_handler = &handleTimerSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGPROF, &action, &old_action);
+
+    struct itimerval timer, old_timer;
+    timer.it_interval.tv_sec = _timer_interval / 1000000;
+    timer.it_interval.tv_usec = _timer_interval % 1000000;
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_PROF, &timer, &old_timer);
+
+    InstrumentedVirtualMachine::execute(program);
+
+    setitimer(ITIMER_PROF, &old_timer, NULL);
+    sigaction(SIGPROF, &old_action, NULL);
+}
+
+unsigned long long ProfilingVirtualMachine::getNumSamples(void) const {
+    unsigned long long total = 0;
+    map<int, unsigned long long>::const_iterator it;
+    for (it = _samples.begin(); it != _samples.end(); it++) {
+        total += it->second;
+    }
+    return total;
+}
+
+void ProfilingVirtualMachine::clearSamples(void) {
+    _samples.clear();
+}
+
+string ProfilingVirtualMachine::toFoldedStacks(
+    const string& root,
+    const LineTable* lines) const
+{
+    // Aggregate per source position; positions are (line, column), and
+    // uncovered program counter values are kept apart as (-1, PC)
+    map<pair<int, int>, unsigned long long> positions;
+    map<int, unsigned long long>::const_iterator it;
+    for (it = _samples.begin(); it != _samples.end(); it++) {
+        int line, column;
+        if (!lines || !lines->lookUp(it->first, &line, &column)) {
+            line = -1;
+            column = it->first;
+        }
+        positions[make_pair(line, column)] += it->second;
+    }
+
+    stringstream ss;
+    map<pair<int, int>, unsigned long long>::const_iterator pos_it;
+    for (pos_it = positions.begin(); pos_it != positions.end(); pos_it++) {
+        int line = pos_it->first.first;
+        int column = pos_it->first.second;
+        ss << root << ";";
+        if (line < 0) {
+            ss << "pc " << column;
+        }
+        else {
+            ss << "line " << line << ";" << line << ":" << column;
+        }
+        ss << " " << pos_it->second << std::endl;
+    }
+    return ss.str();
+}
+
+bool ProfilingVirtualMachine::beforeInstruction(CodeListing::Instruction inst)
+{
+    if (_instruction_interval > 0) {
+        if (--_countdown > 0) return true;
+        _countdown = _instruction_interval;
+    }
+    else {
+        if (!_sample_pending) return true;
+        _sample_pending = 0;
+    }
+
+    _samples[getPC()]++;
+    return true;
+}
+
+void ProfilingVirtualMachine::handleTimerSignal(int signal) {
+    _sample_pending = 1;
+}
+
+volatile sig_atomic_t ProfilingVirtualMachine::_sample_pending = 0;
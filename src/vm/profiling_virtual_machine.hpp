@@ -0,0 +1,174 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CEE_VM_PROFILING_VIRTUAL_MACHINE__H
+#define CEE_VM_PROFILING_VIRTUAL_MACHINE__H
+
+/**
+ * @file
+ * @brief Defines a virtual machine with a sampling profiler.
+ */
+
+#include "instrumented_virtual_machine.hpp"
+#include "../generator/line_table.hpp"
+#include <csignal>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Virtual machine with a sampling profiler.
+ *
+ * The ProfilingVirtualMachine class periodically records the program counter
+ * of the instruction being executed. Samples are taken either every N executed
+ * instructions, which is deterministic, or whenever a CPU-time timer
+ * (<code>SIGPROF</code>) expires, which weights the samples by the time the
+ * instructions actually take. The signal handler only raises a flag, and the
+ * sample is taken by the next instruction.
+ *
+ * The samples can then be attributed to source lines through a LineTable, and
+ * written in the folded-stack format read by flame graph tools, one line per
+ * source position:
+ *
+ * <pre>
+ * ROOT;line LINE;LINE:COLUMN COUNT
+ * </pre>
+ *
+ * Only one ProfilingVirtualMachine can use the timer at a time.
+ */
+class ProfilingVirtualMachine : public InstrumentedVirtualMachine {
+  public:
+    /**
+     * Creates a profiling virtual machine. By default a sample is taken every
+     * millisecond of CPU time.
+     */
+    ProfilingVirtualMachine(void);
+
+    /**
+     * \copydoc VirtualMachine::~VirtualMachine(void)
+     */
+    virtual ~ProfilingVirtualMachine(void);
+
+    /**
+     * Takes a sample every given number of executed instructions, instead of
+     * using the timer.
+     *
+     * @param interval
+     *        Number of instructions between samples (must be positive).
+     */
+    void setInstructionInterval(unsigned int interval);
+
+    /**
+     * Takes a sample whenever the given amount of CPU time has been used.
+     *
+     * @param microseconds
+     *        Time between samples (must be positive).
+     */
+    void setTimerInterval(unsigned int microseconds);
+
+    /**
+     * Executes a program while sampling. Samples from earlier executions are
+     * kept.
+     *
+     * @param program
+     *        Program to execute.
+     */
+    virtual void execute(const std::vector<char>& program);
+
+    /**
+     * Gets the total number of samples taken.
+     *
+     * @returns Number of samples.
+     */
+    unsigned long long getNumSamples(void) const;
+
+    /**
+     * Removes all samples.
+     */
+    void clearSamples(void);
+
+    /**
+     * Formats the samples as folded stacks. Samples whose program counter is
+     * not covered by the line table are attributed to their program counter
+     * value instead.
+     *
+     * @param root
+     *        Name of the root frame (e.g. the program file name).
+     * @param lines
+     *        Line table of the program, or \c NULL.
+     * @returns Folded stacks.
+     */
+    std::string toFoldedStacks(
+        const std::string& root,
+        const LineTable* lines) const;
+
+  protected:
+    /**
+     * Takes a sample if one is due.
+     *
+     * @param inst
+     *        Instruction about to be executed.
+     * @returns Always \c true.
+     */
+    virtual bool beforeInstruction(CodeListing::Instruction inst);
+
+  private:
+    /**
+     * Signal handler for the profiling timer.
+     *
+     * @param signal
+     *        Signal number.
+     */
+    static void handleTimerSignal(int signal);
+
+  private:
+    /**
+     * Set by the signal handler when a sample is due.
+     */
+    static volatile sig_atomic_t _sample_pending;
+
+    /**
+     * Number of instructions between samples, or 0 if the timer is used.
+     */
+    unsigned int _instruction_interval;
+
+    /**
+     * Number of instructions left until the next sample.
+     */
+    unsigned int _countdown;
+
+    /**
+     * Time between samples (in microseconds).
+     */
+    unsigned int _timer_interval;
+
+    /**
+     * Number of samples per program counter value.
+     */
+    std::map<int, unsigned long long> _samples;
+};
+
+#endif
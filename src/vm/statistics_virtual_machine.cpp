@@ -0,0 +1,226 @@
+#include "statistics_virtual_machine.hpp"
+#include <ctime>
+#include <sstream>
+
+using std::string;
+using std::stringstream;
+using std::vector;
+
+/**
+ * Gets a monotonic timestamp.
+ *
+ * @returns Time in seconds.
+ */
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Gets the number of characters needed to print a value in decimal.
+ *
+ * @param value
+ *        Value.
+ * @returns Number of characters.
+ */
+static unsigned int numDecimalChars(int value) {
+    long long v = value;
+    unsigned int num = 1;
+    if (v < 0) {
+        num++;
+        v = -v;
+    }
+    for (; v >= 10; v /= 10) num++;
+    return num;
+}
+
+StatisticsVirtualMachine::StatisticsVirtualMachine(void) {
+    clear();
+}
+
+StatisticsVirtualMachine::~StatisticsVirtualMachine(void) {}
+
+void StatisticsVirtualMachine::execute(const vector<char>& program) {
+    clear();
+    double start = now();
+    VirtualMachine::execute(program);
+    _execution_time = now() - start;
+}
+
+unsigned long long StatisticsVirtualMachine::getNumExecutedInstructions(void)
+    const
+{
+    unsigned long long total = 0;
+    for (int i = 0; i < NUM_OPCODES; i++) total += _num_executed[i];
+    return total;
+}
+
+unsigned long long StatisticsVirtualMachine::getNumExecuted(
+    CodeListing::Instruction inst) const
+{
+    return _num_executed[static_cast<unsigned char>(inst)];
+}
+
+unsigned int StatisticsVirtualMachine::getStackHighWaterMark(void) const {
+    return _stack_high_water_mark;
+}
+
+unsigned int StatisticsVirtualMachine::getNumMemoryLocations(void) const {
+    return _touched.size();
+}
+
+unsigned int StatisticsVirtualMachine::getNumTouchedMemoryLocations(void)
+    const
+{
+    return _num_touched;
+}
+
+unsigned long long StatisticsVirtualMachine::getNumPrints(void) const {
+    return _num_prints;
+}
+
+unsigned long long StatisticsVirtualMachine::getNumOutputBytes(void) const {
+    return _num_output_bytes;
+}
+
+double StatisticsVirtualMachine::getExecutionTime(void) const {
+    return _execution_time;
+}
+
+string StatisticsVirtualMachine::toJson(void) const {
+    stringstream ss;
+    ss << "{" << std::endl
+       << "  \"instructions\": {" << std::endl
+       << "    \"total\": " << getNumExecutedInstructions() << "," << std::endl
+       << "    \"per_opcode\": {";
+    bool first = true;
+    for (int i = 0; i < NUM_OPCODES; i++) {
+        const char* name = CodeListing::getInstructionName(
+            static_cast<CodeListing::Instruction>(i));
+        if (!name) continue;
+        ss << (first ? "" : ",") << std::endl
+           << "      \"" << name << "\": " << _num_executed[i];
+        first = false;
+    }
+    ss << std::endl
+       << "    }" << std::endl
+       << "  }," << std::endl
+       << "  \"stack_high_water_mark\": " << _stack_high_water_mark << ","
+       << std::endl
+       << "  \"memory_locations\": " << getNumMemoryLocations() << ","
+       << std::endl
+       << "  \"touched_memory_locations\": " << _num_touched << ","
+       << std::endl
+       << "  \"prints\": " << _num_prints << "," << std::endl
+       << "  \"output_bytes\": " << _num_output_bytes << "," << std::endl
+       << "  \"execution_time_ns\": "
+       << static_cast<unsigned long long>(_execution_time * 1e9) << std::endl
+       << "}";
+    return ss.str();
+}
+
+bool StatisticsVirtualMachine::processMemorySize(int value) {
+    if (!VirtualMachine::processMemorySize(value)) return false;
+    _touched.assign(value < 0 ? 0 : value, false);
+    return true;
+}
+
+bool StatisticsVirtualMachine::processInstLOAD(void) {
+    int index = getStackSize() > 0 ? getStackTop() : -1;
+    if (!count(CodeListing::LOAD, VirtualMachine::processInstLOAD())) {
+        return false;
+    }
+    touch(index);
+    return true;
+}
+
+bool StatisticsVirtualMachine::processInstSTORE(void) {
+    int index = getStackSize() > 0 ? getStackTop() : -1;
+    if (!count(CodeListing::STORE, VirtualMachine::processInstSTORE())) {
+        return false;
+    }
+    touch(index);
+    return true;
+}
+
+bool StatisticsVirtualMachine::processInstCONST_1B(char value) {
+    return count(CodeListing::CONST_1B,
+                 VirtualMachine::processInstCONST_1B(value));
+}
+
+bool StatisticsVirtualMachine::processInstCONST_2B(short value) {
+    return count(CodeListing::CONST_2B,
+                 VirtualMachine::processInstCONST_2B(value));
+}
+
+bool StatisticsVirtualMachine::processInstCONST_4B(int value) {
+    return count(CodeListing::CONST_4B,
+                 VirtualMachine::processInstCONST_4B(value));
+}
+
+bool StatisticsVirtualMachine::processInstCONST_0(void) {
+    return count(CodeListing::CONST_0, VirtualMachine::processInstCONST_0());
+}
+
+bool StatisticsVirtualMachine::processInstCONST_1(void) {
+    return count(CodeListing::CONST_1, VirtualMachine::processInstCONST_1());
+}
+
+bool StatisticsVirtualMachine::processInstADD(void) {
+    return count(CodeListing::ADD, VirtualMachine::processInstADD());
+}
+
+bool StatisticsVirtualMachine::processInstSUB(void) {
+    return count(CodeListing::SUB, VirtualMachine::processInstSUB());
+}
+
+bool StatisticsVirtualMachine::processInstMUL(void) {
+    return count(CodeListing::MUL, VirtualMachine::processInstMUL());
+}
+
+bool StatisticsVirtualMachine::processInstDIV(void) {
+    return count(CodeListing::DIV, VirtualMachine::processInstDIV());
+}
+
+bool StatisticsVirtualMachine::processInstSWAP(void) {
+    return count(CodeListing::SWAP, VirtualMachine::processInstSWAP());
+}
+
+bool StatisticsVirtualMachine::processInstPRINT(void) {
+    int value = getStackSize() > 0 ? getStackTop() : 0;
+    if (!count(CodeListing::PRINT, VirtualMachine::processInstPRINT())) {
+        return false;
+    }
+    _num_prints++;
+    _num_output_bytes += numDecimalChars(value) + 1; // Value and new line
+    return true;
+}
+
+bool StatisticsVirtualMachine::count(
+    CodeListing::Instruction inst,
+    bool result)
+{
+    if (!result) return false;
+    _num_executed[static_cast<unsigned char>(inst)]++;
+    if (getStackSize() > _stack_high_water_mark) {
+        _stack_high_water_mark = getStackSize();
+    }
+    return true;
+}
+
+void StatisticsVirtualMachine::touch(int index) {
+    if (_touched[index]) return;
+    _touched[index] = true;
+    _num_touched++;
+}
+
+void StatisticsVirtualMachine::clear(void) {
+    for (int i = 0; i < NUM_OPCODES; i++) _num_executed[i] = 0;
+    _stack_high_water_mark = 0;
+    _touched.clear();
+    _num_touched = 0;
+    _num_prints = 0;
+    _num_output_bytes = 0;
+    _execution_time = 0;
+}
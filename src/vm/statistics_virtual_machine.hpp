@@ -0,0 +1,277 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CEE_VM_STATISTICS_VIRTUAL_MACHINE__H
+#define CEE_VM_STATISTICS_VIRTUAL_MACHINE__H
+
+/**
+ * @file
+ * @brief Defines a virtual machine which collects execution statistics.
+ */
+
+#include "virtual_machine.hpp"
+#include <string>
+#include <vector>
+
+/**
+ * \brief Virtual machine which collects execution statistics.
+ *
+ * The StatisticsVirtualMachine class executes programs exactly like
+ * VirtualMachine, but also counts what the program did: the number of executed
+ * instructions per opcode, the stack high-water mark, the number of distinct
+ * memory locations that were accessed, and the number and size of the printed
+ * values, together with the execution wall time.
+ *
+ * The statistics are collected by overriding the instruction hooks, so a plain
+ * VirtualMachine does not pay anything for them. Only instructions that were
+ * successfully processed are counted. The statistics are reset at the start of
+ * every execute(const std::vector<char>&).
+ */
+class StatisticsVirtualMachine : public VirtualMachine {
+  public:
+    /**
+     * \copydoc VirtualMachine::VirtualMachine(void)
+     */
+    StatisticsVirtualMachine(void);
+
+    /**
+     * \copydoc VirtualMachine::~VirtualMachine(void)
+     */
+    virtual ~StatisticsVirtualMachine(void);
+
+    /**
+     * \copydoc VirtualMachine::execute(const std::vector<char>&)
+     */
+    virtual void execute(const std::vector<char>& program);
+
+    /**
+     * Gets the total number of executed instructions.
+     *
+     * @returns Number of instructions.
+     */
+    unsigned long long getNumExecutedInstructions(void) const;
+
+    /**
+     * Gets the number of times a given instruction was executed.
+     *
+     * @param inst
+     *        Instruction.
+     * @returns Number of instructions.
+     */
+    unsigned long long getNumExecuted(CodeListing::Instruction inst) const;
+
+    /**
+     * Gets the largest number of values that were on the stack at the same
+     * time.
+     *
+     * @returns Stack high-water mark.
+     */
+    unsigned int getStackHighWaterMark(void) const;
+
+    /**
+     * Gets the number of memory locations declared by the program.
+     *
+     * @returns Number of memory locations.
+     */
+    unsigned int getNumMemoryLocations(void) const;
+
+    /**
+     * Gets the number of distinct memory locations that were loaded from or
+     * stored to.
+     *
+     * @returns Number of memory locations.
+     */
+    unsigned int getNumTouchedMemoryLocations(void) const;
+
+    /**
+     * Gets the number of executed CodeListing::PRINT instructions.
+     *
+     * @returns Number of prints.
+     */
+    unsigned long long getNumPrints(void) const;
+
+    /**
+     * Gets the number of bytes written to the standard output by
+     * CodeListing::PRINT instructions.
+     *
+     * @returns Number of bytes.
+     */
+    unsigned long long getNumOutputBytes(void) const;
+
+    /**
+     * Gets the wall time of the last execution.
+     *
+     * @returns Time in seconds.
+     */
+    double getExecutionTime(void) const;
+
+    /**
+     * Formats all statistics as a JSON object.
+     *
+     * @returns JSON string.
+     */
+    std::string toJson(void) const;
+
+  protected:
+    /**
+     * \copydoc VirtualMachine::processMemorySize(int)
+     */
+    virtual bool processMemorySize(int value);
+
+    /**
+     * \copydoc VirtualMachine::processInstLOAD(void)
+     */
+    virtual bool processInstLOAD(void);
+
+    /**
+     * \copydoc VirtualMachine::processInstSTORE(void)
+     */
+    virtual bool processInstSTORE(void);
+
+    /**
+     * \copydoc VirtualMachine::processInstCONST_1B(char)
+     */
+    virtual bool processInstCONST_1B(char value);
+
+    /**
+     * \copydoc VirtualMachine::processInstCONST_2B(short)
+     */
+    virtual bool processInstCONST_2B(short value);
+
+    /**
+     * \copydoc VirtualMachine::processInstCONST_4B(int)
+     */
+    virtual bool processInstCONST_4B(int value);
+
+    /**
+     * \copydoc VirtualMachine::processInstCONST_0(void)
+     */
+    virtual bool processInstCONST_0(void);
+
+    /**
+     * \copydoc VirtualMachine::processInstCONST_1(void)
+     */
+    virtual bool processInstCONST_1(void);
+
+    /**
+     * \copydoc VirtualMachine::processInstADD(void)
+     */
+    virtual bool processInstADD(void);
+
+    /**
+     * \copydoc VirtualMachine::processInstSUB(void)
+     */
+    virtual bool processInstSUB(void);
+
+    /**
+     * \copydoc VirtualMachine::processInstMUL(void)
+     */
+    virtual bool processInstMUL(void);
+
+    /**
+     * \copydoc VirtualMachine::processInstDIV(void)
+     */
+    virtual bool processInstDIV(void);
+
+    /**
+     * \copydoc VirtualMachine::processInstSWAP(void)
+     */
+    virtual bool processInstSWAP(void);
+
+    /**
+     * \copydoc VirtualMachine::processInstPRINT(void)
+     */
+    virtual bool processInstPRINT(void);
+
+  private:
+    /**
+     * Counts an instruction if it was successfully processed, and updates the
+     * stack high-water mark.
+     *
+     * @param inst
+     *        Instruction.
+     * @param result
+     *        Result of processing the instruction.
+     * @returns \c result.
+     */
+    bool count(CodeListing::Instruction inst, bool result);
+
+    /**
+     * Marks a memory location as touched.
+     *
+     * @param index
+     *        Memory index (must be within bounds).
+     */
+    void touch(int index);
+
+    /**
+     * Clears all statistics.
+     */
+    void clear(void);
+
+  private:
+    /**
+     * Number of opcodes that can be represented by an instruction byte.
+     */
+    static const int NUM_OPCODES = 256;
+
+    /**
+     * Number of executed instructions, indexed by opcode.
+     */
+    unsigned long long _num_executed[NUM_OPCODES];
+
+    /**
+     * Stack high-water mark.
+     */
+    unsigned int _stack_high_water_mark;
+
+    /**
+     * Whether a memory location has been touched, indexed by memory index.
+     */
+    std::vector<bool> _touched;
+
+    /**
+     * Number of touched memory locations.
+     */
+    unsigned int _num_touched;
+
+    /**
+     * Number of executed prints.
+     */
+    unsigned long long _num_prints;
+
+    /**
+     * Number of printed bytes.
+     */
+    unsigned long long _num_output_bytes;
+
+    /**
+     * Wall time of the last execution (in seconds).
+     */
+    double _execution_time;
+};
+
+#endif
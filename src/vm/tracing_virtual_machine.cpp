@@ -0,0 +1,164 @@
+#include "tracing_virtual_machine.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+
+using std::string;
+using std::vector;
+
+TracingVirtualMachine::TracingVirtualMachine(unsigned int capacity)
+        : _num_traced(0)
+{
+    // One record is lost to the half-written slot (see dump()), so the
+    // buffer is larger than the number of instructions to keep
+    unsigned long size = 1;
+    while (size <= capacity) size <<= 1;
+    _records.resize(size);
+    _index_mask = size - 1;
+}
+
+TracingVirtualMachine::~TracingVirtualMachine(void) {}
+
+void TracingVirtualMachine::setTraceFile(const string& file) {
+    _trace_file = file;
+}
+
+void TracingVirtualMachine::execute(const vector<char>& program) {
+    _num_traced = 0;
+
+    struct sigaction action, old_actions[NUM_SIGNALS];
+    action.sa_handler = &handleSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    _signal_target = this;
+    for (int i = 0; i < NUM_SIGNALS; i++) {
+        sigaction(SIGNALS[i], &action, &old_actions[i]);
+    }
+
+    InstrumentedVirtualMachine::execute(program);
+
+    for (int i = NUM_SIGNALS - 1; i >= 0; i--) {
+        sigaction(SIGNALS[i], &old_actions[i], NULL);
+    }
+    _signal_target = NULL;
+
+    // Both an error and the normal end of the program are worth keeping
+    dump();
+}
+
+/**
+ * Writes a big-endian \c int into a buffer.
+ *
+ * @param value
+ *        Value.
+ * @param dest
+ *        Destination (at least 4 bytes).
+ * @returns Pointer past the written bytes.
+ */
+static char* writeInt(unsigned int value, char* dest) {
+    dest[0] = static_cast<char>(value >> 24);
+    dest[1] = static_cast<char>(value >> 16);
+    dest[2] = static_cast<char>(value >> 8);
+    dest[3] = static_cast<char>(value);
+    return dest + 4;
+}
+
+/**
+ * Writes an entire buffer to a file descriptor.
+ *
+ * @param fd
+ *        File descriptor.
+ * @param data
+ *        Buffer.
+ * @param size
+ *        Number of bytes.
+ * @returns \c true if all bytes were written.
+ */
+static bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) return false;
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+bool TracingVirtualMachine::dump(void) const {
+    if (_trace_file.empty()) return false;
+
+    // The record after the newest one may be half-written if the dump
+    // interrupts beforeInstruction(), so at most capacity - 1 records are kept
+    unsigned long end = _num_traced;
+    __atomic_signal_fence(__ATOMIC_ACQUIRE);
+    unsigned long capacity = _index_mask;
+    unsigned long begin = end > capacity ? end - capacity : 0;
+
+    int fd = open(_trace_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    char buffer[4096];
+    char* p = buffer;
+    p = writeInt(MAGIC_NUMBER, p);
+    p = writeInt(end - begin, p);
+    p = writeInt(begin, p);
+    bool ok = true;
+    for (unsigned long i = begin; ok && i < end; i++) {
+        const Record& record = _records[i & _index_mask];
+        p = writeInt(record.pc, p);
+        *p++ = record.inst;
+        p = writeInt(record.top, p);
+        if (p + RECORD_SIZE > buffer + sizeof(buffer)) {
+            ok = writeAll(fd, buffer, p - buffer);
+            p = buffer;
+        }
+    }
+    if (ok) ok = writeAll(fd, buffer, p - buffer);
+    close(fd);
+    return ok;
+}
+
+unsigned long TracingVirtualMachine::getNumTraced(void) const {
+    return _num_traced;
+}
+
+bool TracingVirtualMachine::beforeInstruction(CodeListing::Instruction inst) {
+    unsigned long n = _num_traced;
+    Record& record = _records[n & _index_mask];
+    record.pc = getPC();
+    record.top = getStackSize() > 0 ? getStackTop() : 0;
+    record.inst = static_cast<char>(inst);
+
+    // The record must be complete before it is published to a signal handler
+    __atomic_signal_fence(__ATOMIC_RELEASE);
+    _num_traced = n + 1;
+    return true;
+}
+
+void TracingVirtualMachine::handleSignal(int signal) {
+    TracingVirtualMachine* vm = _signal_target;
+    if (vm) vm->dump();
+    if (signal == SIGUSR1) return;
+
+    // Terminate by the signal, as if the handler had not been installed. A
+    // fault is blocked until the handler returns, and then occurs again
+    struct sigaction action;
+    action.sa_handler = SIG_DFL;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = 0;
+    sigaction(signal, &action, NULL);
+    raise(signal);
+}
+
+const int TracingVirtualMachine::MAGIC_NUMBER;
+
+const int TracingVirtualMachine::HEADER_SIZE;
+
+const int TracingVirtualMachine::RECORD_SIZE;
+
+const int TracingVirtualMachine::NUM_SIGNALS;
+
+const int TracingVirtualMachine::SIGNALS[NUM_SIGNALS] = {
+    SIGUSR1, SIGINT, SIGTERM, SIGFPE, SIGSEGV, SIGBUS, SIGILL, SIGABRT
+};
+
+TracingVirtualMachine* volatile TracingVirtualMachine::_signal_target = NULL;
@@ -0,0 +1,218 @@
+/*
+ *  Copyright:
+ *     Gabriel Hjort Blindell, 2012
+ *     Martin Yrjölä, 2016
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining
+ *  a copy of this software and associated documentation files (the
+ *  "Software"), to deal in the Software without restriction, including
+ *  without limitation the rights to use, copy, modify, merge, publish,
+ *  distribute, sublicense, and/or sell copies of the Software, and to
+ *  permit persons to whom the Software is furnished to do so, subject to
+ *  the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ *  MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ *  LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ *  OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ *  WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef CEE_VM_TRACING_VIRTUAL_MACHINE__H
+#define CEE_VM_TRACING_VIRTUAL_MACHINE__H
+
+/**
+ * @file
+ * @brief Defines a virtual machine which keeps an execution trace.
+ */
+
+#include "instrumented_virtual_machine.hpp"
+#include <csignal>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Virtual machine which keeps an execution trace.
+ *
+ * The TracingVirtualMachine class records every executed instruction in a
+ * fixed-size ring buffer in memory, so only the most recent instructions are
+ * kept. Recording an instruction is a couple of stores, and nothing is
+ * formatted or written while the program runs. The buffer is dumped to the
+ * trace file:
+ *     - when the execution stops because of an error,
+ *     - when the execution finishes (the last part of the trace is the end of
+ *       the program),
+ *     - on <code>SIGUSR1</code>, after which the execution continues, and
+ *     - on <code>SIGINT</code> and <code>SIGTERM</code>, after which the
+ *       process is terminated by the signal as usual, and
+ *     - on the fatal signals <code>SIGFPE</code>, <code>SIGSEGV</code>,
+ *       <code>SIGBUS</code>, <code>SIGILL</code> and <code>SIGABRT</code>, so
+ *       that a crash of the virtual machine itself leaves its last
+ *       instructions behind. The process is then terminated by the signal.
+ *       Signals which cannot be caught, such as <code>SIGKILL</code>, and a
+ *       crash caused by a stack overflow of the process still lose the trace.
+ *
+ * The buffer has a single writer and is only read by the dump, which uses
+ * nothing but async-signal-safe system calls and can therefore run inside the
+ * signal handler. The trace file is binary and big-endian, like the programs:
+ *     - Magic number #MAGIC_NUMBER, followed by
+ *     - Number of records (as \c int), followed by
+ *     - Number of earlier instructions which were not kept (as \c int),
+ *       followed by
+ *     - Records, oldest first, of #RECORD_SIZE bytes each: the program counter
+ *       (as \c int), the instruction (as \c char), and the value on top of the
+ *       stack before the instruction was executed (as \c int, or 0 if the stack
+ *       was empty).
+ *
+ * Only one TracingVirtualMachine can handle the signals at a time.
+ */
+class TracingVirtualMachine : public InstrumentedVirtualMachine {
+  public:
+    /**
+     * Magic number of a trace file.
+     */
+    static const int MAGIC_NUMBER = 0x1337F00D;
+
+    /**
+     * Size of the header of a trace file (in bytes).
+     */
+    static const int HEADER_SIZE = 12;
+
+    /**
+     * Size of a record in a trace file (in bytes).
+     */
+    static const int RECORD_SIZE = 9;
+
+  public:
+    /**
+     * Creates a tracing virtual machine.
+     *
+     * @param capacity
+     *        Minimum number of instructions to keep. The buffer is the next
+     *        power of two above it, of which all records but one are kept.
+     */
+    TracingVirtualMachine(unsigned int capacity = 4096);
+
+    /**
+     * \copydoc VirtualMachine::~VirtualMachine(void)
+     */
+    virtual ~TracingVirtualMachine(void);
+
+    /**
+     * Sets the file to which the trace is dumped. Without a file, the trace is
+     * only kept in memory.
+     *
+     * @param file
+     *        File path.
+     */
+    void setTraceFile(const std::string& file);
+
+    /**
+     * Executes a program while tracing, and dumps the trace afterwards. The
+     * trace of earlier executions is discarded.
+     *
+     * @param program
+     *        Program to execute.
+     */
+    virtual void execute(const std::vector<char>& program);
+
+    /**
+     * Writes the trace to the trace file. This is safe to call from a signal
+     * handler.
+     *
+     * @returns \c true if the trace was written.
+     */
+    bool dump(void) const;
+
+    /**
+     * Gets the number of instructions executed since the trace was last
+     * cleared, including those no longer kept.
+     *
+     * @returns Number of instructions.
+     */
+    unsigned long getNumTraced(void) const;
+
+  protected:
+    /**
+     * Appends the instruction to the trace.
+     *
+     * @param inst
+     *        Instruction about to be executed.
+     * @returns Always \c true.
+     */
+    virtual bool beforeInstruction(CodeListing::Instruction inst);
+
+  private:
+    /**
+     * Signal handler which dumps the trace.
+     *
+     * @param signal
+     *        Signal number.
+     */
+    static void handleSignal(int signal);
+
+  private:
+    /**
+     * Number of signals in #SIGNALS.
+     */
+    static const int NUM_SIGNALS = 8;
+
+    /**
+     * Signals on which the trace is dumped.
+     */
+    static const int SIGNALS[NUM_SIGNALS];
+
+    /**
+     * Record of an executed instruction.
+     */
+    struct Record {
+        /**
+         * Program counter value.
+         */
+        int pc;
+
+        /**
+         * Value on top of the stack.
+         */
+        int top;
+
+        /**
+         * Instruction.
+         */
+        char inst;
+    };
+
+    /**
+     * Virtual machine whose trace is dumped by the signal handler.
+     */
+    static TracingVirtualMachine* volatile _signal_target;
+
+    /**
+     * Ring buffer of records.
+     */
+    std::vector<Record> _records;
+
+    /**
+     * Mask which maps the number of traced instructions to a buffer index.
+     */
+    unsigned long _index_mask;
+
+    /**
+     * Number of traced instructions. This is only incremented once the record
+     * has been written.
+     */
+    volatile unsigned long _num_traced;
+
+    /**
+     * Trace file path.
+     */
+    std::string _trace_file;
+};
+
+#endif
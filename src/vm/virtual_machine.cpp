@@ -1,86 +1,205 @@
-
 #include "virtual_machine.hpp"
 #include "../io/reporter.hpp"
+#include <climits>
 #include <iostream>
+#include <sstream>
+using std::string;
+using std::stringstream;
 using std::vector;
 
-VirtualMachine::VirtualMachine(void) {
-    /* TASK: Add whatever code you find necessary */
-}
+VirtualMachine::VirtualMachine(void) {}
 
-VirtualMachine::~VirtualMachine(void) {
-    /* TASK: Add whatever code you find necessary */
-}
+VirtualMachine::~VirtualMachine(void) {}
 
 void VirtualMachine::execute(const vector<char>& program) {
-    /* TASK: Implement this method */
+    invoke(program);
 }
 
 bool VirtualMachine::prepareEnvironment(void) {
-    /* TASK: Implement this method */
+    while (!_stack.empty()) _stack.pop();
+    _memory.clear();
+    return true;
 }
 
 bool VirtualMachine::processMagicNumber(int number) {
-    /* TASK: Implement this method */
+    if (number == static_cast<int>(0x1337D00D)) return true;
+
+    stringstream ss;
+    ss << "Invalid magic number 0x" << std::hex << number;
+    Reporter& out = *Reporter::getInstance();
+    out << out.beginError() << ss.str() << out.endl();
+    return false;
 }
 
 bool VirtualMachine::processMemorySize(int value) {
-    /* TASK: Implement this method */
+    // The size comes from the program, which may be corrupt
+    if (value > MAX_MEMORY_SIZE) {
+        stringstream ss;
+        ss << "Memory size " << value << " exceeds the limit of "
+           << MAX_MEMORY_SIZE << " locations";
+        Reporter& out = *Reporter::getInstance();
+        out << out.beginError() << ss.str() << out.endl();
+        return false;
+    }
+    _memory.resize(value < 0 ? 0 : value);
+    return true;
 }
 
 bool VirtualMachine::processInstLOAD(void) {
-    /* TASK: Implement this method */
+    if (!hasOperands(1, "LOAD")) return false;
+    int index = pop();
+    if (!isValidMemoryIndex(index)) return false;
+    _stack.push(_memory[index]);
+    return true;
 }
 
 bool VirtualMachine::processInstSTORE(void) {
-    /* TASK: Implement this method */
+    if (!hasOperands(2, "STORE")) return false;
+    int index = pop();
+    int value = pop();
+    if (!isValidMemoryIndex(index)) return false;
+    _memory[index] = value;
+    return true;
 }
 
 bool VirtualMachine::processInstCONST_1B(char value) {
-    /* TASK: Implement this method */
+    _stack.push(value);
+    return true;
 }
 
 bool VirtualMachine::processInstCONST_2B(short value) {
-    /* TASK: Implement this method */
+    _stack.push(value);
+    return true;
 }
 
 bool VirtualMachine::processInstCONST_4B(int value) {
-    /* TASK: Implement this method */
+    _stack.push(value);
+    return true;
 }
 
 bool VirtualMachine::processInstCONST_0(void) {
-    /* TASK: Implement this method */
+    _stack.push(0);
+    return true;
 }
 
 bool VirtualMachine::processInstCONST_1(void) {
-    /* TASK: Implement this method */
+    _stack.push(1);
+    return true;
 }
 
 bool VirtualMachine::processInstADD(void) {
-    /* TASK: Implement this method */
+    if (!hasOperands(2, "ADD")) return false;
+    int v2 = pop();
+    int v1 = pop();
+    _stack.push(wrap(static_cast<unsigned int>(v1)
+                     + static_cast<unsigned int>(v2)));
+    return true;
 }
 
 bool VirtualMachine::processInstSUB(void) {
-    /* TASK: Implement this method */
+    if (!hasOperands(2, "SUB")) return false;
+    int v2 = pop();
+    int v1 = pop();
+    _stack.push(wrap(static_cast<unsigned int>(v1)
+                     - static_cast<unsigned int>(v2)));
+    return true;
 }
 
 bool VirtualMachine::processInstMUL(void) {
-    /* TASK: Implement this method */
+    if (!hasOperands(2, "MUL")) return false;
+    int v2 = pop();
+    int v1 = pop();
+    _stack.push(wrap(static_cast<unsigned int>(v1)
+                     * static_cast<unsigned int>(v2)));
+    return true;
 }
 
 bool VirtualMachine::processInstDIV(void) {
-    /* TASK: Implement this method */
+    if (!hasOperands(2, "DIV")) return false;
+    int v2 = pop();
+    int v1 = pop();
+    if (v2 == 0) return error("Division by zero");
+
+    // INT_MIN / -1 overflows, which traps on most processors
+    if (v2 == -1) {
+        _stack.push(wrap(0u - static_cast<unsigned int>(v1)));
+    }
+    else {
+        _stack.push(v1 / v2);
+    }
+    return true;
 }
 
 bool VirtualMachine::processInstSWAP(void) {
-    /* TASK: Implement this method */
+    if (!hasOperands(2, "SWAP")) return false;
+    int v1 = pop();
+    int v2 = pop();
+    _stack.push(v1);
+    _stack.push(v2);
+    return true;
 }
 
 bool VirtualMachine::processInstPRINT(void) {
-    /* TASK: Implement this method */
+    if (!hasOperands(1, "PRINT")) return false;
+    Reporter& out = *Reporter::getInstance();
+    out << out.beginInfo() << pop() << out.endl();
+    return true;
 }
 
 bool VirtualMachine::processInstUnknown(char inst) {
-    /* TASK: Implement this method */
+    stringstream ss;
+    ss << "Unknown instruction 0x" << std::hex << (short) (0x00FF & inst);
+    return error(ss.str());
+}
+
+bool VirtualMachine::hasOperands(unsigned int num, const char* inst) {
+    if (_stack.size() >= num) return true;
+
+    stringstream ss;
+    ss << inst << " needs " << num << " value(s) on the stack, found "
+       << _stack.size();
+    return error(ss.str());
+}
+
+bool VirtualMachine::isValidMemoryIndex(int index) {
+    if (index >= 0 && static_cast<unsigned int>(index) < _memory.size()) {
+        return true;
+    }
+
+    stringstream ss;
+    ss << "Memory index " << index << " is out of bounds (memory size is "
+       << _memory.size() << ")";
+    return error(ss.str());
+}
+
+unsigned int VirtualMachine::getStackSize(void) const {
+    return _stack.size();
+}
+
+int VirtualMachine::getStackTop(void) const {
+    return _stack.top();
+}
+
+int VirtualMachine::pop(void) {
+    int value = _stack.top();
+    _stack.pop();
+    return value;
+}
+
+int VirtualMachine::wrap(unsigned int value) {
+    // Converting a value above INT_MAX is implementation-defined, so it is
+    // done explicitly
+    if (value <= static_cast<unsigned int>(INT_MAX)) {
+        return static_cast<int>(value);
+    }
+    return -static_cast<int>(~value) - 1;
+}
+
+bool VirtualMachine::error(const string& message) {
+    Reporter& out = *Reporter::getInstance();
+    out << out.beginError() << message << " (at PC " << getPC() << ")"
+        << out.endl();
+    return false;
 }
 
+const int VirtualMachine::MAX_MEMORY_SIZE = 1 << 26;
@@ -69,7 +69,7 @@ class VirtualMachine : private Decoder {
      * @param program
      *        Program to execute.
      */
-    void execute(const std::vector<char>& program);
+    virtual void execute(const std::vector<char>& program);
 
   protected:
     /**
@@ -94,7 +94,7 @@ class VirtualMachine : private Decoder {
      *
      * @param value
      *        Number of memory locations needed.
-     * @returns Always \c true.
+     * @returns \c false if the number exceeds MAX_MEMORY_SIZE.
      */
     virtual bool processMemorySize(int value);
 
@@ -172,9 +172,90 @@ class VirtualMachine : private Decoder {
      */
     virtual bool processInstUnknown(char inst);
 
+    /**
+     * \copydoc Decoder::getPC(void)
+     */
+    using Decoder::getPC;
+
+    /**
+     * Gets the number of values currently on the stack.
+     *
+     * @returns Stack size.
+     */
+    unsigned int getStackSize(void) const;
+
+    /**
+     * Gets the top-most value on the stack without popping it. The stack must
+     * not be empty.
+     *
+     * @returns Top-most value.
+     */
+    int getStackTop(void) const;
+
+  private:
+    /**
+     * Checks that the stack holds enough operands for an instruction, and
+     * reports an error if it does not.
+     *
+     * @param num
+     *        Number of operands needed.
+     * @param inst
+     *        Name of the instruction (used in the error message).
+     * @returns \c true if there are enough operands.
+     */
+    bool hasOperands(unsigned int num, const char* inst);
+
+    /**
+     * Checks that a memory index is within bounds, and reports an error if it
+     * is not.
+     *
+     * @param index
+     *        Memory index.
+     * @returns \c true if the index is valid.
+     */
+    bool isValidMemoryIndex(int index);
+
+    /**
+     * Pops the top-most value from the stack.
+     *
+     * @returns Popped value.
+     */
+    int pop(void);
+
+    /**
+     * Converts the result of unsigned arithmetic back to a signed value, so
+     * that results which do not fit wrap around in two's complement.
+     *
+     * @param value
+     *        Value.
+     * @returns Signed value with the same bit pattern.
+     */
+    static int wrap(unsigned int value);
+
+    /**
+     * Reports an execution error at the current instruction.
+     *
+     * @param message
+     *        Error message.
+     * @returns Always \c false.
+     */
+    bool error(const std::string& message);
 
   private:
-    /* TASK: Add whatever private members and methods you find necessary */
+    /**
+     * Largest number of memory locations a program may ask for.
+     */
+    static const int MAX_MEMORY_SIZE;
+
+    /**
+     * Operand stack.
+     */
+    std::stack<int, std::vector<int> > _stack;
+
+    /**
+     * Main memory.
+     */
+    std::vector<int> _memory;
 };
 
 #endif